@@ -0,0 +1,8 @@
+"""
+End-to-end benchmarks of foamCD on synthetic OpenFOAM-like code bases
+
+corpus.py generates the code bases, harness.py parses and renders them at
+several scales and writes the measurements as JSON:
+
+    python -m benchmarks.harness --scales small medium --output results.json
+"""
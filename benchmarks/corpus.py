@@ -0,0 +1,292 @@
+#!/usr/bin/env python3
+
+"""
+Generator of synthetic OpenFOAM-like C++ code bases
+
+A corpus is a forest of class hierarchies with a given depth and fan-out,
+one class per header and translation unit, with doc comments, members,
+run-time selection (RTS) macros and class templates in configurable amounts,
+plus a compile_commands.json for it. The same spec and seed always give the
+same files, so measurements at a scale are comparable across commits.
+
+Layout:
+    include/core.H        stand-ins for OpenFOAM's types and macros
+    include/<class>.H     class declarations
+    src/lib<k>/<class>.C  definitions and RTS registration, one library per 50 classes
+"""
+
+import os
+import sys
+import json
+import random
+import argparse
+from dataclasses import dataclass, asdict
+from typing import Any, Dict, List, Optional
+
+CLASSES_PER_LIBRARY = 50
+
+CORE_HEADER = """/**
+ * Stand-ins for the OpenFOAM types and macros generated classes use
+ */
+#ifndef core_H
+#define core_H
+
+namespace Foam
+{
+
+typedef double scalar;
+typedef int label;
+
+class word
+{
+public:
+    word(const char* name) : name_(name) {}
+    const char* c_str() const { return name_; }
+private:
+    const char* name_;
+};
+
+//- Settings a model is constructed from
+class dictionary
+{
+public:
+    scalar get(const word& key) const;
+};
+
+//- Owning pointer returned by selectors
+template<class T>
+class autoPtr
+{
+public:
+    explicit autoPtr(T* ptr = nullptr) : ptr_(ptr) {}
+    T* operator->() const { return ptr_; }
+private:
+    T* ptr_;
+};
+
+} // End namespace Foam
+
+#define TypeName(TypeNameString)                                              \\
+    static const char* typeName_() { return TypeNameString; }                 \\
+    virtual const char* type() const { return typeName_(); }
+
+#define defineTypeNameAndDebug(Type, DebugSwitch)                             \\
+    int Type##DebugSwitch_ = DebugSwitch;
+
+#define declareRunTimeSelectionTable(autoPtr, baseType, argNames, argList, parList) \\
+    typedef autoPtr<baseType> (*argNames##ConstructorPtr)argList;             \\
+    static void add##argNames##Constructor(const char* name, argNames##ConstructorPtr ctor);
+
+#define addToRunTimeSelectionTable(baseType, thisType, argNames)              \\
+    static int add##thisType##argNames##ToTable_ = 0;
+
+#endif
+"""
+
+
+@dataclass
+class CorpusSpec:
+    """Shape of a synthetic code base
+
+    Attributes:
+        files: Number of classes, each with its own header and translation unit
+        depth: Levels of each class hierarchy; more classes start new hierarchies
+        fan_out: Derived classes per class
+        members: Members per class (methods, fields, static and template methods)
+        rts_ratio: Fraction of hierarchies using run-time selection macros
+        template_ratio: Fraction of classes which are class templates; their derived classes are too
+        doc_comments: Whether classes and members have doc comments
+        seed: Seed of the choices above
+    """
+    files: int = 100
+    depth: int = 4
+    fan_out: int = 3
+    members: int = 8
+    rts_ratio: float = 0.5
+    template_ratio: float = 0.1
+    doc_comments: bool = True
+    seed: int = 0
+
+
+@dataclass
+class _Class:
+    name: str
+    parent: Optional[int]
+    hierarchy: int
+    is_template: bool
+    uses_rts: bool
+    library: str
+
+
+def _plan(spec: CorpusSpec) -> List[_Class]:
+    """Classes of the corpus, parents first"""
+    rng = random.Random(spec.seed)
+    tree_size = sum(spec.fan_out ** level for level in range(max(spec.depth, 1)))
+    classes: List[_Class] = []
+    hierarchy_rts: Dict[int, bool] = {}
+    for i in range(spec.files):
+        hierarchy, position = divmod(i, tree_size)
+        parent = hierarchy * tree_size + (position - 1) // spec.fan_out if position else None
+        if hierarchy not in hierarchy_rts:
+            hierarchy_rts[hierarchy] = rng.random() < spec.rts_ratio
+        is_template = rng.random() < spec.template_ratio or (parent is not None and classes[parent].is_template)
+        name = f"base{hierarchy}Model" if parent is None else f"model{i}"
+        classes.append(_Class(name, parent, hierarchy, is_template, hierarchy_rts[hierarchy],
+                              f"lib{i // CLASSES_PER_LIBRARY}"))
+    return classes
+
+
+def _doc(spec: CorpusSpec, text: str, indent: str = "") -> str:
+    return f"{indent}//- {text}\n" if spec.doc_comments else ""
+
+
+def _header(spec: CorpusSpec, cls: _Class, classes: List[_Class]) -> str:
+    parent = classes[cls.parent] if cls.parent is not None else None
+    lines = [f"#ifndef {cls.name}_H", f"#define {cls.name}_H", ""]
+    lines.append(f'#include "{parent.name}.H"' if parent else '#include "core.H"')
+    lines += ["", "namespace Foam", "{", ""]
+    if spec.doc_comments:
+        lines += ["/**", f" * Synthetic model {cls.name}" + (f", derived from {parent.name}" if parent else ""),
+                  " *", " * Generated by benchmarks/corpus.py; the text only has to look like documentation.", " */"]
+    if cls.is_template:
+        lines.append("template<class Type>")
+    base = ""
+    if parent:
+        base = f" : public {parent.name}" + ("<Type>" if parent.is_template else "")
+    lines += [f"class {cls.name}{base}", "{", "public:", ""]
+    if cls.uses_rts:
+        lines.append(f'    TypeName("{cls.name}");')
+        if parent is None:
+            lines += ["", "    declareRunTimeSelectionTable", "    (",
+                      f"        autoPtr, {cls.name}, dictionary,", "        (const dictionary& dict),", "        (dict)", "    );"]
+        lines.append("")
+    lines.append(_doc(spec, "Construct from dictionary", "    ") + f"    explicit {cls.name}(const dictionary& dict);")
+    lines.append(_doc(spec, "Destructor", "    ") + f"    virtual ~{cls.name}();")
+    if parent is None and cls.uses_rts:
+        lines.append(_doc(spec, "Select a model from dictionary", "    ") +
+                     f"    static autoPtr<{cls.name}> New(const dictionary& dict);")
+    lines.append("")
+    fields = []
+    for k in range(spec.members):
+        kind = k % 4
+        if kind == 0:
+            override = " override" if parent else ""
+            lines.append(_doc(spec, f"Value {k} of the model", "    ") +
+                         f"    virtual scalar value{k}() const{override};")
+        elif kind == 1:
+            lines.append(_doc(spec, f"Count of kind {k}", "    ") + f"    static label count{k}();")
+        elif kind == 2:
+            fields.append(_doc(spec, f"Coefficient {k}", "    ") + f"    scalar coeff{k}_;")
+        else:
+            lines.append(_doc(spec, f"Convert with coefficient {k}", "    ") +
+                         f"    template<class T>\n    T convert{k}(const T& value) const {{ return value; }}")
+    if fields:
+        lines += ["", "protected:", ""] + fields
+    lines += ["};", "", "} // End namespace Foam", "", "#endif", ""]
+    return "\n".join(lines)
+
+
+def _source(spec: CorpusSpec, cls: _Class, classes: List[_Class]) -> str:
+    parent = classes[cls.parent] if cls.parent is not None else None
+    lines = [f'#include "{cls.name}.H"', "", "namespace Foam", "{", ""]
+    if cls.is_template:
+        # Members are defined in the class template's instantiation
+        prefix, scope = "template<class Type>\n", f"{cls.name}<Type>"
+    else:
+        prefix, scope = "", cls.name
+    if cls.uses_rts and not cls.is_template:
+        lines.append(f"defineTypeNameAndDebug({cls.name}, 0);")
+        if parent is not None:
+            root = cls
+            while root.parent is not None:
+                root = classes[root.parent]
+            if not root.is_template:
+                lines.append(f"addToRunTimeSelectionTable({root.name}, {cls.name}, dictionary);")
+        lines.append("")
+    parent_ctor = ""
+    if parent:
+        parent_ctor = f"\n:\n    {parent.name}" + ("<Type>" if parent.is_template else "") + "(dict)"
+    lines.append(f"{prefix}{scope}::{cls.name}(const dictionary& dict){parent_ctor}\n{{}}\n")
+    lines.append(f"{prefix}{scope}::~{cls.name}()\n{{}}\n")
+    if parent is None and cls.uses_rts and not cls.is_template:
+        lines.append(f"autoPtr<{cls.name}> {cls.name}::New(const dictionary& dict)\n"
+                     f"{{\n    return autoPtr<{cls.name}>(new {cls.name}(dict));\n}}\n")
+    for k in range(spec.members):
+        if k % 4 == 0:
+            lines.append(f"{prefix}scalar {scope}::value{k}() const\n{{\n    return {k}.0;\n}}\n")
+        elif k % 4 == 1:
+            lines.append(f"{prefix}label {scope}::count{k}()\n{{\n    return {k};\n}}\n")
+    if cls.is_template:
+        lines.append(f"template class {cls.name}<scalar>;\n")
+    lines += ["} // End namespace Foam", ""]
+    return "\n".join(lines)
+
+
+def generate_corpus(spec: CorpusSpec, root: str, compiler: str = "c++") -> Dict[str, Any]:
+    """Write a synthetic code base and its compile_commands.json
+
+    Args:
+        spec: Shape of the code base
+        root: Directory to write it to, created if missing
+        compiler: Compiler named in the compile commands
+
+    Returns:
+        Summary with the source files, class and hierarchy counts
+    """
+    root = os.path.realpath(root)
+    include_dir = os.path.join(root, "include")
+    os.makedirs(include_dir, exist_ok=True)
+    with open(os.path.join(include_dir, "core.H"), 'w') as f:
+        f.write(CORE_HEADER)
+
+    classes = _plan(spec)
+    sources = []
+    commands = []
+    for cls in classes:
+        with open(os.path.join(include_dir, f"{cls.name}.H"), 'w') as f:
+            f.write(_header(spec, cls, classes))
+        library_dir = os.path.join(root, "src", cls.library)
+        os.makedirs(library_dir, exist_ok=True)
+        source = os.path.join(library_dir, f"{cls.name}.C")
+        with open(source, 'w') as f:
+            f.write(_source(spec, cls, classes))
+        sources.append(source)
+        commands.append({
+            'directory': library_dir,
+            'file': source,
+            # TypeName redeclares type() in derived classes without override, as in OpenFOAM
+            'arguments': [compiler, '-std=c++17', '-Wno-inconsistent-missing-override', f'-I{include_dir}',
+                          '-c', source, '-o', f'{cls.name}.o'],
+        })
+    with open(os.path.join(root, "compile_commands.json"), 'w') as f:
+        json.dump(commands, f, indent=1)
+    return {
+        'root': root,
+        'sources': sources,
+        'classes': len(classes),
+        'hierarchies': len({cls.hierarchy for cls in classes}),
+        'derived': sum(1 for cls in classes if cls.parent is not None),
+        'templates': sum(1 for cls in classes if cls.is_template),
+        'spec': asdict(spec),
+    }
+
+
+def main():
+    """Generate a corpus from the command line"""
+    parser = argparse.ArgumentParser(description="Generate a synthetic OpenFOAM-like C++ code base")
+    parser.add_argument("output", help="Directory to write the code base to")
+    for field, default in asdict(CorpusSpec()).items():
+        option = f"--{field.replace('_', '-')}"
+        if isinstance(default, bool):
+            parser.add_argument(option, type=lambda value: value.lower() in ('1', 'true', 'yes'), default=default)
+        else:
+            parser.add_argument(option, type=type(default), default=default)
+    args = parser.parse_args()
+    spec = CorpusSpec(**{field: getattr(args, field) for field in asdict(CorpusSpec())})
+    summary = generate_corpus(spec, args.output)
+    print(f"Wrote {summary['classes']} classes in {summary['hierarchies']} hierarchies to {summary['root']}")
+    return 0
+
+
+if __name__ == '__main__':
+    sys.exit(main())
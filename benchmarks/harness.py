@@ -0,0 +1,209 @@
+#!/usr/bin/env python3
+
+"""
+End-to-end benchmark of foamCD at several corpus scales
+
+For each scale, a synthetic corpus is generated (see corpus.py), parsed from
+its compile_commands.json into a fresh database, resolved, and rendered to
+markdown. Parse throughput, resolution-pass time, database size and render
+time are written as JSON, one record per scale, to compare against earlier
+results of the same scales.
+"""
+
+import os
+import sys
+import json
+import time
+import shutil
+import platform
+import argparse
+import tempfile
+from dataclasses import replace
+from datetime import datetime
+from pathlib import Path
+from typing import Any, Dict, List, Optional
+
+sys.path.append(str(Path(__file__).parent.parent / "src"))
+
+from omegaconf import OmegaConf
+
+from foamcd.logs import setup_logging
+from foamcd.config import Config
+from foamcd.db import EntityDatabase
+from foamcd.version import get_version
+from benchmarks.corpus import CorpusSpec, generate_corpus
+
+logger = setup_logging()
+
+# Named corpus sizes; other corpus parameters keep their CorpusSpec defaults
+SCALES = {
+    'tiny': CorpusSpec(files=10),
+    'small': CorpusSpec(files=50),
+    'medium': CorpusSpec(files=250),
+    'large': CorpusSpec(files=1000),
+    'huge': CorpusSpec(files=5000, depth=5),
+}
+
+
+def _count(db: EntityDatabase, table: str) -> int:
+    db.cursor.execute(f"SELECT COUNT(*) FROM {table}")
+    return db.cursor.fetchone()[0]
+
+
+def run_scale(name: str, spec: CorpusSpec, work_dir: str, jobs: int = 1,
+              plugins: bool = True, markdown: bool = True) -> Dict[str, Any]:
+    """Generate, parse, resolve and render one corpus
+
+    Args:
+        name: Scale name, recorded with the results
+        spec: Shape of the corpus
+        work_dir: Directory for the corpus, database and markdown output
+        jobs: Parse lanes, as foamcd-parse --jobs
+        plugins: Whether DSL plugins (OpenFOAM RTS detection, ...) run
+        markdown: Whether to measure markdown rendering too
+
+    Returns:
+        Measurements of the scale
+    """
+    from foamcd.parse import ClangParser, get_source_files_from_compilation_database
+    from foamcd.scheduler import schedule_translation_units
+
+    corpus_dir = os.path.join(work_dir, "corpus")
+    started = time.monotonic()
+    corpus = generate_corpus(spec, corpus_dir)
+    generate_seconds = time.monotonic() - started
+
+    config = Config()
+    OmegaConf.update(config.config, "parser.compile_commands_dir", corpus['root'])
+    OmegaConf.update(config.config, "parser.include_paths", [])
+    OmegaConf.update(config.config, "parser.jobs", jobs)
+    OmegaConf.update(config.config, "markdown.output_path", os.path.join(work_dir, "markdown"))
+    OmegaConf.update(config.config, "markdown.project_name", f"benchmark-{name}")
+    config_path = os.path.join(work_dir, "config.yaml")
+    config.save(config_path)
+
+    db_path = os.path.join(work_dir, "docs.db")
+    db = EntityDatabase(db_path)
+    parser = ClangParser(corpus['root'], db=db, config=config, disable_plugins=not plugins)
+    files = get_source_files_from_compilation_database(corpus['root'])
+
+    started = time.monotonic()
+    schedule = schedule_translation_units(files, db.get_tu_history(), jobs)
+    parsed, errors, _ = parser.parse_lanes(schedule.lanes)
+    parse_seconds = time.monotonic() - started
+
+    started = time.monotonic()
+    parser.resolve_scoped_template_functions()
+    parser.resolve_inheritance_relationships()
+    parser.resolve_enclosing_relationships()
+    resolve_seconds = time.monotonic() - started
+
+    entities = _count(db, 'entities')
+    inheritance = _count(db, 'inheritance')
+    db.close()
+    if not parser.disable_plugins:
+        parser.plugin_manager.shutdown()
+
+    result = {
+        'scale': name,
+        'corpus': {key: value for key, value in corpus.items() if key not in ('root', 'sources')},
+        'generate_seconds': round(generate_seconds, 3),
+        'parse': {
+            'seconds': round(parse_seconds, 3),
+            'files': len(files),
+            'parsed': parsed,
+            'errors': errors,
+            'files_per_second': round(len(files) / parse_seconds, 3) if parse_seconds else None,
+            'entities_per_second': round(entities / parse_seconds, 1) if parse_seconds else None,
+        },
+        'resolve_seconds': round(resolve_seconds, 3),
+        'database': {
+            'bytes': os.path.getsize(db_path),
+            'entities': entities,
+            'inheritance': inheritance,
+        },
+    }
+
+    if markdown:
+        from foamcd.markdown import MarkdownGenerator
+        output_path = os.path.join(work_dir, "markdown")
+        started = time.monotonic()
+        MarkdownGenerator(db_path, output_path, corpus['root'], config_path).generate_all()
+        render_seconds = time.monotonic() - started
+        pages = len([name for name in os.listdir(output_path) if name.endswith('.md')])
+        result['markdown'] = {
+            'seconds': round(render_seconds, 3),
+            'pages': pages,
+            'pages_per_second': round(pages / render_seconds, 3) if render_seconds else None,
+        }
+    logger.info(f"Scale {name}: {len(files)} files parsed in {parse_seconds:.2f}s, "
+                f"resolved in {resolve_seconds:.2f}s, {result['database']['bytes']} bytes of database")
+    return result
+
+
+def run_benchmarks(scales: List[str], jobs: int = 1, plugins: bool = True, markdown: bool = True,
+                   seed: int = 0, work_dir: Optional[str] = None) -> Dict[str, Any]:
+    """Run the benchmark at each named scale
+
+    Args:
+        scales: Names of SCALES entries
+        jobs: Parse lanes
+        plugins: Whether DSL plugins run
+        markdown: Whether to measure markdown rendering
+        seed: Corpus seed, the same for all scales
+        work_dir: Where to keep the corpora and databases; a removed temporary directory if None
+
+    Returns:
+        Report with the environment and the results of each scale
+    """
+    report = {
+        'foamcd_version': get_version(),
+        'python': platform.python_version(),
+        'platform': platform.platform(),
+        'timestamp': datetime.now().isoformat(timespec='seconds'),
+        'jobs': jobs,
+        'plugins': plugins,
+        'results': [],
+    }
+    base_dir = work_dir or tempfile.mkdtemp(prefix='foamcd-bench-')
+    try:
+        for name in scales:
+            scale_dir = os.path.join(base_dir, name)
+            if os.path.exists(scale_dir):
+                shutil.rmtree(scale_dir)
+            os.makedirs(scale_dir)
+            spec = replace(SCALES[name], seed=seed)
+            report['results'].append(run_scale(name, spec, scale_dir, jobs, plugins, markdown))
+    finally:
+        if not work_dir:
+            shutil.rmtree(base_dir, ignore_errors=True)
+    return report
+
+
+def main():
+    """Main entry point for running the benchmarks"""
+    parser = argparse.ArgumentParser(description="Benchmark foamCD on synthetic OpenFOAM-like code bases")
+    parser.add_argument("--scales", nargs="+", default=['tiny', 'small', 'medium'], choices=sorted(SCALES),
+                        help="Corpus scales to run")
+    parser.add_argument("--output", "-o", type=str, help="JSON file for the results, printed if not given")
+    parser.add_argument("--jobs", "-j", type=int, default=1, help="Parse lanes, as foamcd-parse --jobs")
+    parser.add_argument("--seed", type=int, default=0, help="Corpus seed")
+    parser.add_argument("--no-plugins", action="store_true", help="Do not run DSL plugins")
+    parser.add_argument("--no-markdown", action="store_true", help="Do not measure markdown rendering")
+    parser.add_argument("--work-dir", type=str, help="Keep corpora and databases in this directory")
+    args = parser.parse_args()
+
+    report = run_benchmarks(args.scales, args.jobs, not args.no_plugins, not args.no_markdown,
+                            args.seed, args.work_dir)
+    text = json.dumps(report, indent=2)
+    if args.output:
+        with open(args.output, 'w') as f:
+            f.write(text + "\n")
+        logger.info(f"Wrote benchmark results to {args.output}")
+    else:
+        print(text)
+    return 0
+
+
+if __name__ == '__main__':
+    sys.exit(main())
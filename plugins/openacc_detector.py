@@ -21,13 +21,12 @@ class OpenACCDetector(FeatureDetector):
         }
     }
     
+    required_tokens = ['#pragma acc']
+    
     def __init__(self):
         super().__init__("openacc", "DSL", "OpenACC GPU programming directives")
     
     def detect(self, cursor, token_spellings, token_str, available_cursor_kinds):
-        if '#pragma acc' not in token_str:
-            return False
-            
         construct_type = None
         gang_workers = None
         vector_length = None
@@ -73,6 +73,18 @@ class OpenFOAMDetector(FeatureDetector):
         }
     }
     
+    # Interest filters: only class-like cursors mentioning an OpenFOAM
+    # type-registration macro reach detect()
+    cursor_kinds = [CursorKind.CLASS_DECL, CursorKind.STRUCT_DECL, CursorKind.CLASS_TEMPLATE]
+    required_tokens = [
+        'declareRunTimeSelectionTable',
+        'TypeName',
+        'ClassName',
+        'addToRunTimeSelectionTable'
+    ]
+    # Macro calls are looked up in the translation unit's macro index
+    macros = required_tokens + ['defineTypeNameAndDebug']
+    
     def __init__(self):
         super().__init__("openfoam", "DSL", "OpenFOAM Framework Features")
     
@@ -80,20 +92,12 @@ class OpenFOAMDetector(FeatureDetector):
         """
         Detect OpenFOAM macros in class declarations, focusing on RTS mechanism
         """
-        if cursor.kind not in [CursorKind.CLASS_DECL, CursorKind.STRUCT_DECL, CursorKind.CLASS_TEMPLATE]:
-            return False
-        openfoam_keywords = [
-            'declareRunTimeSelectionTable',
-            'TypeName',
-            'ClassName',
-            'addToRunTimeSelectionTable'
-        ]
-        
-        if not any(keyword in token_str for keyword in openfoam_keywords):
-            return False
-            
-        is_base_class = 'declareRunTimeSelectionTable' in token_str
-        is_derived_class = 'addToRunTimeSelectionTable' in token_str
+        calls = {}
+        for call in self.macro_invocations(cursor, token_spellings):
+            if call.args is not None:
+                calls.setdefault(call.name, []).append(call.args)
+        is_base_class = 'declareRunTimeSelectionTable' in calls
+        is_derived_class = 'addToRunTimeSelectionTable' in calls
         if is_base_class:
             rts_components = {
                 'declareRunTimeSelectionTable': False,  # Must have this declaration
@@ -110,25 +114,16 @@ class OpenFOAMDetector(FeatureDetector):
             'openfoam_rts_missing': []
         }
         rts_tables = []
-        # TODO: VERY scary regular expression. Maybe opt for tree-sitter here?
-        rts_pattern = r'declareRunTimeSelectionTable\s*\(\s*([^,]+),\s*([^,]+),\s*([^,)\s]+)\s*(?:,\s*\(([^)]*)\))?\s*(?:,\s*\(([^)]*)\))?\s*\)'
-        if is_base_class and 'declareRunTimeSelectionTable' in rts_components:
-            rts_components['declareRunTimeSelectionTable'] = 'declareRunTimeSelectionTable' in token_str
-        
-        for match in re.finditer(rts_pattern, token_str):
+        for args in calls.get('declareRunTimeSelectionTable', []):
+            if len(args) < 3:
+                continue
             rts_components['declareRunTimeSelectionTable'] = True
-            pointer_type = match.group(1).strip()
-            class_name = match.group(2).strip()
-            rts_name = match.group(3).strip()
-            ctor_decl_params = match.group(4).strip() if match.group(4) else ""
-            ctor_params = match.group(5).strip() if match.group(5) else ""
-            
             rts_tables.append({
-                "pointer_type": pointer_type,
-                "class_name": class_name,
-                "rts_name": rts_name,
-                "ctor_decl_params": ctor_decl_params,
-                "ctor_params": ctor_params
+                "pointer_type": args[0].strip(),
+                "class_name": args[1].strip(),
+                "rts_name": args[2].strip(),
+                "ctor_decl_params": self._unparenthesize(args[3]) if len(args) > 3 else "",
+                "ctor_params": self._unparenthesize(args[4]) if len(args) > 4 else ""
             })
         
         if rts_tables:
@@ -141,41 +136,27 @@ class OpenFOAMDetector(FeatureDetector):
             })
             fields['openfoam_rts_status'] = 'partial'
             
-        typename_pattern = r'TypeName\s*\(\s*"([^"]*)"\s*\)'
-        classname_pattern = r'ClassName\s*\(\s*"([^"]*)"\s*\)'
-        typename_match = re.search(typename_pattern, token_str)
-        classname_match = re.search(classname_pattern, token_str)
-        
-        if typename_match or classname_match:
+        type_name = self._string_argument(calls, 'TypeName') or self._string_argument(calls, 'ClassName')
+        if type_name is not None:
             rts_components['typeName'] = True
-            type_name = (typename_match.group(1) if typename_match else 
-                         classname_match.group(1) if classname_match else None)
             if type_name:
                 fields['openfoam_type_name'] = type_name
         
-        type_debug_pattern = r'defineTypeNameAndDebug\s*\(\s*([^,]+),\s*(\d+)\s*\)'
-        type_debug_match = re.search(type_debug_pattern, token_str)
-        if type_debug_match:
-            class_name = type_debug_match.group(1).strip()
-            debug_flag = int(type_debug_match.group(2))
+        for args in calls.get('defineTypeNameAndDebug', []):
+            if len(args) != 2 or not args[1].strip().isdigit():
+                continue
             if 'openfoam_type_name' not in fields:
-                fields['openfoam_type_name'] = class_name
-            fields['openfoam_debug_flag'] = debug_flag
-        
-        # TODO: Another scary regular expression, should really parse properly
-        add_pattern = r'addToRunTimeSelectionTable\s*\(\s*([^,]+),\s*([^,]+),\s*([^,)]+)'
-        add_match = re.search(add_pattern, token_str)
+                fields['openfoam_type_name'] = args[0].strip()
+            fields['openfoam_debug_flag'] = int(args[1])
+            break
         
-        if add_match:
+        add_calls = [args for args in calls.get('addToRunTimeSelectionTable', []) if len(args) >= 3]
+        if add_calls:
             if 'addToRunTimeSelectionTable' in rts_components:
                 rts_components['addToRunTimeSelectionTable'] = True
-            parent_class = add_match.group(1).strip()
-            class_name = add_match.group(2).strip()
-            registration_name = add_match.group(3).strip()
-            
             fields.update({
-                'openfoam_parent_class': parent_class,
-                'openfoam_registration_name': registration_name
+                'openfoam_parent_class': add_calls[0][0].strip(),
+                'openfoam_registration_name': add_calls[0][2].strip()
             })
         
         missing_components = [comp for comp, present in rts_components.items() if not present]
@@ -205,3 +186,19 @@ class OpenFOAMDetector(FeatureDetector):
             }
             
         return False
+
+    @staticmethod
+    def _unparenthesize(arg):
+        """Parameter list of an RTS macro argument without its enclosing parentheses"""
+        arg = arg.strip()
+        if arg.startswith('(') and arg.endswith(')'):
+            arg = arg[1:-1]
+        return arg.strip()
+
+    @staticmethod
+    def _string_argument(calls, macro):
+        """Unquoted string literal passed to the first call of a macro, None if there is none"""
+        for args in calls.get(macro, []):
+            if len(args) == 1 and len(args[0]) >= 2 and args[0][0] == args[0][-1] == '"':
+                return args[0][1:-1]
+        return None
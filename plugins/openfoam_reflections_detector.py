@@ -17,11 +17,12 @@ cost of doing this (besides including files and loading libraries obviously)
 """
 
 import os
-try:
-    import cppyy
-    CPPYY_AVAILABLE = True
-except ImportError:
-    CPPYY_AVAILABLE = False
+import hashlib
+import importlib.util
+# cppyy is imported lazily, so merely loading this plugin (e.g. in a parser
+# that runs it out-of-process) does not bring cling into the process
+CPPYY_AVAILABLE = importlib.util.find_spec("cppyy") is not None
+cppyy = None
 from clang.cindex import CursorKind
 from foamcd.feature_detectors import FeatureDetector
 from foamcd.logs import setup_logging
@@ -66,30 +67,44 @@ class OpenFOAMReflectionsDetector(FeatureDetector):
         }
     }
     
+    # Interest filters: only classes/structs using the reflection DSL reach detect()
+    # TODO: complex handling of templates; as we need concrete types 
+    #       to test for concept
+    cursor_kinds = [CursorKind.CLASS_DECL, CursorKind.STRUCT_DECL]
+    required_tokens = [
+        'declareSchemaTable',
+        'uiElement',
+        'withDefault',
+        'withDescription',
+        'withMin',
+        'withMax'
+    ]
+    
+    # Reflection results depend on more than the class tokens; the plugin
+    # keeps its own cache keyed by header content instead
+    cacheable = False
+    
     def __init__(self):
         super().__init__("openfoam_reflections", "DSL", "OpenFOAM Reflection Features")
+        # Per-class results keyed by (class name, header content hash)
+        self._results = {}
+        # Classes collected during the traversal, waiting for the batched JIT compile
+        self._pending = {}
+        self._header_hashes = {}
+        # cppyy/cling state that only needs to be set up once per process
+        self._include_paths = set()
+        self._macro_defs = set()
+        self._included_headers = set()
+        self._runtime_ready = False
+        self._batch_count = 0
         
     def detect(self, cursor, token_spellings, token_str, available_cursor_kinds):
         """
         Detect OpenFOAM reflection patterns in class declarations
+
+        The actual reflection is deferred: classes are collected here and their
+        schemas are instantiated in one JIT compile by `resolve_deferred`.
         """
-        # TODO: complex handling of templates; as we need concrete types 
-        #       to test for concept
-        if cursor.kind not in [CursorKind.CLASS_DECL, CursorKind.STRUCT_DECL]:
-            return False
-            
-        # Check for reflection-related patterns
-        reflection_patterns = [
-            'declareSchemaTable',
-            'uiElement',
-            'withDefault',
-            'withDescription',
-            'withMin',
-            'withMax'
-        ]
-        
-        if not any(pattern in token_str for pattern in reflection_patterns):
-            return False
         short_class_name = cursor.spelling
         if not short_class_name:
             return False
@@ -111,14 +126,18 @@ class OpenFOAMReflectionsDetector(FeatureDetector):
         if not file_path:
             return False
             
-        fields = {
-            'is_reflectable': False,
-            'reflection_type': 'SchemaTable',
-            'standard_config': '',
-            'standard_config_details': '',
-            'reflection_error': ''
-        }
+        fields = self._default_fields()
         
+        key = (class_name, self._header_hash(file_path))
+        if key in self._results:
+            return self._results[key]
+
+        # Cursor snapshots of out-of-process runs carry their compile arguments
+        compile_args = getattr(cursor, 'compile_args', None)
+        if compile_args is not None:
+            self._pending[key] = (file_path, compile_args)
+            return {'detected': False, 'fields': fields, 'deferred': key}
+
         from foamcd.parse import CURRENT_PARSER
         parser = CURRENT_PARSER
         
@@ -126,102 +145,196 @@ class OpenFOAMReflectionsDetector(FeatureDetector):
             logger.error("No parser picked up by the openfoam_reflections detector, cannot function...")
             return {'detected': False, 'fields': fields}
 
-        # Here is the magical bit
         try:
             compile_args = parser.get_compile_commands(file_path) if hasattr(parser, 'get_compile_commands') else []
-            is_reflectable, config, details = self._extract_reflection_config(class_name, file_path, compile_args)
-            if is_reflectable:
-                fields['is_reflectable'] = True
-                fields['standard_config'] = config
-                fields['standard_config_details'] = details
-                logger.info(f"Successfully extracted reflection configuration for {class_name}")
         except Exception as e:
-            logger.error(f"Error extracting reflection config: {e}")
+            logger.error(f"Error getting compile arguments for {file_path}: {e}")
             fields['reflection_error'] = str(e)
-            
+            return {'detected': False, 'fields': fields}
+        self._pending[key] = (file_path, compile_args)
+        return {'detected': False, 'fields': fields, 'deferred': key}
+
+    def resolve_deferred(self, keys):
+        """
+        Reflect all classes collected during a translation unit in a single JIT compile
+        """
+        batch = [key for key in keys if key not in self._results and key in self._pending]
+        if batch:
+            try:
+                extracted = self._extract_reflection_configs(
+                    [(key[0], *self._pending[key]) for key in batch]
+                )
+            except Exception as e:
+                logger.error(f"Error extracting reflection config: {e}")
+                extracted = {}
+                for key in batch:
+                    fields = self._default_fields()
+                    fields['reflection_error'] = str(e)
+                    self._results[key] = {'detected': False, 'fields': fields}
+            for key in batch:
+                self._pending.pop(key, None)
+                if key in self._results:
+                    continue
+                fields = self._default_fields()
+                is_reflectable, config, details = extracted.get(key[0], (False, None, None))
+                if is_reflectable:
+                    fields['is_reflectable'] = True
+                    fields['standard_config'] = config
+                    fields['standard_config_details'] = details
+                    logger.info(f"Successfully extracted reflection configuration for {key[0]}")
+                self._results[key] = {'detected': fields['is_reflectable'], 'fields': fields}
+        return {key: self._results[key] for key in keys if key in self._results}
+
+    def _default_fields(self):
         return {
-            'detected': fields["is_reflectable"],
-            'fields': fields
+            'is_reflectable': False,
+            'reflection_type': 'SchemaTable',
+            'standard_config': '',
+            'standard_config_details': '',
+            'reflection_error': ''
         }
-        
-    def _extract_reflection_config(self, class_name, file_path, compile_args):
+
+    def _header_hash(self, file_path):
+        """Content hash of the header declaring a class, computed once per run"""
+        if file_path not in self._header_hashes:
+            try:
+                with open(file_path, 'rb') as f:
+                    self._header_hashes[file_path] = hashlib.sha256(f.read()).hexdigest()
+            except OSError:
+                self._header_hashes[file_path] = None
+        return self._header_hashes[file_path]
+
+    def _prepare_runtime(self, compile_args):
         """
-        Use cppyy to compile and run reflection code to extract standard configuration
-        
-        Args:
-            class_name: Name of the class to reflect
-            file_path: Path to the source file
-            compile_args: Compilation arguments from the parser
-            
-        Returns:
-            True Boolean if class_name is reflectable type, False otherwise
-            Extracted standard configuration as string or None if extraction failed
-            Details on standard configuration as string or None if extraction failed
+        Set up cling for the given compilation arguments; include paths, macros
+        and the runtime library are only handed to cppyy the first time they are seen
         """
-        try:
-            if not CPPYY_AVAILABLE:
-                logger.error("cppyy module not available for JIT compilation")
-                return False, None, None
-            
-            standard = [arg[5:] for arg in compile_args if arg.startswith('-std=')]
-            if len(standard) > 0:
-                standard = standard[-1]
-            else:
-                standard = "c++20"
-            os.environ["CLING_STANDARD"] = standard
-            include_paths = [arg[2:] for arg in compile_args if arg.startswith('-I')]
-            macro_defs = [arg[2:] for arg in compile_args if arg.startswith('-D')]
-
-            for include_path in include_paths:
+        standard = [arg[5:] for arg in compile_args if arg.startswith('-std=')]
+        if len(standard) > 0:
+            standard = standard[-1]
+        else:
+            standard = "c++20"
+        os.environ["CLING_STANDARD"] = standard
+
+        for include_path in [arg[2:] for arg in compile_args if arg.startswith('-I')]:
+            if include_path not in self._include_paths:
                 cppyy.add_include_path(include_path)
-            
+                self._include_paths.add(include_path)
+
+        if not self._runtime_ready:
             # TODO: maybe work towards metigating the need for libOpenFOAM.so
             cppyy.add_library_path(os.environ["FOAM_LIBBIN"])
             cppyy.load_library("libOpenFOAM.so")
 
-            for macro_def in macro_defs:
-                try:
-                    if '=' in macro_def:
-                        name, value = macro_def.split('=', 1)
-                        cppyy.cppdef(f"#define {name} {value}")
-                    else:
-                        cppyy.cppdef(f"#define {macro_def}")
-                except Exception as e:
-                    logger.warning(f"Failed to add macro definition {macro_def}: {e}")
-            
+        for macro_def in [arg[2:] for arg in compile_args if arg.startswith('-D')]:
+            if macro_def in self._macro_defs:
+                continue
+            self._macro_defs.add(macro_def)
             try:
-                cppyy.include("dictionary.H")
-                cppyy.include("OStringStream.H")
-                cppyy.include(file_path)
-                cppyy.include("reflectConcepts.H")
+                if '=' in macro_def:
+                    name, value = macro_def.split('=', 1)
+                    cppyy.cppdef(f"#define {name} {value}")
+                else:
+                    cppyy.cppdef(f"#define {macro_def}")
             except Exception as e:
-                logger.error(f"Failed to include necessary headers: {e}")
-                return False, None, None
-            
+                logger.warning(f"Failed to add macro definition {macro_def}: {e}")
+
+        if not self._runtime_ready:
+            cppyy.include("dictionary.H")
+            cppyy.include("OStringStream.H")
+            cppyy.include("reflectConcepts.H")
             # The business end of things:
-            cppyy.cppdef(f"""
+            cppyy.cppdef("""
             #ifndef __GET_REFLECTION_DICT__
             #define __GET_REFLECTION_DICT__
             template<class T, bool C>
-            std::string getReflectionDict() {{
+            std::string getReflectionDict() {
                 Foam::OStringStream oss;
                 oss << Foam::Reflect::reflect<T, C>::schema(Foam::dictionary::null);
                 return oss.str();
-            }}
+            }
             #endif
             """)
+            self._runtime_ready = True
 
-            try:
-                standard_config = cppyy.gbl.getReflectionDict[class_name, "true"]()
-                standard_config = standard_config.decode("utf-8").replace('\\"', '').replace('\\\n',' ').strip()
-                standard_config_details = cppyy.gbl.getReflectionDict[class_name, "false"]()
-                standard_config_details = standard_config_details.decode("utf-8").replace('\\"', '').replace('\\\n',' ').strip()
-                logger.debug(f"{class_name} seems to support reflection. fetched standard configuration")
-                return True, standard_config, standard_config_details
-                
-            except Exception as e:
-                logger.debug(f"{class_name} seems to not support reflection. We just bail out: {e}")
-                return False, None, None
+    @staticmethod
+    def _clean_output(output):
+        return output.decode("utf-8").replace('\\"', '').replace('\\\n',' ').strip()
+
+    def _extract_reflection_configs(self, classes):
+        """
+        Use cppyy to compile and run reflection code for a batch of classes
+        
+        All schemas are instantiated by a single generated translation unit; if it
+        does not compile (because some class is not reflectable), the classes of the
+        batch are reflected one by one instead.
+
+        Args:
+            classes: List of (class name, declaring file, compile args) tuples
+            
+        Returns:
+            Dictionary mapping class names to (is reflectable, standard configuration,
+            configuration details) tuples
+        """
+        global cppyy
+        results = {}
+        if not CPPYY_AVAILABLE:
+            logger.error("cppyy module not available for JIT compilation")
+            return results
+        if cppyy is None:
+            import cppyy
+
+        try:
+            for _, file_path, compile_args in classes:
+                self._prepare_runtime(compile_args)
+                if file_path not in self._included_headers:
+                    cppyy.include(file_path)
+                    self._included_headers.add(file_path)
+        except Exception as e:
+            logger.error(f"Failed to include necessary headers: {e}")
+            return results
+
+        class_names = list(dict.fromkeys(class_name for class_name, _, _ in classes))
+        self._batch_count += 1
+        batch_ns = f"foamcdReflections{self._batch_count}"
+        accessors = "\n".join(
+            f"std::string config{i}() {{ return getReflectionDict<{name}, true>(); }}\n"
+            f"std::string details{i}() {{ return getReflectionDict<{name}, false>(); }}"
+            for i, name in enumerate(class_names)
+        )
+        try:
+            cppyy.cppdef(f"namespace {batch_ns} {{\n{accessors}\n}}")
+            batch = getattr(cppyy.gbl, batch_ns)
+            for i, class_name in enumerate(class_names):
+                config = self._clean_output(getattr(batch, f"config{i}")())
+                details = self._clean_output(getattr(batch, f"details{i}")())
+                results[class_name] = (True, config, details)
+            logger.debug(f"Reflected {len(class_names)} classes in a single JIT compile")
+            return results
+        except Exception as e:
+            logger.debug(f"Batched reflection of {len(class_names)} classes failed, reflecting them one by one: {e}")
+
+        for class_name in class_names:
+            results[class_name] = self._extract_reflection_config(class_name)
+        return results
+
+    def _extract_reflection_config(self, class_name):
+        """
+        Run reflection code for a single class; the runtime must already be prepared
+        
+        Args:
+            class_name: Name of the class to reflect
+            
+        Returns:
+            True Boolean if class_name is reflectable type, False otherwise
+            Extracted standard configuration as string or None if extraction failed
+            Details on standard configuration as string or None if extraction failed
+        """
+        try:
+            standard_config = self._clean_output(cppyy.gbl.getReflectionDict[class_name, "true"]())
+            standard_config_details = self._clean_output(cppyy.gbl.getReflectionDict[class_name, "false"]())
+            logger.debug(f"{class_name} seems to support reflection. fetched standard configuration")
+            return True, standard_config, standard_config_details
         except Exception as e:
-            logger.error(f"Something went wrong with checking reflectability. We just bail out {e}")
+            logger.debug(f"{class_name} seems to not support reflection. We just bail out: {e}")
             return False, None, None
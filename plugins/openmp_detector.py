@@ -26,14 +26,13 @@ class OpenMPDetector(FeatureDetector):
         }
     }
     
+    # Only cursors carrying an OpenMP pragma reach detect()
+    required_tokens = ['#pragma omp']
+    
     def __init__(self):
         super().__init__("openmp", "DSL", "OpenMP parallel programming directives")
     
     def detect(self, cursor, token_spellings, token_str, available_cursor_kinds):
-        # Quick check for OpenMP pragmas
-        if '#pragma omp' not in token_str:
-            return False
-            
         # Extract more detailed info
         parallelism_type = None
         num_threads = None
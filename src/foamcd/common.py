@@ -3,3 +3,4 @@
 CPP_HEADER_EXTENSIONS = ['.hpp', '.hxx', '.h++', '.hh', '.H']
 CPP_IMPLEM_EXTENSIONS = ['.cpp', '.cxx', '.c++', '.cc', '.C']
 CPP_FILE_EXTENSIONS = [*CPP_HEADER_EXTENSIONS, *CPP_IMPLEM_EXTENSIONS]
+MODULE_INTERFACE_EXTENSIONS = ['.cppm', '.ixx', '.mpp', '.ccm', '.cxxm', '.c++m']
@@ -80,7 +80,21 @@ DEFAULT_CONFIG = {
     },
     "database": {
         "path": "docs.db",      # SQLite database path
-        "create_tables": True   # Whether to create tables if they don't exist
+        "create_tables": True,  # Whether to create tables if they don't exist
+        "profile": False,       # Time SQL statements per call site and report them at exit, as --sql-profile
+    },
+    "metrics": {
+        "export_dir": None,       # Directory for foamcd_<command>.prom (OpenMetrics) and .json, written after each run
+        "memory": {               # Memory accounting per phase, stored in the run_metrics table
+            "enabled": False,     # Record RSS and Python allocations (tracemalloc) of each phase; slows runs down
+            "frames": 1,          # Call-stack depth kept per allocation, more groups retaining sites by traceback
+            "top": 10,            # Heaviest files and retaining call sites listed in the run summary
+        },
+    },
+    "watch": {
+        "debounce_ms": 200,     # Quiet time after a change before updating, so that saves of several files batch
+        "inotify": True,        # Use inotify where available, else poll modification times
+        "poll_interval": 1.0,   # Seconds between modification time scans when polling
     },
     "parser": {
         "libclang_path": None,        # Path to libclang library if not in standard locations
@@ -99,10 +113,47 @@ DEFAULT_CONFIG = {
             "__.*",
             ".*__",
         ],
+        "detector_cache": True,       # Cache detector results per entity token fingerprint in the database
+        "dependency_dbs": [],         # Prebuilt databases of dependencies, as {path, prefixes}; headers under
+                                      # the prefixes are not traversed, references into them resolve to the database
+        "parse_cache": {              # ccache-style cache of parse results, keyed by content, args and included headers
+            "dir": None,              # Cache directory, may be on storage shared by machines using the same source paths
+        },
+        "jobs": 1,                    # Processes parsing translation units concurrently, scheduled by recorded parse cost
+        "tu_budget": {                # Per-file libclang parse budget, 0 means unlimited
+            "timeout": 0,             # Wall-clock seconds a translation unit may take to parse
+            "memory_limit_mb": 0,     # Address space cap of the parsing worker, in MB
+        },
+        "modules": {                  # C++20 named modules of the compilation database
+            "enabled": True,          # Prebuild module interfaces once, for the files importing them
+            "compiler": None,         # clang++ building the module interfaces, looked up on PATH if None
+            "cache_dir": None,        # Where built interfaces are kept, .foamcd-modules next to the database if None
+        },
+        "compile_commands": {         # Files with several compile commands (build variants, shared sources)
+            "select": "first",        # Command parsed: 'first' or 'last' in compile_commands.json, or 'most_flags'
+            "prefer": [],             # Flags (e.g. -DWM_DP) whose commands win over the select policy
+        },
+        "tu_options": {               # libclang parse options, recorded per file in the files table
+            "adaptive": True,         # Only request the detailed processing record for files using plugin macros
+            "function_bodies": True,  # Parse function bodies; body-level features (lambdas, range-for, ...) need them
+        },
         "plugins": {
             "enabled": True,          # Whether to enable the plugin system
             "disabled_plugins": [],    # List of plugin names to disable
-            "only_plugins": []         # Whitelist of plugin names to enable (if empty, all non-disabled plugins are enabled)
+            "only_plugins": [],        # Whitelist of plugin names to enable (if empty, all non-disabled plugins are enabled)
+            "out_of_process": [],      # Plugins to run in a pool of helper processes, fed cursor snapshots
+            "host_processes": 2,       # Number of helper processes for out-of-process plugins
+            "budgets": {               # Time budgets per plugin, 0 means unlimited
+                "per_call_ms": 0,      # Longest a single detect() call may take
+                "per_run_s": 0,        # Cumulative time a plugin may spend in a run before it is disabled
+                "action": "disable",   # What to do with a plugin overrunning a call: 'disable' or 'sample'
+                "sample_every": 10,    # Sampled plugins only run on every n-th cursor
+            },
+            "cost_ceiling": {          # Benchmarked cost ceilings, checked when plugins are loaded
+                "table": None,         # Cost table written by foamcd-bench-detectors --output
+                "p99_us": 0,           # Plugins over this p99 time per call are not loaded, 0 means no ceiling
+                "per_detector": {},    # Ceilings of specific plugins, in us, overriding p99_us
+            },
         },
         # The rest of parser parameters are deduced from compile_commands.json file if supplied
         "cpp_standard": "c++20",      # C++ standard version to use, optional
@@ -151,9 +202,9 @@ class Config:
             Configuration value or default
         """
         try:
-            if OmegaConf.select(self.config, key):
-                return OmegaConf.select(self.config, key)
-            return default
+            value = OmegaConf.select(self.config, key)
+            # Explicit false/0 settings are values too
+            return default if value is None else value
         except Exception:
             return default
     
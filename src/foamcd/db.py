@@ -2,13 +2,36 @@
 
 import os
 import sqlite3
-from typing import List, Dict, Any, Optional
+from contextlib import contextmanager
+from typing import List, Dict, Any, Optional, Tuple
 
 from .logs import setup_logging
 from .common import CPP_IMPLEM_EXTENSIONS, CPP_HEADER_EXTENSIONS
+from .sql_profile import profiler
 
 logger = setup_logging()
 
+class AtomicConnection(sqlite3.Connection):
+    """SQLite connection able to hold back commits while a block of writes is in progress
+    
+    See EntityDatabase.atomic; outside of such blocks it behaves like a plain connection.
+    """
+    
+    def __init__(self, *args, **kwargs):
+        super().__init__(*args, **kwargs)
+        self.atomic_depth = 0
+        self.atomic_failed = False
+    
+    def commit(self):
+        if not self.atomic_depth:
+            super().commit()
+    
+    def rollback(self):
+        # A failed write inside an atomic block voids the whole block
+        if self.atomic_depth:
+            self.atomic_failed = True
+        super().rollback()
+
 class EntityDatabase:
     """SQLite database for storing C++ entities and their relationships"""
     
@@ -22,6 +45,9 @@ class EntityDatabase:
         self.db_path = db_path
         self.conn = None
         self.cursor = None
+        # Attached dependency databases, as (schema name, path); see attach_dependencies
+        self.dependency_schemas = []
+        self._dependency_classes = None
         db_dir = os.path.dirname(db_path)
         if db_dir and not os.path.exists(db_dir):
             os.makedirs(db_dir)
@@ -39,10 +65,11 @@ class EntityDatabase:
                 self.db_path = os.path.abspath(self.db_path)
                 logger.info(f"Normalized database path from {orig_path} to {self.db_path}")
             db_exists = os.path.exists(self.db_path)
-            self.conn = sqlite3.connect(self.db_path)
+            # Parse lanes of a run write to the same database from separate processes
+            self.conn = sqlite3.connect(self.db_path, timeout=60, factory=AtomicConnection)
             self.conn.execute("PRAGMA foreign_keys = ON")
             self.conn.row_factory = sqlite3.Row
-            self.cursor = self.conn.cursor()
+            self.cursor = profiler.wrap(self.conn.cursor())
             if db_exists:
                 self.cursor.execute("SELECT count(*) FROM sqlite_master WHERE type='table'")
                 table_count = self.cursor.fetchone()[0]
@@ -75,6 +102,38 @@ class EntityDatabase:
         """Commit the current transaction to the database"""
         self.conn.commit()
     
+    @contextmanager
+    def atomic(self):
+        """Make the writes of a block persist all together, or not at all
+        
+        Commits issued by the store methods are held back until the block ends.
+        If the block raises, or any write in it had to be rolled back, every write
+        of the block is discarded; the latter raises sqlite3.Error. Nested blocks
+        join the outermost one.
+        """
+        conn = self.conn
+        if conn.atomic_depth:
+            conn.atomic_depth += 1
+            try:
+                yield
+            finally:
+                conn.atomic_depth -= 1
+            return
+        conn.commit()
+        conn.atomic_failed = False
+        conn.atomic_depth = 1
+        try:
+            yield
+        except BaseException:
+            conn.atomic_depth = 0
+            conn.rollback()
+            raise
+        conn.atomic_depth = 0
+        if conn.atomic_failed:
+            conn.rollback()
+            raise sqlite3.Error("A write failed, all writes of the atomic block were rolled back")
+        conn.commit()
+    
     def _create_tables(self):
         """Create database tables if they don't exist"""
         try:
@@ -100,6 +159,7 @@ class EntityDatabase:
                 is_external_reference INTEGER,
                 is_deprecated INTEGER DEFAULT 0,
                 deprecated_message TEXT,
+                is_skeleton INTEGER DEFAULT 0,  -- low-fidelity entity from a quick tree-sitter pass
                 FOREIGN KEY (parent_uuid) REFERENCES entities (uuid) ON DELETE CASCADE
             )
             ''')
@@ -109,6 +169,11 @@ class EntityDatabase:
             CREATE INDEX IF NOT EXISTS idx_entities_parent_uuid ON entities (parent_uuid)
             ''')
             
+            # Columns added after the entities table was introduced
+            self._add_missing_columns('entities', {
+                'is_skeleton': 'INTEGER DEFAULT 0'
+            })
+            
             # Features table
             self.cursor.execute('''
             CREATE TABLE IF NOT EXISTS features (
@@ -353,7 +418,121 @@ class EntityDatabase:
             CREATE TABLE IF NOT EXISTS files (
                 path TEXT PRIMARY KEY,
                 last_modified INTEGER,
-                hash TEXT
+                hash TEXT,
+                tu_options INTEGER
+            )
+            ''')
+            self._add_missing_columns('files', {
+                'tu_options': 'INTEGER'
+            })
+            
+            # Detector results keyed by a fingerprint of the entity's token slice,
+            # so unchanged entities skip feature detection across runs
+            self.cursor.execute('''
+            CREATE TABLE IF NOT EXISTS detector_cache (
+                fingerprint TEXT NOT NULL,
+                detector TEXT NOT NULL,
+                version TEXT NOT NULL,
+                result TEXT NOT NULL,  -- JSON-encoded detection result
+                PRIMARY KEY (fingerprint, detector, version)
+            )
+            ''')
+            
+            # Per-run detector timings, and detectors skipped by their circuit breaker
+            self.cursor.execute('''
+            CREATE TABLE IF NOT EXISTS detector_run_stats (
+                run_started TEXT NOT NULL,
+                detector TEXT NOT NULL,
+                calls INTEGER DEFAULT 0,
+                skipped INTEGER DEFAULT 0,  -- cursors the detector was not run on after tripping
+                timeouts INTEGER DEFAULT 0,
+                errors INTEGER DEFAULT 0,
+                total_time REAL DEFAULT 0,
+                max_call_time REAL DEFAULT 0,
+                state TEXT,                 -- 'active', 'sampled' or 'disabled'
+                reason TEXT,
+                PRIMARY KEY (run_started, detector)
+            )
+            ''')
+            
+            # Parse cost of each translation unit and which route it took; under a
+            # parse budget, files over budget skip libclang until their hash changes.
+            # Peak RSS of the supervised worker; for files parsed in the parser's own process,
+            # the RSS their parse added while its translation unit was loaded
+            self.cursor.execute('''
+            CREATE TABLE IF NOT EXISTS tu_stats (
+                path TEXT PRIMARY KEY,
+                hash TEXT,
+                duration REAL,
+                peak_rss_kb INTEGER,
+                status TEXT,  -- 'ok', 'error', 'timeout', 'memory' or 'crashed'
+                route TEXT,   -- 'libclang', 'tree-sitter' or 'skipped'
+                parsed_at TEXT
+            )
+            ''')
+            
+            # Memory taken by each phase of a parse or markdown run, recorded with --memory;
+            # rows of phase 'retained' are the call sites holding Python memory at the end
+            self.cursor.execute('''
+            CREATE TABLE IF NOT EXISTS run_metrics (
+                run_started TEXT NOT NULL,
+                command TEXT NOT NULL,     -- 'parse' or 'markdown'
+                phase TEXT NOT NULL,
+                subject TEXT,              -- file, page or call site
+                pid INTEGER,
+                seconds REAL,
+                rss_kb INTEGER,
+                rss_delta_kb INTEGER,
+                peak_rss_kb INTEGER,
+                peak_rss_growth_kb INTEGER,
+                py_delta_kb INTEGER,       -- Python heap left allocated by the phase
+                py_peak_kb INTEGER         -- Python heap peak above the start of the phase
+            )
+            ''')
+            self.cursor.execute('CREATE INDEX IF NOT EXISTS idx_run_metrics_run ON run_metrics(run_started, command)')
+            
+            # Parse runs, so that an interrupted run can be resumed; the journal lists
+            # the run's files in parse order, each committed with its entities
+            self.cursor.execute('''
+            CREATE TABLE IF NOT EXISTS runs (
+                run_id INTEGER PRIMARY KEY AUTOINCREMENT,
+                started TEXT,
+                finished TEXT,
+                status TEXT  -- 'parsing', 'resolving' or 'complete'
+            )
+            ''')
+            self.cursor.execute('''
+            CREATE TABLE IF NOT EXISTS run_journal (
+                run_id INTEGER NOT NULL,
+                position INTEGER NOT NULL,
+                path TEXT NOT NULL,
+                status TEXT DEFAULT 'pending',  -- 'pending', 'done' or 'failed'
+                completed_at TEXT,
+                PRIMARY KEY (run_id, path),
+                FOREIGN KEY (run_id) REFERENCES runs (run_id) ON DELETE CASCADE
+            )
+            ''')
+            
+            # Module declarations and imports found by the lexical scan of each source
+            # file, reused while its modification time and size do not change
+            self.cursor.execute('''
+            CREATE TABLE IF NOT EXISTS module_scans (
+                path TEXT PRIMARY KEY,
+                mtime_ns INTEGER,
+                size INTEGER,
+                module TEXT,
+                is_interface BOOLEAN,
+                imports TEXT  -- JSON list of module names
+            )
+            ''')
+            
+            # Project headers each translation unit included when last parsed,
+            # used to schedule translation units sharing headers together
+            self.cursor.execute('''
+            CREATE TABLE IF NOT EXISTS tu_includes (
+                path TEXT NOT NULL,
+                include_path TEXT NOT NULL,
+                PRIMARY KEY (path, include_path)
             )
             ''')
             
@@ -363,6 +542,20 @@ class EntityDatabase:
             logger.error(f"Error creating database tables: {e}")
             raise
     
+    def _add_missing_columns(self, table: str, columns: Dict[str, str]):
+        """Add columns missing from a table created by an older version
+        
+        Args:
+            table: Table name
+            columns: Dictionary mapping column names to their SQL declarations
+        """
+        self.cursor.execute(f"PRAGMA table_info({table})")
+        existing = {row[1] for row in self.cursor.fetchall()}
+        for column, declaration in columns.items():
+            if column not in existing:
+                self.cursor.execute(f"ALTER TABLE {table} ADD COLUMN {column} {declaration}")
+                logger.info(f"Added column {column} to table {table}")
+    
     def close(self):
         """Close the database connection"""
         if self.conn:
@@ -512,6 +705,8 @@ class EntityDatabase:
             
             for base_class in base_classes:
                 base_uuid = base_class.get('uuid', None)
+                if base_uuid and self.dependency_schemas:
+                    self.import_dependency_entity(base_uuid)
                 self.cursor.execute('''
                 INSERT INTO inheritance (class_uuid, class_name, base_uuid, base_name, access_level, is_virtual)
                 VALUES (?, ?, ?, ?, ?, ?)
@@ -929,15 +1124,20 @@ class EntityDatabase:
                 deprecated_message = parsed_doc.get('deprecated')
                 logger.debug(f"Found deprecation message in parsed_doc: {deprecated_message}")
             namespace = entity.get('namespace', None)
-            self.cursor.execute('''
-            INSERT OR REPLACE INTO entities 
+            is_skeleton = 1 if entity.get('is_skeleton') else 0
+            is_external_reference = 1 if entity.get('is_external_reference') else 0
+            # Placeholders of external entities are shared by all files referencing them;
+            # replacing one would cascade to the rows referencing it
+            conflict = 'IGNORE' if is_external_reference else 'REPLACE'
+            self.cursor.execute(f'''
+            INSERT OR {conflict} INTO entities 
             (uuid, name, kind, namespace, file, line, end_line, column, end_column, parent_uuid, 
              doc_comment, access, type_info, full_signature, is_abstract, linkage, is_external_reference,
-             is_deprecated, deprecated_message)
-            VALUES (?, ?, ?, ?, ?, ?, ?, ?, ?, ?, ?, ?, ?, ?, ?, ?, ?, ?, ?)
+             is_deprecated, deprecated_message, is_skeleton)
+            VALUES (?, ?, ?, ?, ?, ?, ?, ?, ?, ?, ?, ?, ?, ?, ?, ?, ?, ?, ?, ?)
             ''', (uuid, name, kind, namespace, file_path, line, end_line, column, end_column, parent_uuid, 
-                  doc_comment, access_level, type_info, full_signature, 0, None, 0,
-                  is_deprecated, deprecated_message))
+                  doc_comment, access_level, type_info, full_signature, 0, None, is_external_reference,
+                  is_deprecated, deprecated_message, is_skeleton))
             
             # Store method classification if present
             method_info = entity.get('method_info', {})
@@ -1375,6 +1575,30 @@ class EntityDatabase:
             self.conn.rollback()
             raise
     
+    def set_file_tu_options(self, file_path: str, tu_options: int):
+        """Record the libclang parse options a tracked file was parsed with
+        
+        Args:
+            file_path: Path to the file
+            tu_options: Bitmask of TranslationUnit parse options
+        """
+        try:
+            self.cursor.execute('UPDATE files SET tu_options = ? WHERE path = ?', (tu_options, file_path))
+            self.conn.commit()
+        except sqlite3.Error as e:
+            logger.error(f"Error recording parse options of {file_path}: {e}")
+            self.conn.rollback()
+    
+    def get_file_tu_options(self, file_path: str) -> Optional[int]:
+        """Get the libclang parse options a tracked file was last parsed with"""
+        try:
+            self.cursor.execute('SELECT tu_options FROM files WHERE path = ?', (file_path,))
+            row = self.cursor.fetchone()
+            return row[0] if row else None
+        except sqlite3.Error as e:
+            logger.error(f"Error getting parse options of {file_path}: {e}")
+            return None
+    
     def file_changed(self, file_path: str, last_modified: int, file_hash: str) -> bool:
         """Check if a file has changed since last tracking.
         TODO: Maybe git-based filtering of touched files in commit?
@@ -1402,6 +1626,488 @@ class EntityDatabase:
             logger.error(f"Error checking file changes for {file_path}: {e}")
             raise
     
+    def get_detector_results(self, fingerprint: str) -> Dict[str, List[tuple]]:
+        """Get cached detector results for an entity token fingerprint
+        
+        Args:
+            fingerprint: Fingerprint of the entity's token slice
+            
+        Returns:
+            Dictionary mapping detector names to lists of (version, JSON result) tuples
+        """
+        try:
+            self.cursor.execute('''
+            SELECT detector, version, result FROM detector_cache WHERE fingerprint = ?
+            ''', (fingerprint,))
+            results = {}
+            for row in self.cursor.fetchall():
+                results.setdefault(row[0], []).append((row[1], row[2]))
+            return results
+        except sqlite3.Error as e:
+            logger.error(f"Error getting cached detector results: {e}")
+            return {}
+    
+    def store_detector_results(self, rows: List[tuple]):
+        """Store detector results in the detector cache
+        
+        Args:
+            rows: List of (fingerprint, detector, version, JSON result) tuples
+        """
+        if not rows:
+            return
+        try:
+            self.cursor.executemany('''
+            INSERT OR REPLACE INTO detector_cache (fingerprint, detector, version, result)
+            VALUES (?, ?, ?, ?)
+            ''', rows)
+            self.conn.commit()
+        except sqlite3.Error as e:
+            logger.error(f"Error storing detector results: {e}")
+            self.conn.rollback()
+    
+    def store_detector_run_stats(self, run_started: str, stats: Dict[str, Dict[str, Any]]):
+        """Store timing and circuit breaker state of detectors for a run
+        
+        Args:
+            run_started: ISO timestamp identifying the run
+            stats: Dictionary mapping detector names to their statistics
+        """
+        try:
+            self.cursor.executemany('''
+            INSERT OR REPLACE INTO detector_run_stats
+            (run_started, detector, calls, skipped, timeouts, errors, total_time, max_call_time, state, reason)
+            VALUES (?, ?, ?, ?, ?, ?, ?, ?, ?, ?)
+            ''', [(
+                run_started, name, s['calls'], s['skipped'], s['timeouts'], s['errors'],
+                s['total_time'], s['max_call_time'], s['state'], s['reason']
+            ) for name, s in stats.items()])
+            self.conn.commit()
+        except sqlite3.Error as e:
+            logger.error(f"Error storing detector run statistics: {e}")
+            self.conn.rollback()
+    
+    def get_tu_stats(self, path: str) -> Optional[Dict[str, Any]]:
+        """Parse cost and route recorded for a translation unit
+        
+        Args:
+            path: Path to the translation unit
+            
+        Returns:
+            Dictionary with the tu_stats columns, or None if not recorded
+        """
+        try:
+            self.cursor.execute('SELECT * FROM tu_stats WHERE path = ?', (path,))
+            row = self.cursor.fetchone()
+            return dict(row) if row else None
+        except sqlite3.Error as e:
+            logger.error(f"Error getting parse stats of {path}: {e}")
+            return None
+    
+    def store_tu_stats(self, path: str, file_hash: str, duration: float, peak_rss_kb: Optional[int],
+                       status: str, route: str):
+        """Record the parse cost and route of a translation unit
+        
+        Args:
+            path: Path to the translation unit
+            file_hash: Hash of the file content when parsed
+            duration: Wall-clock parse time in seconds
+            peak_rss_kb: Peak resident set size of the parsing worker, in KB; for files parsed
+                         in-process, the RSS their parse added, as their high-water mark is shared
+                         with every earlier file
+            status: Outcome of the libclang parse
+            route: Parser which produced the file's entities
+        """
+        try:
+            self.cursor.execute('''
+            INSERT OR REPLACE INTO tu_stats (path, hash, duration, peak_rss_kb, status, route, parsed_at)
+            VALUES (?, ?, ?, ?, ?, ?, datetime('now'))
+            ''', (path, file_hash, duration, peak_rss_kb, status, route))
+            self.conn.commit()
+        except sqlite3.Error as e:
+            logger.error(f"Error storing parse stats of {path}: {e}")
+            self.conn.rollback()
+    
+    def store_run_metrics(self, run_started: str, command: str, records: List[Dict[str, Any]],
+                          sites: Optional[List[Dict[str, Any]]] = None):
+        """Store the memory records of a run, replacing those stored for it before
+        
+        Args:
+            run_started: ISO timestamp identifying the run
+            command: Which run, 'parse' or 'markdown'
+            records: Per-phase records, see MemoryAccounting
+            sites: Retaining call sites as {site, size_kb, count}
+        """
+        columns = ('phase', 'subject', 'pid', 'seconds', 'rss_kb', 'rss_delta_kb', 'peak_rss_kb',
+                   'peak_rss_growth_kb', 'py_delta_kb', 'py_peak_kb')
+        rows = [(run_started, command) + tuple(record.get(column) for column in columns) for record in records]
+        rows += [(run_started, command, 'retained', site['site'], None, None, None, None, None, None,
+                  site['size_kb'], None) for site in sites or []]
+        try:
+            self.cursor.execute('DELETE FROM run_metrics WHERE run_started = ? AND command = ?',
+                                (run_started, command))
+            self.cursor.executemany(f'''
+            INSERT INTO run_metrics (run_started, command, {', '.join(columns)})
+            VALUES ({', '.join('?' * (len(columns) + 2))})
+            ''', rows)
+            self.conn.commit()
+        except sqlite3.Error as e:
+            logger.error(f"Error storing run metrics: {e}")
+            self.conn.rollback()
+    
+    def get_run_metrics(self, run_started: Optional[str] = None, command: Optional[str] = None) -> List[Dict[str, Any]]:
+        """Memory records of a run, of the latest one if not given
+        
+        Args:
+            run_started: ISO timestamp identifying the run
+            command: Only records of this command
+            
+        Returns:
+            List of run_metrics rows as dictionaries
+        """
+        try:
+            if run_started is None:
+                self.cursor.execute('SELECT MAX(run_started) FROM run_metrics')
+                run_started = self.cursor.fetchone()[0]
+                if run_started is None:
+                    return []
+            query = 'SELECT * FROM run_metrics WHERE run_started = ?'
+            params: List[Any] = [run_started]
+            if command:
+                query += ' AND command = ?'
+                params.append(command)
+            self.cursor.execute(query, params)
+            return [dict(row) for row in self.cursor.fetchall()]
+        except sqlite3.Error as e:
+            logger.error(f"Error getting run metrics: {e}")
+            return []
+    
+    def store_tu_includes(self, path: str, includes: List[str]):
+        """Replace the recorded include set of a translation unit
+        
+        Args:
+            path: Path to the translation unit
+            includes: Paths of the headers it includes
+        """
+        try:
+            self.cursor.execute('DELETE FROM tu_includes WHERE path = ?', (path,))
+            self.cursor.executemany('INSERT OR IGNORE INTO tu_includes (path, include_path) VALUES (?, ?)',
+                                    [(path, include) for include in includes])
+            self.conn.commit()
+        except sqlite3.Error as e:
+            logger.error(f"Error storing includes of {path}: {e}")
+            self.conn.rollback()
+    
+    def get_module_scans(self) -> Dict[str, Tuple[Tuple[int, int], Tuple[Optional[str], bool, List[str]]]]:
+        """Module scan results of earlier runs, see ModuleCache.scan
+        
+        Returns:
+            Dictionary mapping paths to ((mtime_ns, size), (module, is_interface, imports))
+        """
+        import json
+        try:
+            self.cursor.execute('SELECT * FROM module_scans')
+            return {row['path']: ((row['mtime_ns'], row['size']),
+                                  (row['module'], bool(row['is_interface']), json.loads(row['imports'])))
+                    for row in self.cursor.fetchall()}
+        except sqlite3.Error as e:
+            logger.error(f"Error getting module scans: {e}")
+            return {}
+    
+    def store_module_scans(self, scans: Dict[str, Tuple[Tuple[int, int], Tuple[Optional[str], bool, List[str]]]]):
+        """Record module scan results, as returned by get_module_scans"""
+        import json
+        try:
+            self.cursor.executemany('''
+            INSERT OR REPLACE INTO module_scans (path, mtime_ns, size, module, is_interface, imports)
+            VALUES (?, ?, ?, ?, ?, ?)
+            ''', [(path, mtime_ns, size, module, is_interface, json.dumps(imports))
+                  for path, ((mtime_ns, size), (module, is_interface, imports)) in scans.items()])
+            self.conn.commit()
+        except sqlite3.Error as e:
+            logger.error(f"Error storing module scans: {e}")
+            self.conn.rollback()
+    
+    def get_tu_history(self) -> Dict[str, Dict[str, Any]]:
+        """Parse cost and include sets recorded for all translation units
+        
+        Returns:
+            Dictionary mapping paths to their tu_stats columns plus an 'includes' set
+        """
+        history = {}
+        try:
+            self.cursor.execute('SELECT * FROM tu_stats')
+            for row in self.cursor.fetchall():
+                history[row['path']] = dict(row) | {'includes': set()}
+            self.cursor.execute('SELECT path, include_path FROM tu_includes')
+            for path, include in self.cursor.fetchall():
+                history.setdefault(path, {'path': path, 'duration': None, 'includes': set()})['includes'].add(include)
+        except sqlite3.Error as e:
+            logger.error(f"Error getting parse history: {e}")
+        return history
+    
+    def begin_run(self, started: str, paths: List[str]) -> Optional[int]:
+        """Open the journal of a parse run
+        
+        Args:
+            started: ISO timestamp identifying the run
+            paths: Files the run is going to parse, in parse order
+            
+        Returns:
+            Identifier of the run, or None if it could not be recorded
+        """
+        try:
+            self.cursor.execute("INSERT INTO runs (started, status) VALUES (?, 'parsing')", (started,))
+            run_id = self.cursor.lastrowid
+            self.cursor.executemany('INSERT OR IGNORE INTO run_journal (run_id, position, path) VALUES (?, ?, ?)',
+                                    [(run_id, position, path) for position, path in enumerate(paths)])
+            self.conn.commit()
+            return run_id
+        except sqlite3.Error as e:
+            logger.error(f"Error recording the start of run {started}: {e}")
+            self.conn.rollback()
+            return None
+    
+    def journal_tu(self, run_id: int, path: str, status: str):
+        """Mark a file of a run as parsed ('done') or as failed
+        
+        Inside an atomic block, the mark is committed together with the file's entities.
+        """
+        try:
+            self.cursor.execute('''
+            UPDATE run_journal SET status = ?, completed_at = datetime('now') WHERE run_id = ? AND path = ?
+            ''', (status, run_id, path))
+            self.conn.commit()
+        except sqlite3.Error as e:
+            logger.error(f"Error journaling {path} for run {run_id}: {e}")
+            self.conn.rollback()
+    
+    def set_run_status(self, run_id: int, status: str):
+        """Move a run to its next stage; 'complete' also records when it finished"""
+        try:
+            self.cursor.execute('''
+            UPDATE runs SET status = ?, finished = CASE WHEN ? = 'complete' THEN datetime('now') END
+            WHERE run_id = ?
+            ''', (status, status, run_id))
+            self.conn.commit()
+        except sqlite3.Error as e:
+            logger.error(f"Error updating the status of run {run_id}: {e}")
+            self.conn.rollback()
+    
+    def get_interrupted_run(self) -> Optional[Dict[str, Any]]:
+        """The latest run, if it did not complete
+        
+        Returns:
+            Dictionary with the runs columns plus 'pending', the files left to
+            parse in parse order; None if the latest run completed
+        """
+        try:
+            self.cursor.execute('SELECT * FROM runs ORDER BY run_id DESC LIMIT 1')
+            row = self.cursor.fetchone()
+            if not row or row['status'] == 'complete':
+                return None
+            run = dict(row)
+            self.cursor.execute('''
+            SELECT path FROM run_journal WHERE run_id = ? AND status = 'pending' ORDER BY position
+            ''', (run['run_id'],))
+            run['pending'] = [r[0] for r in self.cursor.fetchall()]
+            return run
+        except sqlite3.Error as e:
+            logger.error(f"Error looking up interrupted runs: {e}")
+            return None
+    
+    # Bookkeeping of the run which wrote a database; never copied by merge_database
+    UNMERGED_TABLES = {'runs', 'run_journal', 'sqlite_sequence', 'base_child_links'}
+    
+    def merge_database(self, path: str) -> Dict[str, int]:
+        """Copy the rows of another foamCD database, e.g. one shard of a run, into this one
+        
+        Rows already present are kept, so merge_shards merges into an empty database.
+        Feature ids are remapped by feature name and member type aliases are matched
+        by class and name; base-child links are left to rebuild_base_child_links,
+        once all inheritance is resolved.
+        
+        Args:
+            path: Path to the database to merge in
+            
+        Returns:
+            Dictionary mapping table names to the number of rows added
+        """
+        added = {}
+        self.conn.commit()
+        # Rows are copied table by table, parents not necessarily first
+        self.cursor.execute("PRAGMA foreign_keys = OFF")
+        self.cursor.execute("ATTACH DATABASE ? AS shard", (path,))
+        try:
+            self.cursor.execute("SELECT name FROM shard.sqlite_master WHERE type = 'table'")
+            shard_tables = {row[0] for row in self.cursor.fetchall()}
+            self.cursor.execute("SELECT name FROM main.sqlite_master WHERE type = 'table'")
+            tables = [row[0] for row in self.cursor.fetchall()
+                      if row[0] in shard_tables and row[0] not in self.UNMERGED_TABLES]
+            for table in tables:
+                before = self.conn.total_changes
+                if table == 'features':
+                    self.cursor.execute("INSERT OR IGNORE INTO main.features (name) SELECT name FROM shard.features")
+                elif table == 'entity_features':
+                    self.cursor.execute('''
+                    INSERT OR IGNORE INTO main.entity_features (entity_uuid, feature_id)
+                    SELECT ef.entity_uuid, f.id FROM shard.entity_features ef
+                    JOIN shard.features sf ON sf.id = ef.feature_id
+                    JOIN main.features f ON f.name = sf.name
+                    ''')
+                elif table == 'detector_run_stats':
+                    # Shards of one job usually start in the same second, so their statistics are added up
+                    self.cursor.execute('''
+                    INSERT INTO main.detector_run_stats (run_started, detector, calls, skipped, timeouts, errors,
+                                                         total_time, max_call_time, state, reason)
+                    SELECT run_started, detector, calls, skipped, timeouts, errors,
+                           total_time, max_call_time, state, reason
+                    FROM shard.detector_run_stats WHERE true
+                    ON CONFLICT (run_started, detector) DO UPDATE SET
+                        calls = calls + excluded.calls,
+                        skipped = skipped + excluded.skipped,
+                        timeouts = timeouts + excluded.timeouts,
+                        errors = errors + excluded.errors,
+                        total_time = total_time + excluded.total_time,
+                        max_call_time = MAX(max_call_time, excluded.max_call_time),
+                        state = CASE WHEN 'disabled' IN (state, excluded.state) THEN 'disabled'
+                                     WHEN 'sampled' IN (state, excluded.state) THEN 'sampled'
+                                     ELSE state END,
+                        reason = COALESCE(reason, excluded.reason)
+                    ''')
+                elif table == 'class_member_types':
+                    column_list = ", ".join(c for c in self._table_columns('shard', table) if c != 'id')
+                    self.cursor.execute(f'''
+                    INSERT INTO main.class_member_types ({column_list})
+                    SELECT {column_list} FROM shard.class_member_types s
+                    WHERE NOT EXISTS (SELECT 1 FROM main.class_member_types m
+                                      WHERE m.class_uuid = s.class_uuid AND m.name = s.name)
+                    ''')
+                else:
+                    shard_columns = set(self._table_columns('shard', table))
+                    column_list = ", ".join(c for c in self._table_columns('main', table) if c in shard_columns)
+                    self.cursor.execute(f"INSERT OR IGNORE INTO main.{table} ({column_list}) "
+                                        f"SELECT {column_list} FROM shard.{table}")
+                added[table] = self.conn.total_changes - before
+            self.conn.commit()
+        except sqlite3.Error as e:
+            logger.error(f"Error merging database {path}: {e}")
+            self.conn.rollback()
+            raise
+        finally:
+            self.cursor.execute("DETACH DATABASE shard")
+            self.cursor.execute("PRAGMA foreign_keys = ON")
+        return added
+    
+    # Kinds of entities which base classes resolve to
+    CLASS_KINDS = ('CLASS_DECL', 'CLASS_TEMPLATE', 'STRUCT_DECL', 'STRUCT_TEMPLATE',
+                   'CLASS_TEMPLATE_PARTIAL_SPECIALIZATION')
+    
+    def attach_dependencies(self, paths: List[str]):
+        """Attach prebuilt databases of dependencies, to resolve references into their entities
+        
+        Dependency databases are only read from; entities referenced from this
+        database are copied over by import_dependency_entity.
+        
+        Args:
+            paths: Paths to foamCD databases of dependencies, in lookup order
+        """
+        for path in paths:
+            path = os.path.abspath(path)
+            if any(attached == path for _, attached in self.dependency_schemas):
+                continue
+            if not os.path.exists(path):
+                logger.warning(f"Dependency database {path} does not exist, ignoring it")
+                continue
+            schema = f"dependency{len(self.dependency_schemas)}"
+            try:
+                self.conn.commit()
+                self.cursor.execute(f"ATTACH DATABASE ? AS {schema}", (path,))
+                self.dependency_schemas.append((schema, path))
+                logger.info(f"Attached dependency database {path}")
+            except sqlite3.Error as e:
+                logger.error(f"Error attaching dependency database {path}: {e}")
+        self._dependency_classes = None
+    
+    def find_dependency_class(self, name: str, namespace: Optional[str] = None) -> Optional[str]:
+        """UUID of a class of an attached dependency, by its qualified name
+        
+        Args:
+            name: Class name, without template arguments
+            namespace: Enclosing namespaces, as 'ns1::ns2', None for the global one
+            
+        Returns:
+            UUID of the class definition in the first dependency declaring it, or None
+        """
+        if not self.dependency_schemas:
+            return None
+        if self._dependency_classes is None:
+            # Built once per connection; definitions span more lines than forward declarations
+            classes = {}
+            kinds = ", ".join(f"'{kind}'" for kind in self.CLASS_KINDS)
+            for schema, path in self.dependency_schemas:
+                try:
+                    self.cursor.execute(f'''
+                    SELECT uuid, name, namespace FROM {schema}.entities
+                    WHERE kind IN ({kinds}) AND NOT COALESCE(is_external_reference, 0)
+                    ORDER BY end_line - line DESC
+                    ''')
+                    for uuid, class_name, class_namespace in self.cursor.fetchall():
+                        classes.setdefault((class_namespace or None, class_name), uuid)
+                except sqlite3.Error as e:
+                    logger.error(f"Error indexing classes of dependency database {path}: {e}")
+            self._dependency_classes = classes
+        return self._dependency_classes.get((namespace or None, name))
+    
+    def import_dependency_entity(self, uuid: str) -> bool:
+        """Copy an entity of an attached dependency, with its enclosing entities, as external references
+        
+        Args:
+            uuid: UUID of the entity in a dependency database
+            
+        Returns:
+            True if the entity is in this database now
+        """
+        if not self.dependency_schemas or not uuid:
+            return False
+        self.cursor.execute("SELECT 1 FROM main.entities WHERE uuid = ?", (uuid,))
+        if self.cursor.fetchone():
+            return True
+        for schema, path in self.dependency_schemas:
+            try:
+                dependency_columns = set(self._table_columns(schema, 'entities'))
+                columns = [c for c in self._table_columns('main', 'entities') if c in dependency_columns]
+                values = ", ".join('1' if c == 'is_external_reference' else c for c in columns)
+                before = self.conn.total_changes
+                self.cursor.execute(f'''
+                WITH RECURSIVE chain(uuid) AS (
+                    SELECT ?
+                    UNION SELECT e.parent_uuid FROM {schema}.entities e JOIN chain ON e.uuid = chain.uuid
+                    WHERE e.parent_uuid IS NOT NULL
+                )
+                INSERT OR IGNORE INTO main.entities ({", ".join(columns)})
+                SELECT {values} FROM {schema}.entities WHERE uuid IN (SELECT uuid FROM chain)
+                ''', (uuid,))
+                if self.conn.total_changes > before:
+                    self.conn.commit()
+                    return True
+            except sqlite3.Error as e:
+                logger.error(f"Error importing entity {uuid} from dependency database {path}: {e}")
+        return False
+    
+    def _table_columns(self, schema: str, table: str) -> List[str]:
+        self.cursor.execute(f"PRAGMA {schema}.table_info({table})")
+        return [row[1] for row in self.cursor.fetchall()]
+    
+    def rebuild_base_child_links(self):
+        """Recompute all direct and recursive base-child links from the inheritance table"""
+        try:
+            self.cursor.execute("DELETE FROM base_child_links")
+            self._populate_base_child_links()
+            self.conn.commit()
+        except sqlite3.Error as e:
+            logger.error(f"Error rebuilding base-child links: {e}")
+            self.conn.rollback()
+    
     def get_all_entities(self) -> List[Dict[str, Any]]:
         """Get all top-level entities (no parent)
         
@@ -1442,6 +2148,116 @@ class EntityDatabase:
             self.conn.rollback()
             raise
     
+    def untrack_file(self, file_path: str):
+        """Forget the recorded state of a file, so that its next parse does not reuse its entities
+        
+        Args:
+            file_path: Path to the file
+        """
+        try:
+            self.cursor.execute('DELETE FROM files WHERE path = ?', (file_path,))
+            self.conn.commit()
+        except sqlite3.Error as e:
+            logger.error(f"Error untracking file {file_path}: {e}")
+            self.conn.rollback()
+    
+    def forget_file(self, file_path: str):
+        """Remove a translation unit from the database: its entities, recorded state, parse cost and includes
+        
+        Args:
+            file_path: Path to the file, as it was parsed
+        """
+        realpath = os.path.realpath(file_path)
+        try:
+            with self.atomic():
+                self.clear_file_entities(file_path)
+                self.cursor.execute('DELETE FROM files WHERE path = ?', (file_path,))
+                self.cursor.execute('DELETE FROM tu_stats WHERE path = ?', (realpath,))
+                self.cursor.execute('DELETE FROM tu_includes WHERE path = ?', (realpath,))
+        except sqlite3.Error as e:
+            logger.error(f"Error forgetting file {file_path}: {e}")
+            raise
+    
+    def get_entity_uuids_in_files(self, file_paths: List[str], kinds: List[str]) -> List[str]:
+        """UUIDs of the entities of some kinds declared in any of the given files
+        
+        Args:
+            file_paths: Paths of the files
+            kinds: Entity kinds to match
+        """
+        if not file_paths or not kinds:
+            return []
+        try:
+            self.cursor.execute(f'''
+            SELECT uuid FROM entities
+            WHERE file IN ({', '.join('?' * len(file_paths))}) AND kind IN ({', '.join('?' * len(kinds))})
+            ''', list(file_paths) + list(kinds))
+            return [row[0] for row in self.cursor.fetchall()]
+        except sqlite3.Error as e:
+            logger.error(f"Error getting entities of {len(file_paths)} files: {e}")
+            return []
+    
+    def get_derived_class_uuids(self, base_uuids: List[str]) -> List[str]:
+        """UUIDs of all classes deriving from the given ones, directly or not
+        
+        Args:
+            base_uuids: UUIDs of the base classes
+        """
+        if not base_uuids:
+            return []
+        try:
+            self.cursor.execute(f'''
+            WITH RECURSIVE derived(uuid) AS (
+                SELECT child_uuid FROM base_child_links
+                WHERE base_uuid IN ({', '.join('?' * len(base_uuids))})
+                UNION
+                SELECT l.child_uuid FROM base_child_links l JOIN derived d ON l.base_uuid = d.uuid
+            )
+            SELECT uuid FROM derived
+            ''', list(base_uuids))
+            return [row[0] for row in self.cursor.fetchall()]
+        except sqlite3.Error as e:
+            logger.error(f"Error getting derived classes: {e}")
+            return []
+    
+    def has_parsed_entities(self, file_path: str) -> bool:
+        """Whether a file has entities from a full (libclang) parse
+        
+        Args:
+            file_path: Path to the file
+        """
+        try:
+            self.cursor.execute('''
+            SELECT 1 FROM entities WHERE file = ? AND NOT is_skeleton LIMIT 1
+            ''', (file_path,))
+            return self.cursor.fetchone() is not None
+        except sqlite3.Error as e:
+            logger.error(f"Error checking entities of file {file_path}: {e}")
+            raise
+    
+    def clear_skeleton_entities(self, file_path: str) -> int:
+        """Remove the skeleton entities of a file left over after a full parse
+        
+        Args:
+            file_path: Path to the file
+            
+        Returns:
+            Number of removed entities
+        """
+        try:
+            self.cursor.execute('''
+            DELETE FROM entities WHERE file = ? AND is_skeleton = 1
+            ''', (file_path,))
+            removed = self.cursor.rowcount
+            self.conn.commit()
+            if removed > 0:
+                logger.debug(f"Cleared {removed} skeleton entities for file: {file_path}")
+            return removed
+        except sqlite3.Error as e:
+            logger.error(f"Error clearing skeleton entities for file {file_path}: {e}")
+            self.conn.rollback()
+            raise
+    
     def get_files_using_feature(self, feature_name: str) -> List[str]:
         """Get all files that use a specific feature
         
@@ -1464,6 +2280,23 @@ class EntityDatabase:
             logger.error(f"Error getting files using feature {feature_name}: {e}")
             raise
     
+    def get_entity_counts(self) -> Dict[str, int]:
+        """Count the stored entities, with skeleton and external reference entities aside
+        
+        Returns:
+            Dictionary with 'entities', 'skeletons' and 'external' counts
+        """
+        try:
+            self.cursor.execute('''
+            SELECT COUNT(*), COALESCE(SUM(is_skeleton), 0), COALESCE(SUM(is_external_reference), 0)
+            FROM entities
+            ''')
+            row = self.cursor.fetchone()
+            return {'entities': row[0], 'skeletons': row[1], 'external': row[2]}
+        except sqlite3.Error as e:
+            logger.error(f"Error counting entities: {e}")
+            return {}
+    
     def get_feature_usage_counts(self) -> Dict[str, int]:
         """Get usage counts for all features
         
@@ -0,0 +1,237 @@
+#!/usr/bin/env python3
+
+"""
+Micro-benchmark of feature detectors on the cursors of a real corpus
+
+The files of a corpus are parsed as usual, but every cursor the parser would
+run feature detection on is instead handed to each built-in detector and each
+loaded plugin in isolation, timing every detect() call. Plugins see the same
+interest filters and macro index as in a parse run; time spent in
+resolve_deferred is charged to the plugin that deferred.
+
+The resulting cost table (calls, hit rate, mean and p99 time per call, share
+of all detection time) is printed, and written as JSON with --output; giving
+that file as parser.plugins.cost_ceiling.table makes the PluginManager refuse
+to load plugins over their cost ceiling.
+"""
+
+import sys
+import json
+import time
+import argparse
+from array import array
+from datetime import datetime
+from typing import Any, Dict, List, Optional, Set
+
+from .logs import setup_logging
+from .config import Config
+from .version import get_version
+from .plugin_system import _cursor_kind_name, _cursor_file_path, COST_TABLE_FORMAT
+
+logger = setup_logging()
+
+
+class DetectorCost:
+    """Timings of one detector over a benchmark"""
+
+    def __init__(self, name: str, kind: str, version: str):
+        self.name = name
+        self.kind = kind
+        self.version = version
+        self.calls = 0
+        self.hits = 0
+        self.filtered = 0
+        self.errors = 0
+        self.durations = array('d')
+
+    def record(self, elapsed: float, result: Any):
+        self.calls += 1
+        self.durations.append(elapsed)
+        if result:
+            self.hits += 1
+
+    def to_dict(self, total_time: float) -> Dict[str, Any]:
+        ordered = sorted(self.durations)
+        spent = sum(ordered)
+        p99 = ordered[min(len(ordered) - 1, int(0.99 * len(ordered)))] if ordered else 0.0
+        return {
+            'kind': self.kind,
+            'version': self.version,
+            'calls': self.calls,
+            'filtered': self.filtered,
+            'errors': self.errors,
+            'hit_rate': round(self.hits / self.calls, 4) if self.calls else 0.0,
+            'mean_us': round(spent / len(ordered) * 1e6, 2) if ordered else 0.0,
+            'p99_us': round(p99 * 1e6, 2),
+            'total_s': round(spent, 6),
+            'share': round(spent / total_time, 4) if total_time else 0.0,
+        }
+
+
+def _make_bench_parser(config: Config, compilation_database_dir: Optional[str], plugin_files: List[str],
+                       builtins: bool):
+    """ClangParser replaying its detection cursors through each detector separately"""
+    from .parse import ClangParser
+
+    class BenchParser(ClangParser):
+        def __init__(self):
+            super().__init__(compilation_database_dir, db=None, config=config,
+                             disable_plugins=bool(plugin_files), use_tree_sitter_fallback=False)
+            if plugin_files:
+                # Only the plugins under test, which must also pass plugin filters of the config
+                from .plugin_system import PluginManager
+                self.disable_plugins = False
+                self.plugin_manager = PluginManager([], config.get("parser.plugins", {}))
+                self.plugin_manager.compile_args_provider = self.get_compile_commands
+                for path in plugin_files:
+                    self.plugin_manager.load_plugin(path)
+            self.costs: Dict[str, DetectorCost] = {}
+            if builtins:
+                for name, detector in self.feature_registry.detectors.items():
+                    self.costs[name] = DetectorCost(name, 'builtin', str(detector.version))
+            if not self.disable_plugins:
+                for name, detector in self.plugin_manager.detectors.items():
+                    self.costs[name] = DetectorCost(name, 'plugin', str(detector.version))
+            self._deferred: Dict[str, List[Any]] = {}
+            self.cursors = 0
+
+        def detect_cpp_features(self, cursor, entity=None) -> Set[str]:
+            token_spellings = [t.spelling for t in cursor.get_tokens()]
+            token_str = ' '.join(token_spellings)
+            kinds = self.available_cursor_kinds
+            self.cursors += 1
+            for name, detector in self.feature_registry.detectors.items():
+                if name in self.costs:
+                    self._time(self.costs[name], detector, cursor, token_spellings, token_str, kinds)
+            if self.disable_plugins:
+                return set()
+            manager = self.plugin_manager
+            kind_name = _cursor_kind_name(cursor)
+            file_path = _cursor_file_path(cursor) or ""
+            for name, detector in manager.detectors.items():
+                detector_filter = manager.detector_filters[name]
+                if not (detector_filter.accepts_kind(kind_name) and detector_filter.accepts_tokens(token_str)
+                        and (detector_filter.globs is None or detector_filter.accepts_path(file_path))):
+                    self.costs[name].filtered += 1
+                    continue
+                result = self._time(self.costs[name], detector, cursor, token_spellings, token_str, kinds)
+                if isinstance(result, dict) and result.get('deferred') is not None:
+                    call = len(self.costs[name].durations) - 1
+                    self._deferred.setdefault(name, []).append((result['deferred'], call))
+            return set()
+
+        def _time(self, cost, detector, cursor, token_spellings, token_str, kinds):
+            started = time.perf_counter()
+            try:
+                result = detector.detect(cursor, token_spellings, token_str, kinds)
+            except Exception as e:
+                cost.errors += 1
+                logger.debug(f"Error in detector {cost.name}: {e}")
+                result = None
+            cost.record(time.perf_counter() - started, result)
+            return result
+
+        def _resolve_deferred_plugin_results(self):
+            deferred, self._deferred = self._deferred, {}
+            for name, items in deferred.items():
+                started = time.perf_counter()
+                try:
+                    self.plugin_manager.detectors[name].resolve_deferred([key for key, _ in items])
+                except Exception as e:
+                    self.costs[name].errors += 1
+                    logger.debug(f"Error resolving deferred results of {name}: {e}")
+                # Spread over the calls which deferred, as they would have cost in a parse run
+                share = (time.perf_counter() - started) / len(items)
+                durations = self.costs[name].durations
+                for _, call in items:
+                    durations[call] += share
+
+    return BenchParser()
+
+
+def benchmark_detectors(files: List[str], config: Optional[Config] = None,
+                        compilation_database_dir: Optional[str] = None,
+                        plugin_files: Optional[List[str]] = None, builtins: bool = True) -> Dict[str, Any]:
+    """Time every detector on the detection cursors of the given files
+
+    Args:
+        files: Translation units to take the cursors from
+        config: Configuration, for compile arguments and plugin settings
+        compilation_database_dir: Directory of the compile_commands.json of the files
+        plugin_files: Plugin files to benchmark instead of the configured plugin directories
+        builtins: Whether to benchmark the built-in detectors too
+
+    Returns:
+        Cost table: environment, cursor count and costs per detector
+    """
+    config = config or Config()
+    parser = _make_bench_parser(config, compilation_database_dir, plugin_files or [], builtins)
+    started = time.monotonic()
+    for path in files:
+        parser.parse_file(path)
+    wall_time = time.monotonic() - started
+    if not parser.disable_plugins:
+        parser.plugin_manager.shutdown()
+
+    total_time = sum(sum(cost.durations) for cost in parser.costs.values())
+    return {
+        'format': COST_TABLE_FORMAT,
+        'foamcd_version': get_version(),
+        'timestamp': datetime.now().isoformat(timespec='seconds'),
+        'files': len(files),
+        'cursors': parser.cursors,
+        'wall_seconds': round(wall_time, 3),
+        'detection_seconds': round(total_time, 6),
+        'detectors': {name: cost.to_dict(total_time) for name, cost in
+                      sorted(parser.costs.items(), key=lambda item: -sum(item[1].durations))},
+    }
+
+
+def format_cost_table(table: Dict[str, Any]) -> str:
+    """Cost table as aligned text, most expensive detector first"""
+    lines = [f"{table['cursors']} cursors from {table['files']} files, "
+             f"{table['detection_seconds']:.3f} s of detection",
+             f"{'Detector':<36} {'Kind':<8} {'Calls':>8} {'Hit %':>7} {'Mean us':>9} {'p99 us':>9} {'Share %':>8}",
+             "-" * 89]
+    for name, cost in table['detectors'].items():
+        lines.append(f"{name:<36} {cost['kind']:<8} {cost['calls']:>8} {cost['hit_rate'] * 100:>7.1f} "
+                     f"{cost['mean_us']:>9.1f} {cost['p99_us']:>9.1f} {cost['share'] * 100:>8.2f}")
+    return "\n".join(lines)
+
+
+def main():
+    """Main entry point for benchmarking feature detectors"""
+    from .parse import get_source_files_from_compilation_database
+
+    parser = argparse.ArgumentParser(description="Time each foamCD feature detector and plugin on a corpus")
+    parser.add_argument("files", nargs="*", help="Files to take cursors from; default: the configured target files\n"
+                                                 "or those of the compilation database")
+    parser.add_argument("--config", "-c", type=str, help="Path to YAML configuration file")
+    parser.add_argument("--compile-commands-dir", type=str, help="Directory containing compile_commands.json")
+    parser.add_argument("--plugin", action="append", dest="plugin_files", metavar="FILE",
+                        help="Benchmark this plugin file instead of the configured plugins; repeatable")
+    parser.add_argument("--no-builtins", action="store_true", help="Only benchmark plugins")
+    parser.add_argument("--output", "-o", type=str, help="Write the cost table as JSON, usable as a cost ceiling table")
+    parser.add_argument("--verbose", "-v", action="store_true", help="Enable verbose output")
+    args = parser.parse_args()
+
+    setup_logging(args.verbose)
+    config = Config(args.config)
+    compile_commands_dir = args.compile_commands_dir or config.get('parser.compile_commands_dir')
+    files = args.files or list(config.get('parser.target_files', []) or [])
+    if not files and compile_commands_dir:
+        files = get_source_files_from_compilation_database(compile_commands_dir)
+    if not files:
+        parser.error("no files to benchmark on; give files, --compile-commands-dir or a config with either")
+
+    table = benchmark_detectors(files, config, compile_commands_dir, args.plugin_files, not args.no_builtins)
+    print(format_cost_table(table))
+    if args.output:
+        with open(args.output, 'w') as f:
+            json.dump(table, f, indent=2)
+        logger.info(f"Wrote cost table to {args.output}")
+    return 0
+
+
+if __name__ == '__main__':
+    sys.exit(main() or 0)
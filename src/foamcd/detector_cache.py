@@ -0,0 +1,103 @@
+#!/usr/bin/env python3
+
+import json
+import hashlib
+from typing import Dict, List, Any, Optional, Tuple
+
+from .logs import setup_logging
+
+logger = setup_logging()
+
+
+class DetectorCache:
+    """Persistent cache of feature detector results
+
+    Results are keyed by (detector name, detector version, fingerprint of the
+    entity's token slice). Lookups hit the database once per entity; fresh
+    results are buffered and written in bulk by `flush`.
+    """
+
+    def __init__(self, db):
+        """Initialize the detector cache
+
+        Args:
+            db: EntityDatabase holding the detector_cache table
+        """
+        self.db = db
+        self._pending: List[Tuple[str, str, str, str]] = []
+        self.hits = 0
+        self.misses = 0
+
+    @staticmethod
+    def fingerprint(cursor, token_str: str) -> str:
+        """Fingerprint of everything detectors look at for a cursor
+
+        Args:
+            cursor: libclang cursor of the entity
+            token_str: Combined token string of the entity
+        """
+        kind = getattr(cursor, 'kind', None)
+        type_info = getattr(cursor, 'type', None)
+        key = "\0".join([
+            getattr(kind, 'name', str(kind)),
+            cursor.spelling or "",
+            getattr(type_info, 'spelling', "") or "",
+            token_str
+        ])
+        return hashlib.sha1(key.encode('utf-8', errors='replace')).hexdigest()
+
+    def lookup(self, fingerprint: str) -> Dict[str, Dict[str, Any]]:
+        """Cached results for a fingerprint
+
+        Returns:
+            Dictionary mapping detector names to {version: result}
+        """
+        cached = {}
+        for detector, rows in self.db.get_detector_results(fingerprint).items():
+            versions = {}
+            for version, result in rows:
+                try:
+                    versions[version] = json.loads(result)
+                except ValueError:
+                    continue
+            cached[detector] = versions
+        if cached:
+            self.hits += 1
+        else:
+            self.misses += 1
+        return cached
+
+    def record(self, fingerprint: str, results: Dict[str, Tuple[str, Any]]):
+        """Buffer fresh detector results of an entity
+
+        Args:
+            fingerprint: Fingerprint of the entity
+            results: Dictionary mapping detector names to (version, result)
+        """
+        for detector, (version, result) in results.items():
+            try:
+                self._pending.append((fingerprint, detector, str(version), json.dumps(result)))
+            except (TypeError, ValueError) as e:
+                logger.debug(f"Not caching result of detector {detector}: {e}")
+
+    def flush(self):
+        """Write buffered results to the database"""
+        if self._pending:
+            self.db.store_detector_results(self._pending)
+            logger.debug(f"Cached {len(self._pending)} detector results")
+            self._pending = []
+
+
+def cached_result(cached: Optional[Dict[str, Dict[str, Any]]], detector) -> Tuple[bool, Any]:
+    """Look up the cached result of a detector at its current version
+
+    Returns:
+        (True, result) on a cache hit, (False, None) otherwise
+    """
+    if not cached or not getattr(detector, 'cacheable', True):
+        return False, None
+    versions = cached.get(detector.name)
+    version = str(getattr(detector, 'version', '1'))
+    if versions is None or version not in versions:
+        return False, None
+    return True, versions[version]
@@ -39,6 +39,9 @@ class Entity:
         # External reference flag (for placeholder entities from standard library, etc.)
         self.is_external_reference = False
         
+        # Low-fidelity entity from a quick tree-sitter pass, replaced by a later libclang parse
+        self.is_skeleton = False
+        
         # Access level grouping for class members
         self._public_members: List[Entity] = []
         self._protected_members: List[Entity] = []
@@ -204,6 +207,7 @@ class Entity:
             'cpp_features': list(self.cpp_features),
             'is_external_reference': self.is_external_reference,
             'is_deprecated': self.is_deprecated,
+            'is_skeleton': self.is_skeleton,
         }
         if self.base_classes:
             result['base_classes'] = self.base_classes
@@ -238,3 +242,70 @@ class Entity:
             result['custom_fields'] = self.custom_fields
             
         return result
+
+
+class PlaceholderEntity(Entity):
+    """Compact stand-in for an entity outside the documented code (standard library, ...)
+    
+    The parser interns placeholders run-wide, one per USR or qualified name, so
+    each is stored once. They are never traversed nor documented: only what
+    references to them need is kept per instance, the rest are shared defaults.
+    """
+    doc_comment = ""
+    parsed_doc: Dict[str, Any] = {}
+    children = ()
+    base_classes = ()
+    cpp_features = frozenset()
+    custom_fields: Dict[str, Any] = {}
+    linkage = None
+    full_signature = None
+    is_virtual = is_pure_virtual = is_override = is_final = is_static = False
+    is_abstract = is_defaulted = is_deleted = is_deprecated = is_skeleton = False
+    is_external_reference = True
+    _public_members = _protected_members = _private_members = ()
+    
+    def __init__(self, name: str, kind: CursorKind, location: Tuple[str, int, int, int, int],
+                 key: str, parent: Optional[Entity] = None):
+        """
+        Args:
+            name: Entity name
+            kind: Cursor kind
+            location: (file, line, column, end line, end column) of its first sighting
+            key: Run-wide identity of the entity, its USR or kind and qualified name
+            parent: Enclosing documented entity, if any
+        """
+        self.name = name
+        self.kind = kind
+        self.file, self.line, self.column, self.end_line, self.end_column = location
+        self.parent = parent
+        self.access = AccessSpecifier.PUBLIC
+        self.type_info = None
+        self.namespace = None
+        content = f"placeholder:{key}"
+        if parent is not None:
+            content += f":{parent.uuid}"
+        self.uuid = hashlib.sha256(content.encode('utf-8')).hexdigest()
+    
+    def add_child(self, child: Entity):
+        raise TypeError("Placeholder entities have no children")
+    
+    def to_dict(self) -> Dict[str, Any]:
+        """Kind-only representation, stored once and never replaced"""
+        return {
+            'uuid': self.uuid,
+            'name': self.name,
+            'kind': self.kind.name if hasattr(self.kind, 'name') else str(self.kind),
+            'parent_uuid': self.parent.uuid if self.parent else None,
+            'namespace': self.namespace,
+            'location': {
+                'file': self.file,
+                'line': self.line,
+                'column': self.column,
+                'end_line': self.end_line,
+                'end_column': self.end_column
+            },
+            'access': self.access.name if self.access else None,
+            'type_info': self.type_info,
+            'is_external_reference': True,
+            'children': [],
+        }
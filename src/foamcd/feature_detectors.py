@@ -1,15 +1,49 @@
 #!/usr/bin/env python3
 
-from typing import List
+from typing import Any, Dict, List, Optional
 
 from clang.cindex import CursorKind
 
 from .logs import setup_logging
+from .detector_cache import cached_result
+from .macro_index import find_macro_calls
 logger = setup_logging()
 
 class FeatureDetector:
-    """Base class for C++/DSL feature detectors"""
-    
+    """Base class for C++/DSL feature detectors
+
+    Detectors may narrow down which cursors they are interested in through
+    the following class attributes; the PluginManager consults them before
+    calling `detect`, so uninteresting cursors never reach the plugin code.
+    A value of None means "no restriction".
+
+    - cursor_kinds: CursorKind values (or their names) the detector handles
+    - required_tokens: tokens/macro names of which at least one must appear
+      in the cursor's token string
+    - path_globs: fnmatch patterns the cursor's file path must match
+
+    Detectors consuming macro calls list the macro names in `macros`; the parser
+    then indexes their invocations once per translation unit and the detector can
+    look up the calls inside a cursor with `macro_invocations`.
+
+    Results are cached across runs per entity token fingerprint; bump `version`
+    whenever the detection logic changes. The fingerprint only covers the cursor's
+    kind, spelling and type and the tokens of its extent (children and macro calls
+    inside it included). Detectors reading anything else, e.g. through
+    `semantic_parent`, `referenced` or sibling declarations, must set `cacheable`
+    to False: the same tokens in another scope, or after an edit elsewhere, would
+    otherwise get a stale result.
+    """
+
+    cursor_kinds = None
+    required_tokens = None
+    path_globs = None
+    macros = None
+    # Set by the plugin manager for each translation unit
+    macro_index = None
+    version = "1"
+    cacheable = True
+
     def __init__(self, name: str, cpp_version: str, description: str = ""):
         self.name = name
         self.cpp_version = cpp_version
@@ -19,6 +53,48 @@ class FeatureDetector:
         """Return True if feature is detected, False otherwise, optionally a dictionary for detected fields"""
         raise NotImplementedError("Subclasses must implement this method")
 
+    def resolve_deferred(self, keys: List[Any]) -> Dict[Any, bool | dict]:
+        """Resolve detection results that `detect` deferred by returning a 'deferred' key
+
+        Called once per translation unit with all keys deferred during its traversal,
+        so expensive work can be batched.
+
+        Returns:
+            Dictionary mapping each key to a result in the same form `detect` returns
+        """
+        return {}
+
+    def macro_invocations(self, cursor, token_spellings: Optional[List[str]] = None):
+        """Calls to this detector's `macros` inside the extent of a cursor
+
+        Looked up in the translation unit's macro index; cursor snapshots of
+        out-of-process runs carry their invocations instead. Calls the
+        preprocessor did not see as macros (e.g. because the defining header
+        was not found) are recovered by scanning token_spellings, if given.
+
+        Returns:
+            List of MacroInvocation objects, or None if no source is available
+        """
+        invocations = getattr(cursor, 'macro_invocations', None)
+        if invocations is None and self.macro_index is not None:
+            invocations = self.macro_index.within_cursor(cursor, self.macros)
+        if token_spellings is None or not self.macros:
+            return invocations
+        invocations = list(invocations or [])
+        seen = {call.name for call in invocations}
+        unseen = [name for name in self.macros if name not in seen and name in token_spellings]
+        if unseen:
+            invocations.extend(find_macro_calls(token_spellings, unseen))
+        return invocations
+
+    def cache_value(self, result):
+        """JSON-serializable form of a `detect` result for the detector cache"""
+        return result
+
+    def restore_cached(self, value):
+        """Turn a cached value back into a `detect` result, restoring any detector state"""
+        return value
+
 class ClassesDetector(FeatureDetector):
     def __init__(self):
         super().__init__("classes", "C++98", "Classes and structs")
@@ -231,6 +307,9 @@ class OperatorOverloadingDetector(FeatureDetector):
 
 
 class FunctionOverloadingDetector(FeatureDetector):
+    # Counts sibling declarations, outside of the entity's tokens
+    cacheable = False
+
     def __init__(self):
         super().__init__("function_overloading", "C++98", "Function overloading")
     
@@ -379,6 +458,9 @@ class LambdaExpressionDetector(FeatureDetector):
 
 
 class DelegatingConstructorsDetector(FeatureDetector):
+    # Compares with the enclosing class and the classes of referenced constructors
+    cacheable = False
+
     def __init__(self):
         super().__init__("delegating_constructors", "C++11", "Delegating constructors")
     
@@ -404,6 +486,9 @@ class DelegatingConstructorsDetector(FeatureDetector):
 
 
 class ExplicitConversionDetector(FeatureDetector):
+    # Compares with the name of the enclosing class
+    cacheable = False
+
     def __init__(self):
         super().__init__("explicit_conversion", "C++11", "Explicit conversion operators")
     
@@ -976,13 +1061,27 @@ class FeatureDetectorRegistry:
         # C++20 Attributes
         self.register(Cpp20AttributesDetector())
         
-    def detect_features(self, cursor, token_spellings, token_str, available_cursor_kinds):
-        """Run all registered detectors and return detected features"""
+    def detect_features(self, cursor, token_spellings, token_str, available_cursor_kinds,
+                        cached=None, fresh=None):
+        """Run all registered detectors and return detected features
+        
+        Args:
+            cached: Optional cached results ({detector: {version: value}}); detectors
+                    with a result at their current version are not run
+            fresh: Optional dictionary receiving (version, value) of detectors that ran
+        """
         features = set()
         
         for name, detector in self.detectors.items():
             try:
-                if detector.detect(cursor, token_spellings, token_str, available_cursor_kinds):
+                hit, value = cached_result(cached, detector)
+                if hit:
+                    result = detector.restore_cached(value)
+                else:
+                    result = detector.detect(cursor, token_spellings, token_str, available_cursor_kinds)
+                    if fresh is not None and detector.cacheable:
+                        fresh[name] = (detector.version, detector.cache_value(bool(result)))
+                if result:
                     features.add(name)
                     if name == "explicit_conversion":
                         features.add("operator_overloading")  # C++98
@@ -1017,6 +1116,15 @@ class DeprecatedAttributeDetector(FeatureDetector):
     def __init__(self):
         super().__init__("deprecated_attribute", "C++14", "[[deprecated(\"message\")]] compiler attribute")
     
+    def cache_value(self, result):
+        # The deprecation message is picked up by the parser after detection
+        return {'detected': result, 'message': getattr(self, 'deprecation_message', None) if result else None}
+    
+    def restore_cached(self, value):
+        if value.get('detected'):
+            self.deprecation_message = value.get('message')
+        return value.get('detected', False)
+    
     def detect(self, cursor, token_spellings, token_str, available_cursor_kinds):
         cursor_name = cursor.spelling if cursor else "<unknown>"
         logger.debug(f"Tokens for {cursor_name}: {token_spellings}")
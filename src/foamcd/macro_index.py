@@ -0,0 +1,163 @@
+#!/usr/bin/env python3
+
+"""
+Index of macro invocations of a translation unit
+
+Built once per translation unit from the MACRO_INSTANTIATION cursors of the
+preprocessing record (requested with PARSE_DETAILED_PROCESSING_RECORD), so
+plugins can look up the macro calls inside an entity's extent instead of
+re-scanning its token string with regular expressions.
+"""
+
+from bisect import bisect_left, bisect_right
+from typing import Dict, List, Optional, Iterable
+
+from .logs import setup_logging
+
+logger = setup_logging()
+
+
+class MacroInvocation:
+    """A single macro call with its arguments split at top-level commas"""
+
+    __slots__ = ('name', 'args', 'file', 'line', 'column', 'start_offset', 'end_offset')
+
+    def __init__(self, name: str, args: Optional[List[str]], file: Optional[str] = None,
+                 line: int = 0, column: int = 0, start_offset: int = 0, end_offset: int = 0):
+        self.name = name
+        # None for object-like invocations (no parentheses)
+        self.args = args
+        self.file = file
+        self.line = line
+        self.column = column
+        self.start_offset = start_offset
+        self.end_offset = end_offset
+
+    def __repr__(self):
+        return f"MacroInvocation({self.name}, {self.args}, {self.file}:{self.line})"
+
+
+def split_macro_arguments(token_spellings: List[str], start: int = 0):
+    """Split the arguments of a macro call from its token spellings
+
+    Arguments are separated by commas outside nested parentheses, as the
+    preprocessor does; each argument is its tokens joined by single spaces.
+
+    Args:
+        token_spellings: Tokens of the call, or of a larger token stream
+        start: Index of the opening parenthesis in token_spellings
+
+    Returns:
+        Tuple of (list of arguments, index of the closing parenthesis), or
+        (None, start) if there is no (balanced) argument list at start
+    """
+    if start >= len(token_spellings) or token_spellings[start] != '(':
+        return None, start
+    args = []
+    current = []
+    depth = 0
+    for i in range(start, len(token_spellings)):
+        token = token_spellings[i]
+        if token == '(':
+            depth += 1
+            if depth == 1:
+                continue
+        elif token == ')':
+            depth -= 1
+            if depth == 0:
+                if current or args:
+                    args.append(' '.join(current))
+                return args, i
+        elif token == ',' and depth == 1:
+            args.append(' '.join(current))
+            current = []
+            continue
+        current.append(token)
+    return None, start
+
+
+def find_macro_calls(token_spellings: List[str], names: Iterable[str]) -> List[MacroInvocation]:
+    """Find calls to the given macros in a token stream
+
+    Fallback for when no preprocessing record is available; yields the same
+    structured invocations as the index, without locations.
+    """
+    names = set(names)
+    calls = []
+    i = 0
+    while i < len(token_spellings):
+        token = token_spellings[i]
+        if token in names:
+            args, end = split_macro_arguments(token_spellings, i + 1)
+            if args is not None:
+                calls.append(MacroInvocation(token, args))
+                i = end
+        i += 1
+    return calls
+
+
+class MacroIndex:
+    """Macro invocations of a translation unit, by file and offset"""
+
+    def __init__(self):
+        self._by_file: Dict[str, List[MacroInvocation]] = {}
+        self._starts: Dict[str, List[int]] = {}
+
+    def __len__(self):
+        return sum(len(calls) for calls in self._by_file.values())
+
+    def add(self, invocation: MacroInvocation):
+        self._by_file.setdefault(invocation.file, []).append(invocation)
+        self._starts.pop(invocation.file, None)
+
+    @classmethod
+    def build(cls, translation_unit, names: Optional[Iterable[str]] = None) -> 'MacroIndex':
+        """Build the index from the preprocessing record of a translation unit
+
+        Args:
+            translation_unit: libclang translation unit parsed with a detailed processing record
+            names: Only index invocations of these macros (all macros if None)
+        """
+        from clang.cindex import CursorKind
+        index = cls()
+        wanted = set(names) if names is not None else None
+        for cursor in translation_unit.cursor.get_children():
+            if cursor.kind != CursorKind.MACRO_INSTANTIATION:
+                continue
+            if wanted is not None and cursor.spelling not in wanted:
+                continue
+            start = cursor.extent.start
+            if not start.file:
+                continue
+            tokens = [t.spelling for t in cursor.get_tokens()]
+            args, _ = split_macro_arguments(tokens, 1)
+            index.add(MacroInvocation(
+                cursor.spelling, args, start.file.name,
+                start.line, start.column, start.offset, cursor.extent.end.offset
+            ))
+        logger.debug(f"Indexed {len(index)} macro invocations")
+        return index
+
+    def within(self, file: str, start_offset: int, end_offset: int,
+               names: Optional[Iterable[str]] = None) -> List[MacroInvocation]:
+        """Invocations starting inside [start_offset, end_offset] of a file, in source order"""
+        calls = self._by_file.get(file)
+        if not calls:
+            return []
+        starts = self._starts.get(file)
+        if starts is None:
+            calls.sort(key=lambda call: call.start_offset)
+            starts = [call.start_offset for call in calls]
+            self._starts[file] = starts
+        found = calls[bisect_left(starts, start_offset):bisect_right(starts, end_offset)]
+        if names is not None:
+            names = set(names)
+            found = [call for call in found if call.name in names]
+        return found
+
+    def within_cursor(self, cursor, names: Optional[Iterable[str]] = None) -> List[MacroInvocation]:
+        """Invocations inside the extent of a cursor, e.g. the macros used in a class body"""
+        extent = cursor.extent
+        if not extent.start.file:
+            return []
+        return self.within(extent.start.file.name, extent.start.offset, extent.end.offset, names)
@@ -5,7 +5,9 @@ import sys
 import argparse
 import hashlib
 import re
-from typing import Dict, List, Any, Optional
+import time
+from contextlib import contextmanager
+from typing import Dict, List, Any, Optional, Set
 import frontmatter
 from datetime import datetime
 from jinja2 import Template
@@ -18,9 +20,18 @@ from .markdown_functions_index import FunctionsIndexGenerator
 from .markdown_concepts_index import ConceptsIndexGenerator
 from .git import get_git_root
 from .version import get_version
+from .config import Config
+from .metrics_export import RunMetrics
+from .tracing import tracer, traced
+from .memory import memory
+from .sql_profile import profiler
 
 logger = setup_logging()
 
+# Entity kinds which get their own page
+PAGE_ENTITY_KINDS = ['CLASS_DECL', 'CLASS_TEMPLATE', 'STRUCT_DECL', 'STRUCT_TEMPLATE']
+
+
 class MarkdownGenerator(MarkdownGeneratorBase):
     """Generates Hugo-compatible markdown files from foamCD database
     
@@ -30,7 +41,8 @@ class MarkdownGenerator(MarkdownGeneratorBase):
     _unit_tests_db_cache = {}
     _verbose_unit_tests_logging = True  # Control verbose logging, only first load gets verbose log
     
-    def __init__(self, db_path: str, output_path: str, project_dir: str = None, config_path: str = None):
+    def __init__(self, db_path: str, output_path: str, project_dir: str = None, config_path: str = None,
+                 config_object=None):
         """Initialize the markdown generator
         
         Args:
@@ -38,11 +50,15 @@ class MarkdownGenerator(MarkdownGeneratorBase):
             output_path: Path to output markdown files
             project_dir: Optional project directory to filter entities by
             config_path: Optional path to configuration file
+            config_object: Already loaded configuration, used instead of config_path
         """
-        super().__init__(db_path, output_path, project_dir, config_path)
+        super().__init__(db_path, output_path, project_dir, config_path, config_object=config_object)
         self.class_index_generator = ClassIndexGenerator(db_path, output_path, project_dir, config_object=self.config)
         self.functions_index_generator = FunctionsIndexGenerator(db_path, output_path, project_dir, config_object=self.config)
         self.concepts_index_generator = ConceptsIndexGenerator(db_path, output_path, project_dir, config_object=self.config)
+        # Outcome of the last generate_all, for the run metrics
+        self.page_counts = {'index': 0, 'generated': 0, 'skipped': 0, 'removed': 0}
+        self.stage_seconds: Dict[str, float] = {}
     
     def _transform_entity_paths(self, entity: Dict[str, Any]) -> Dict[str, Any]:
         """Transform file paths in entity for inclusion in frontmatter
@@ -103,12 +119,16 @@ class MarkdownGenerator(MarkdownGeneratorBase):
                 
         return entity_copy
         
-    def generate_entity_pages(self):
+    def generate_entity_pages(self, only_uuids: Optional[Set[str]] = None, remove_stale: bool = True):
         """Generate individual markdown pages for each class in the project_dir
         
         Generates a file for each class directly in the output path
         with filename format: {{namespace}}_{{className}}.md
         If a file already exists, its content is preserved and only the frontmatter is updated.
+        
+        Args:
+            only_uuids: Only regenerate the pages of these classes, e.g. those a watched edit changed
+            remove_stale: Whether to remove pages of classes no longer in the database
         """
         # Ensure output directory exists
         if not os.path.exists(self.output_path):
@@ -140,10 +160,14 @@ class MarkdownGenerator(MarkdownGeneratorBase):
                 logger.debug(f"Database contains {entity_count} total entities")
             except Exception as e:
                 logger.warning(f"Error getting entity count: {e}")
-            class_entities = db.get_entities_by_kind_in_project(
-                ['CLASS_DECL', 'CLASS_TEMPLATE', 'STRUCT_DECL', 'STRUCT_TEMPLATE'],
-                effective_project_dir
-            )
+            if only_uuids is None:
+                class_entities = db.get_entities_by_kind_in_project(PAGE_ENTITY_KINDS, effective_project_dir)
+            else:
+                project_prefix = os.path.normpath(effective_project_dir)
+                class_entities = [entity for entity in (db.get_entity_by_uuid(uuid, include_children=True)
+                                                        for uuid in sorted(only_uuids))
+                                  if entity and entity.get('kind') in PAGE_ENTITY_KINDS
+                                  and (entity.get('file') or '').startswith(project_prefix)]
             if class_entities:
                 logger.debug(f"Database reports {len(class_entities)} classes in total")
             else:
@@ -203,7 +227,6 @@ class MarkdownGenerator(MarkdownGeneratorBase):
                         entity_db.conn.close()
                         
             class_name = entity.get('name')
-            import re
             # TODO: manually excluding add.*ConstructorToTable feels wrong
             # Maybe it's just an artifact of the unit tests
             if re.match(r'add.*ConstructorToTable', class_name):
@@ -237,88 +260,100 @@ class MarkdownGenerator(MarkdownGeneratorBase):
                 skipped_count += 1
                 continue
                 
-            file_path = os.path.join(self.output_path, filename)
-            frontmatter_data = {
-                "title": class_name,
-                "url": self._get_entity_url(entity),
-                "layout": "class",
-                "weight": 20,
-                "date": datetime.now().strftime("%Y-%m-%d"),
-                "description": (entity.get("documentation", {}).get("brief", "") or 
-                               entity.get("documentation", {}).get("description", "") or 
-                               f"API documentation for {class_name}"),
-                "categories": [
-                    "api",
-                    f"{self.config.get('markdown.project_name')} API"
-                ],
-                "api_tags": self._get_entity_api_tags(entity),
-                "foamCD": {
-                    "filename": self._get_entity_filename(entity),
-                    "namespace": namespace,
-                    "signature": entity.get("full_signature", ""),
-                    "documentation": self._format_entity_documentation(entity),
-                    "ctors": self._get_entity_constructors(entity),
-                    "factory_methods": self._get_entity_factory_methods(entity),
-                    "dtor": self._get_entity_destructor(entity),
-                    "standard_config": self._get_entity_standard_config(entity),
-                    "interface": {
-                        "public_bases": self._get_entity_public_bases(entity),
-                        "static_methods": self._get_entity_static_methods(entity),
-                        "abstract_methods": self._get_entity_abstract_methods(entity),
-                        "abstract_in_base_methods": self._get_entity_abstract_in_base_methods(entity),
-                        "public_methods": self._get_entity_public_methods(entity)
-                    },
-                    "fields": {
-                        "public": self._get_entity_public_fields(entity),
-                        "protected": self._get_entity_protected_fields(entity),
-                        "private": self._get_entity_private_fields(entity)
-                    },
-                    "member_type_aliases": {
-                        "public": self._get_entity_public_member_type_aliases(entity),
-                        "protected": self._get_entity_protected_member_type_aliases(entity),
-                        "private": self._get_entity_private_member_type_aliases(entity)
-                    },
-                    "openfoam_dsl": {
-                        "RTS": self._get_entity_rts_info(entity),
-                        "reflection": self._get_entity_reflection_info(entity)
-                    },
-                    "unit_tests": self._get_entity_unit_tests(entity),
-                    "knowledge_requirements": self._get_entity_knowledge_requirements(entity),
-                    "protected_bases": self._get_entity_protected_bases(entity),
-                    "protected_methods": self._get_entity_protected_methods(entity),
-                    "private_bases": self._get_entity_private_bases(entity),
-                    "private_methods": self._get_entity_private_methods(entity),
-                    "enclosed_entities": self._get_entity_enclosed_entities(entity),
-                    "mpi_comms": self._get_entity_mpi_comms(entity)
+            with tracer.span('page', 'markdown', page=filename), memory.phase('page', filename):
+                file_path = os.path.join(self.output_path, filename)
+                frontmatter_data = {
+                    "title": class_name,
+                    "url": self._get_entity_url(entity),
+                    "layout": "class",
+                    "weight": 20,
+                    "date": datetime.now().strftime("%Y-%m-%d"),
+                    "description": (entity.get("documentation", {}).get("brief", "") or 
+                                   entity.get("documentation", {}).get("description", "") or 
+                                   f"API documentation for {class_name}"),
+                    "categories": [
+                        "api",
+                        f"{self.config.get('markdown.project_name')} API"
+                    ],
+                    "api_tags": self._get_entity_api_tags(entity),
+                    "foamCD": {
+                        "filename": self._get_entity_filename(entity),
+                        "namespace": namespace,
+                        "signature": entity.get("full_signature", ""),
+                        "documentation": self._format_entity_documentation(entity),
+                        "ctors": self._get_entity_constructors(entity),
+                        "factory_methods": self._get_entity_factory_methods(entity),
+                        "dtor": self._get_entity_destructor(entity),
+                        "standard_config": self._get_entity_standard_config(entity),
+                        "interface": {
+                            "public_bases": self._get_entity_public_bases(entity),
+                            "static_methods": self._get_entity_static_methods(entity),
+                            "abstract_methods": self._get_entity_abstract_methods(entity),
+                            "abstract_in_base_methods": self._get_entity_abstract_in_base_methods(entity),
+                            "public_methods": self._get_entity_public_methods(entity)
+                        },
+                        "fields": {
+                            "public": self._get_entity_public_fields(entity),
+                            "protected": self._get_entity_protected_fields(entity),
+                            "private": self._get_entity_private_fields(entity)
+                        },
+                        "member_type_aliases": {
+                            "public": self._get_entity_public_member_type_aliases(entity),
+                            "protected": self._get_entity_protected_member_type_aliases(entity),
+                            "private": self._get_entity_private_member_type_aliases(entity)
+                        },
+                        "openfoam_dsl": {
+                            "RTS": self._get_entity_rts_info(entity),
+                            "reflection": self._get_entity_reflection_info(entity)
+                        },
+                        "unit_tests": self._get_entity_unit_tests(entity),
+                        "knowledge_requirements": self._get_entity_knowledge_requirements(entity),
+                        "protected_bases": self._get_entity_protected_bases(entity),
+                        "protected_methods": self._get_entity_protected_methods(entity),
+                        "private_bases": self._get_entity_private_bases(entity),
+                        "private_methods": self._get_entity_private_methods(entity),
+                        "enclosed_entities": self._get_entity_enclosed_entities(entity),
+                        "mpi_comms": self._get_entity_mpi_comms(entity)
+                    }
                 }
-            }
             
-            if self.config.get("markdown", {}).get("frontmatter", {}).get("entities", {}).get("contributors_from_git", False):
-                frontmatter_data["contributors"] = self._get_entity_contributors(entity)
-            content = ""
-            if os.path.exists(file_path):
-                try:
-                    with open(file_path, 'r') as f:
-                        post = frontmatter.load(f)
-                    content = post.content
-                    logger.debug(f"Preserved content from existing entity page: {filename}")
-                    if 'foamCD' in post and isinstance(post['foamCD'], dict):
-                        existing_foamcd = post['foamCD']
-                        if 'class_info' in existing_foamcd:
-                            del existing_foamcd['class_info']
-                        for k, v in existing_foamcd.items():
-                            if k not in frontmatter_data['foamCD']:
-                                frontmatter_data['foamCD'][k] = v
-                except Exception as e:
-                    logger.warning(f"Error reading existing entity file {filename}: {e}")
-            else:
+                if self.config.get("markdown", {}).get("frontmatter", {}).get("entities", {}).get("contributors_from_git", False):
+                    frontmatter_data["contributors"] = self._get_entity_contributors(entity)
                 content = ""
-                logger.debug(f"Creating new entity page: {filename}")
-            post = frontmatter.Post(content, **frontmatter_data)
-            with open(file_path, 'w') as f:
-                f.write(frontmatter.dumps(post))
-            generated_count += 1
+                if os.path.exists(file_path):
+                    try:
+                        with open(file_path, 'r') as f:
+                            post = frontmatter.load(f)
+                        content = post.content
+                        logger.debug(f"Preserved content from existing entity page: {filename}")
+                        if 'foamCD' in post and isinstance(post['foamCD'], dict):
+                            existing_foamcd = post['foamCD']
+                            if 'class_info' in existing_foamcd:
+                                del existing_foamcd['class_info']
+                            for k, v in existing_foamcd.items():
+                                if k not in frontmatter_data['foamCD']:
+                                    frontmatter_data['foamCD'][k] = v
+                    except Exception as e:
+                        logger.warning(f"Error reading existing entity file {filename}: {e}")
+                else:
+                    content = ""
+                    logger.debug(f"Creating new entity page: {filename}")
+                post = frontmatter.Post(content, **frontmatter_data)
+                with open(file_path, 'w') as f:
+                    f.write(frontmatter.dumps(post))
+                generated_count += 1
             
+        self.page_counts.update(generated=generated_count, skipped=skipped_count, removed=0)
+        if not remove_stale:
+            logger.info(f"Entity page generation complete: {generated_count} pages generated, {skipped_count} classes skipped")
+            return
+        if only_uuids is not None:
+            db = EntityDatabase(self.db_path)
+            try:
+                class_entities = db.get_entities_by_kind_in_project(PAGE_ENTITY_KINDS, effective_project_dir)
+            finally:
+                db.close()
+        
         # Track valid entity filenames to check for stale files
         valid_entity_filenames = set()
         for entity in class_entities:
@@ -392,6 +427,7 @@ class MarkdownGenerator(MarkdownGeneratorBase):
                     logger.warning(f"Error checking stale entity file {filename}: {e}")
         
         logger.info(f"Entity page generation complete: {generated_count} pages generated, {skipped_count} classes skipped, {removed_count} stale entity files removed")
+        self.page_counts.update(generated=generated_count, skipped=skipped_count, removed=removed_count)
     
     def generate_all(self):
         """Generate all markdown files based on configuration settings"""
@@ -399,23 +435,44 @@ class MarkdownGenerator(MarkdownGeneratorBase):
             os.makedirs(self.output_path)
         logger.info(f"Generating markdown files in {self.output_path}")
         logger.info("Generating _index.md file (always required)")
-        self.class_index_generator.generate_all()
+        self.page_counts = {'index': 0, 'generated': 0, 'skipped': 0, 'removed': 0}
+        self.stage_seconds = {}
+        self.generate_indexes()
+        with self._stage('entity pages'):
+            self.generate_entity_pages()
+        logger.info("Markdown generation complete")
+    
+    def generate_indexes(self):
+        """Generate the index pages enabled in the configuration"""
+        with self._stage('class index'):
+            self.class_index_generator.generate_all()
         functions_enabled = self.config.get("markdown.frontmatter.index.functions_and_function_templates", True) if self.config else True
         if functions_enabled:
             logger.info("Generating functions.md (enabled in config)")
-            self.functions_index_generator.generate_all()
+            with self._stage('functions index'):
+                self.functions_index_generator.generate_all()
         else:
             logger.info("Skipping functions.md (disabled in config)")
         
         concepts_enabled = self.config.get("markdown.frontmatter.index.concepts", True) if self.config else True
         if concepts_enabled:
             logger.info("Generating concepts.md (enabled in config)")
-            self.concepts_index_generator.generate_all()
+            with self._stage('concepts index'):
+                self.concepts_index_generator.generate_all()
         else:
             logger.info("Skipping concepts.md (disabled in config)")
-        self.generate_entity_pages()
-        logger.info("Markdown generation complete")
-        
+    
+    @contextmanager
+    def _stage(self, name: str):
+        """Trace span, memory phase and recorded duration of a stage of generate_all"""
+        started = time.monotonic()
+        with tracer.span(name, 'markdown'), memory.phase(name):
+            yield
+        self.stage_seconds[name] = time.monotonic() - started
+        if name.endswith(' index'):
+            self.page_counts['index'] += 1
+        
+    @traced(category='markdown')
     def _get_entity_api_tags(self, entity: Dict[str, Any]) -> List[str]:
         """Get API tags for an entity
         
@@ -434,6 +491,7 @@ class MarkdownGenerator(MarkdownGeneratorBase):
             tags.append("rts_base")
         return tags
         
+    @traced(category='markdown')
     def _get_entity_filename(self, entity: Dict[str, Any]) -> str:
         """Get the source filename for an entity, transformed via templates
         
@@ -541,6 +599,7 @@ class MarkdownGenerator(MarkdownGeneratorBase):
             
         return result
     
+    @traced(category='markdown')
     def _get_entity_url(self, entity: Dict[str, Any]) -> str:
         """Get the URL for an entity, transformed via templates.
         For now, only handles classes/structs.
@@ -736,6 +795,7 @@ class MarkdownGenerator(MarkdownGeneratorBase):
             
         return formatted_info
     
+    @traced(category='markdown')
     def _get_entity_constructors(self, entity: Dict[str, Any]) -> List[Dict[str, Any]]:
         """Get constructor information for an entity
         
@@ -760,6 +820,7 @@ class MarkdownGenerator(MarkdownGeneratorBase):
                 
         return constructors
         
+    @traced(category='markdown')
     def _get_entity_destructor(self, entity: Dict[str, Any]) -> Optional[Dict[str, Any]]:
         """Get destructor information for an entity
         
@@ -853,6 +914,7 @@ class MarkdownGenerator(MarkdownGeneratorBase):
             returns_class_type = True
         return is_factory_pattern and returns_class_type
         
+    @traced(category='markdown')
     def _get_entity_factory_methods(self, entity: Dict[str, Any]) -> List[Dict[str, Any]]:
         """Get factory method information for an entity
         
@@ -885,6 +947,7 @@ class MarkdownGenerator(MarkdownGeneratorBase):
                 
         return factory_methods
         
+    @traced(category='markdown')
     def _get_entity_standard_config(self, entity: Dict[str, Any]) -> str:
         """Get standard configuration for an entity
         
@@ -898,6 +961,7 @@ class MarkdownGenerator(MarkdownGeneratorBase):
         # and possibly "Just-in-time compilation"
         return ""
         
+    @traced(category='markdown')
     def _get_entity_public_bases(self, entity: Dict[str, Any]) -> List[Dict[str, Any]]:
         """Get public methods inherited from base classes for an entity
         
@@ -971,6 +1035,7 @@ class MarkdownGenerator(MarkdownGeneratorBase):
             
         return result
         
+    @traced(category='markdown')
     def _get_entity_static_methods(self, entity: Dict[str, Any]) -> List[Dict[str, Any]]:
         """Get static method information for an entity
         
@@ -1011,6 +1076,7 @@ class MarkdownGenerator(MarkdownGeneratorBase):
                 
         return static_methods
         
+    @traced(category='markdown')
     def _get_entity_abstract_methods(self, entity: Dict[str, Any]) -> List[Dict[str, Any]]:
         """Get abstract method information for an entity
         
@@ -1047,6 +1113,7 @@ class MarkdownGenerator(MarkdownGeneratorBase):
                     abstract_methods.append(new_entry)
         return abstract_methods
         
+    @traced(category='markdown')
     def _get_entity_abstract_in_base_methods(self, entity: Dict[str, Any]) -> List[Dict[str, Any]]:
         """Get abstract methods from base classes that are implemented in this class
         
@@ -1145,6 +1212,7 @@ class MarkdownGenerator(MarkdownGeneratorBase):
             
         return implemented_abstract_methods
         
+    @traced(category='markdown')
     def _get_entity_public_methods(self, entity: Dict[str, Any]) -> List[Dict[str, Any]]:
         """Get public method information for an entity
         
@@ -1198,6 +1266,7 @@ class MarkdownGenerator(MarkdownGeneratorBase):
                 
         return public_methods
         
+    @traced(category='markdown')
     def _get_entity_rts_info(self, entity: Dict[str, Any]) -> Dict[str, Any]:
         """Get OpenFOAM RunTimeSelection information for an entity
         
@@ -1359,6 +1428,7 @@ class MarkdownGenerator(MarkdownGeneratorBase):
                 
         return rts_info
         
+    @traced(category='markdown')
     def _get_entity_reflection_info(self, entity: Dict[str, Any]) -> Dict[str, Any]:
         """Get OpenFOAM reflection information for this entity
 
@@ -1406,6 +1476,7 @@ class MarkdownGenerator(MarkdownGeneratorBase):
 
         return reflection_info
         
+    @traced(category='markdown')
     def _get_entity_unit_tests(self, entity: Dict[str, Any]) -> List[Dict[str, Any]]:
         """Get unit test information for an entity
         
@@ -1671,6 +1742,7 @@ class MarkdownGenerator(MarkdownGeneratorBase):
             
         return unit_tests
         
+    @traced(category='markdown')
     def _get_entity_knowledge_requirements(self, entity: Dict[str, Any]) -> List[str]:
         """Get knowledge requirements for understanding an entity
         
@@ -1752,6 +1824,7 @@ class MarkdownGenerator(MarkdownGeneratorBase):
             requirements.add("openfoam_rts")
         return sorted(list(requirements))
         
+    @traced(category='markdown')
     def _get_entity_protected_bases(self, entity: Dict[str, Any]) -> List[Dict[str, Any]]:
         """Get protected methods inherited from base classes for an entity
         
@@ -1826,6 +1899,7 @@ class MarkdownGenerator(MarkdownGeneratorBase):
             
         return result
         
+    @traced(category='markdown')
     def _get_entity_protected_methods(self, entity: Dict[str, Any]) -> List[Dict[str, Any]]:
         """Get protected method information for an entity
         
@@ -1872,6 +1946,7 @@ class MarkdownGenerator(MarkdownGeneratorBase):
                 
         return protected_methods
         
+    @traced(category='markdown')
     def _get_entity_private_bases(self, entity: Dict[str, Any]) -> List[Dict[str, Any]]:
         """Get private methods inherited from base classes for an entity
         
@@ -1945,6 +2020,7 @@ class MarkdownGenerator(MarkdownGeneratorBase):
             
         return result
         
+    @traced(category='markdown')
     def _get_entity_private_methods(self, entity: Dict[str, Any]) -> List[Dict[str, Any]]:
         """Get private method information for an entity
         
@@ -2040,6 +2116,7 @@ class MarkdownGenerator(MarkdownGeneratorBase):
             
         return field_info
     
+    @traced(category='markdown')
     def _get_entity_public_fields(self, entity: Dict[str, Any]) -> List[Dict[str, Any]]:
         """Get public field information for an entity
         
@@ -2062,6 +2139,7 @@ class MarkdownGenerator(MarkdownGeneratorBase):
             public_fields.append(field_info)
         return public_fields
         
+    @traced(category='markdown')
     def _get_entity_protected_fields(self, entity: Dict[str, Any]) -> List[Dict[str, Any]]:
         """Get protected field information for an entity
         
@@ -2084,6 +2162,7 @@ class MarkdownGenerator(MarkdownGeneratorBase):
                 
         return protected_fields
         
+    @traced(category='markdown')
     def _get_entity_private_fields(self, entity: Dict[str, Any]) -> List[Dict[str, Any]]:
         """Get private field information for an entity
         
@@ -2151,6 +2230,7 @@ class MarkdownGenerator(MarkdownGeneratorBase):
             logger.error(f"Error retrieving {access_level} member type aliases: {e}")
         return type_aliases
     
+    @traced(category='markdown')
     def _get_entity_public_member_type_aliases(self, entity: Dict[str, Any]) -> List[Dict[str, Any]]:
         """Get public member type aliases for a class
         
@@ -2162,6 +2242,7 @@ class MarkdownGenerator(MarkdownGeneratorBase):
         """
         return self._get_member_type_aliases_by_access(entity, "public")
     
+    @traced(category='markdown')
     def _get_entity_protected_member_type_aliases(self, entity: Dict[str, Any]) -> List[Dict[str, Any]]:
         """Get protected member type aliases for a class
         
@@ -2173,6 +2254,7 @@ class MarkdownGenerator(MarkdownGeneratorBase):
         """
         return self._get_member_type_aliases_by_access(entity, "protected")
     
+    @traced(category='markdown')
     def _get_entity_private_member_type_aliases(self, entity: Dict[str, Any]) -> List[Dict[str, Any]]:
         """Get private member type aliases for a class
         
@@ -2184,6 +2266,7 @@ class MarkdownGenerator(MarkdownGeneratorBase):
         """  
         return self._get_member_type_aliases_by_access(entity, "private")
         
+    @traced(category='markdown')
     def _get_entity_enclosed_entities(self, entity):
         """Get entities enclosed by this entity (nested classes, enums, etc.)
         
@@ -2291,6 +2374,7 @@ class MarkdownGenerator(MarkdownGeneratorBase):
             if db:
                 db.close()
                 
+    @traced(category='markdown')
     def _get_entity_mpi_comms(self, entity: Dict[str, Any]) -> Dict[str, bool]:
         """Get MPI communication details for an entity
         
@@ -2309,6 +2393,7 @@ class MarkdownGenerator(MarkdownGeneratorBase):
             "handles_member_reference_through_mpi": False
         }  # Placeholder
         
+    @traced(category='markdown')
     def _get_entity_contributors(self, entity: Dict[str, Any]) -> List[str]:
         """Get list of contributors for an entity from Git history
         
@@ -2374,6 +2459,14 @@ def main():
     parser.add_argument("--project", dest="project_dir", default=None, help="Project directory to filter entities by")
     parser.add_argument("--config", dest="config_path", default=None, help="Path to configuration file")
     parser.add_argument("--version", action="store_true", help="Show version information and exit")
+    parser.add_argument("--trace", type=str, default=None, metavar="OUT.json",
+                        help="Write a Chrome/Perfetto trace of the generation, per page and section")
+    parser.add_argument("--memory", action="store_true",
+                        help="Account RSS and Python allocations of each stage and page into the run_metrics table")
+    parser.add_argument("--sql-profile", action="store_true",
+                        help="Time SQL statements per call site, with their query plans, and report them at exit")
+    parser.add_argument("--metrics-dir", type=str, default=None, metavar="DIR",
+                        help="Write metrics of the run to DIR/foamcd_markdown.prom (OpenMetrics) and .json")
     args = parser.parse_args()
     
     # Version check is handled above, but keep this for completeness
@@ -2381,20 +2474,49 @@ def main():
         logger.info(f"foamCD {get_version()}")
         return 0
     
+    if args.trace:
+        tracer.enable()
+    run_metrics = RunMetrics('markdown')
+    metrics_dir = args.metrics_dir
+    generator = None
+    completed = False
     try:
+        run_started = datetime.now().isoformat(timespec='seconds')
+        file_config = Config(args.config_path) if args.config_path else None
+        if args.sql_profile or (file_config and file_config.get("database.profile", False)):
+            profiler.enable()
+        metrics_dir = metrics_dir or (file_config.get("metrics.export_dir") if file_config else None)
         generator = MarkdownGenerator(
             db_path=args.db_path,
             output_path=args.output_path,
             project_dir=args.project_dir,
             config_path=args.config_path
         )
+        if args.memory or (generator.config and generator.config.get("metrics.memory.enabled", False)):
+            memory.enable(generator.config.get("metrics.memory.frames", 1) if generator.config else 1)
         generator.generate_all()
+        if memory.enabled:
+            top = int(generator.config.get("metrics.memory.top", 10) or 10) if generator.config else 10
+            summary = memory.log_summary(top)
+            generator.db.store_run_metrics(run_started, 'markdown', memory.records, summary['sites'])
+        completed = True
         return 0
     except Exception as e:
         logger.error(f"Error generating markdown: {e}")
         import traceback
         logger.error(traceback.format_exc())
         return 1
+    finally:
+        if args.trace:
+            tracer.write(args.trace, {'command': 'foamcd-markdown', 'version': get_version()})
+        if metrics_dir:
+            if generator is not None:
+                for status, count in generator.page_counts.items():
+                    run_metrics.set('pages', count, "Markdown pages of the run, by outcome", status=status)
+                for stage, seconds in generator.stage_seconds.items():
+                    run_metrics.set_phase(stage, seconds)
+            run_metrics.finish(completed, args.db_path)
+            run_metrics.write(metrics_dir)
 
 
 if __name__ == '__main__':
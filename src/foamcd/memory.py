@@ -0,0 +1,277 @@
+#!/usr/bin/env python3
+
+"""
+Memory accounting per phase of parse runs and markdown generation
+
+Phases (libclang parse, traversal and database write of each translation unit,
+and the stages of markdown generation) record the process's RSS and its
+high-water mark, and the Python heap through tracemalloc: what the phase left
+allocated, and the peak it reached above its starting point. RSS growth with
+little Python growth points at libclang, translation units and token lists;
+Python growth at entities kept in ClangParser.entities or to_dict trees.
+
+At the end of a run, the Python allocations still held are compared to those
+at the start, grouped by the call site which made them, to name what retains
+memory across translation units. Records of parse lanes and workers come back
+to the parent with their trace events.
+
+Accounting is off unless enabled with --memory or metrics.memory.enabled, as
+tracemalloc slows allocation-heavy code down considerably; disabled phases are
+a shared no-op context manager.
+"""
+
+import os
+import time
+import tracemalloc
+from typing import Any, Dict, List, Optional
+
+from .logs import setup_logging
+
+logger = setup_logging()
+
+try:
+    import resource
+except ImportError:  # Not on Windows
+    resource = None
+
+_PAGE_KB = os.sysconf('SC_PAGE_SIZE') // 1024 if hasattr(os, 'sysconf') else 4
+
+
+def current_rss_kb() -> Optional[int]:
+    """Resident set size of this process in KB, None where /proc is not available"""
+    try:
+        with open('/proc/self/statm') as f:
+            return int(f.read().split()[1]) * _PAGE_KB
+    except (OSError, ValueError, IndexError):
+        return None
+
+
+def peak_rss_kb() -> Optional[int]:
+    """RSS high-water mark of this process in KB"""
+    if resource is None:
+        return None
+    return resource.getrusage(resource.RUSAGE_SELF).ru_maxrss
+
+
+class _NullPhase:
+    """Phase of a disabled accounting"""
+
+    def __enter__(self):
+        return self
+
+    def __exit__(self, *exc):
+        return False
+
+
+_NULL_PHASE = _NullPhase()
+
+
+class _Phase:
+    """Memory taken by a phase, recorded when it exits"""
+
+    __slots__ = ('accounting', 'name', 'subject', 'started', 'rss', 'hwm', 'traced', 'peak')
+
+    def __init__(self, accounting: 'MemoryAccounting', name: str, subject: Optional[str]):
+        self.accounting = accounting
+        self.name = name
+        self.subject = subject
+
+    def __enter__(self):
+        stack = self.accounting._stack
+        traced, peak = tracemalloc.get_traced_memory()
+        if stack:
+            # The peak is reset for this phase; the enclosing one keeps what it reached so far
+            stack[-1].peak = max(stack[-1].peak, peak)
+        tracemalloc.reset_peak()
+        stack.append(self)
+        self.rss = current_rss_kb()
+        self.hwm = peak_rss_kb()
+        self.traced = self.peak = traced
+        self.started = time.monotonic()
+        return self
+
+    def __exit__(self, *exc):
+        elapsed = time.monotonic() - self.started
+        traced, peak = tracemalloc.get_traced_memory()
+        peak = max(self.peak, peak)
+        stack = self.accounting._stack
+        stack.pop()
+        if stack:
+            stack[-1].peak = max(stack[-1].peak, peak)
+        rss = current_rss_kb()
+        hwm = peak_rss_kb()
+        self.accounting.records.append({
+            'phase': self.name,
+            'subject': self.subject,
+            'pid': os.getpid(),
+            'seconds': round(elapsed, 6),
+            'rss_kb': rss,
+            'rss_delta_kb': rss - self.rss if rss is not None and self.rss is not None else None,
+            'peak_rss_kb': hwm,
+            'peak_rss_growth_kb': hwm - self.hwm if hwm is not None and self.hwm is not None else None,
+            'py_delta_kb': (traced - self.traced) // 1024,
+            'py_peak_kb': (peak - self.traced) // 1024,
+        })
+        return False
+
+
+class MemoryAccounting:
+    """Collects memory records of this process and of the workers reporting to it"""
+
+    def __init__(self):
+        self.enabled = False
+        self.frames = 1
+        self.records: List[Dict[str, Any]] = []
+        self._stack: List[_Phase] = []
+        self._baseline: Optional[tracemalloc.Snapshot] = None
+        self._worker_sites: Dict[str, List[int]] = {}
+
+    def enable(self, frames: int = 1):
+        """Start tracing Python allocations; forked workers inherit the baseline
+
+        Args:
+            frames: Call-stack depth kept per allocation; deeper groups sites by traceback
+        """
+        self.frames = max(int(frames or 1), 1)
+        if not tracemalloc.is_tracing():
+            tracemalloc.start(self.frames)
+        self.enabled = True
+        self._baseline = tracemalloc.take_snapshot()
+
+    def disable(self):
+        """Stop tracing and drop what was recorded"""
+        if self.enabled and tracemalloc.is_tracing():
+            tracemalloc.stop()
+        self.enabled = False
+        self.records = []
+        self._stack = []
+        self._baseline = None
+        self._worker_sites = {}
+
+    def phase(self, name: str, subject: Optional[str] = None):
+        """Context manager recording the memory taken by a phase
+
+        Args:
+            name: Phase name, as the matching trace span
+            subject: What the phase works on, e.g. the file or page
+        """
+        if not self.enabled:
+            return _NULL_PHASE
+        return _Phase(self, name, subject)
+
+    def retained_sites(self, top: int = 10) -> List[Dict[str, Any]]:
+        """Call sites holding the most Python memory allocated since accounting was enabled
+
+        Sites reported by workers are merged in; they are whatever the workers
+        held when they finished, so sizes add up across processes.
+
+        Args:
+            top: Number of sites to return
+
+        Returns:
+            Sites as {site, size_kb, count}, largest first
+        """
+        sites = {site: list(values) for site, values in self._worker_sites.items()}
+        if self.enabled and self._baseline is not None:
+            for site, size, count in self._own_sites():
+                merged = sites.setdefault(site, [0, 0])
+                merged[0] += size
+                merged[1] += count
+        ranked = sorted(sites.items(), key=lambda item: -item[1][0])[:top]
+        return [{'site': site, 'size_kb': size // 1024, 'count': count} for site, (size, count) in ranked]
+
+    def _own_sites(self):
+        key_type = 'traceback' if self.frames > 1 else 'lineno'
+        snapshot = tracemalloc.take_snapshot().filter_traces([
+            tracemalloc.Filter(False, tracemalloc.__file__),
+            tracemalloc.Filter(False, __file__),
+        ])
+        for stat in snapshot.compare_to(self._baseline, key_type):
+            if stat.size_diff > 0:
+                frames = list(stat.traceback)[::-1][:self.frames]  # Most recent call first
+                site = " <- ".join(f"{frame.filename}:{frame.lineno}" for frame in frames)
+                yield site, stat.size_diff, max(stat.count_diff, 0)
+
+    def drain(self, top: int = 10) -> Dict[str, Any]:
+        """Records and retaining sites so far, removed; workers send these to their parent"""
+        report = {'records': self.records, 'sites': [[site['site'], site['size_kb'] * 1024, site['count']]
+                                                     for site in self.retained_sites(top)]}
+        self.records = []
+        self._worker_sites = {}
+        return report
+
+    def reset_worker(self):
+        """Forget what was inherited from the parent, in a freshly forked worker"""
+        self.records = []
+        self._stack = []
+        self._worker_sites = {}
+        if self.enabled:
+            self._baseline = tracemalloc.take_snapshot()
+
+    def extend(self, report: Optional[Dict[str, Any]]):
+        """Add the records and retaining sites of a worker"""
+        if not self.enabled or not report:
+            return
+        self.records.extend(report.get('records', []))
+        for site, size, count in report.get('sites', []):
+            merged = self._worker_sites.setdefault(site, [0, 0])
+            merged[0] += size
+            merged[1] += count
+
+    def summary(self, top: int = 10) -> Dict[str, Any]:
+        """Totals per phase, the translation units and pages taking the most memory, and retaining sites
+
+        Args:
+            top: Number of subjects and sites listed
+
+        Returns:
+            Dictionary with 'phases', 'subjects', 'sites' and the overall 'peak_rss_kb'
+        """
+        phases: Dict[str, Dict[str, Any]] = {}
+        subjects: Dict[str, Dict[str, Any]] = {}
+        for record in self.records:
+            phase = phases.setdefault(record['phase'], {'count': 0, 'seconds': 0.0, 'py_delta_kb': 0,
+                                                        'py_peak_kb': 0, 'peak_rss_growth_kb': 0})
+            phase['count'] += 1
+            phase['seconds'] += record['seconds']
+            phase['py_delta_kb'] += record['py_delta_kb']
+            phase['py_peak_kb'] = max(phase['py_peak_kb'], record['py_peak_kb'])
+            phase['peak_rss_growth_kb'] += record['peak_rss_growth_kb'] or 0
+            if record['subject']:
+                # The high-water mark of a process only grows, so a subject is charged what it added to it
+                subject = subjects.setdefault(record['subject'], {'peak_rss_growth_kb': 0, 'py_peak_kb': 0})
+                subject['peak_rss_growth_kb'] = max(subject['peak_rss_growth_kb'], record['peak_rss_growth_kb'] or 0)
+                subject['py_peak_kb'] = max(subject['py_peak_kb'], record['py_peak_kb'])
+        heaviest = sorted(subjects.items(),
+                          key=lambda item: (-item[1]['peak_rss_growth_kb'], -item[1]['py_peak_kb']))
+        peaks = [record['peak_rss_kb'] for record in self.records if record['peak_rss_kb'] is not None]
+        return {
+            'peak_rss_kb': max(peaks + [peak_rss_kb() or 0]),
+            'phases': phases,
+            'subjects': [dict(subject=name, **values) for name, values in heaviest[:top]],
+            'sites': self.retained_sites(top),
+        }
+
+    def log_summary(self, top: int = 10) -> Dict[str, Any]:
+        """Log the summary of the run; returns it"""
+        summary = self.summary(top)
+        logger.info(f"Memory: peak RSS {summary['peak_rss_kb'] / 1024:.1f} MB")
+        for name, phase in summary['phases'].items():
+            logger.info(f"  {name}: {phase['count']}x, {phase['seconds']:.2f}s, Python heap "
+                        f"{phase['py_delta_kb'] / 1024:+.1f} MB kept, {phase['py_peak_kb'] / 1024:.1f} MB peak, "
+                        f"RSS high-water mark +{phase['peak_rss_growth_kb'] / 1024:.1f} MB")
+        if summary['subjects']:
+            logger.info("  Heaviest:")
+            for subject in summary['subjects']:
+                logger.info(f"    {subject['subject']}: RSS high-water mark "
+                            f"+{subject['peak_rss_growth_kb'] / 1024:.1f} MB, "
+                            f"{subject['py_peak_kb'] / 1024:.1f} MB Python peak")
+        if summary['sites']:
+            logger.info("  Retaining call sites:")
+            for site in summary['sites']:
+                logger.info(f"    {site['size_kb'] / 1024:.1f} MB in {site['count']} blocks: {site['site']}")
+        return summary
+
+
+# Memory accounting of this process, enabled by the --memory options of the entry points
+memory = MemoryAccounting()
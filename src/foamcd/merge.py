@@ -0,0 +1,87 @@
+#!/usr/bin/env python3
+
+"""
+Combine the databases of a sharded parse run
+
+Each `foamcd-parse --shard I/N` job writes its own database; this merges them
+into one and runs the global resolution passes the shards skipped, once.
+"""
+
+import os
+import sys
+import argparse
+
+from .logs import setup_logging
+from .db import EntityDatabase
+from .config import Config
+from .version import get_version
+
+logger = setup_logging()
+
+
+def merge_shards(output: str, shard_paths, config: Config = None) -> EntityDatabase:
+    """Merge shard databases into the output database and resolve relationships across them
+
+    The output is built from scratch next to it and then moved into place, so merging
+    the shards of a later run drops the entities, files and metrics of the earlier one.
+
+    Args:
+        output: Path to the merged database, replaced if present
+        shard_paths: Paths to the shard databases
+        config: Configuration the shards were parsed with
+
+    Returns:
+        The merged database
+    """
+    from .parse import ClangParser
+
+    building = f"{output}.merging"
+    if os.path.exists(building):
+        os.unlink(building)
+    db = EntityDatabase(building)
+    for path in shard_paths:
+        added = db.merge_database(path)
+        logger.info(f"Merged {path}: {added.get('entities', 0)} entities, {added.get('files', 0)} files")
+
+    parser = ClangParser(db=db, config=config, disable_plugins=True, use_tree_sitter_fallback=False)
+    parser.resolve_scoped_template_functions()
+    parser.resolve_inheritance_relationships()
+    parser.resolve_enclosing_relationships()
+    db.rebuild_base_child_links()
+    db.close()
+    os.replace(building, output)
+    return EntityDatabase(output)
+
+
+def main():
+    """Main entry point for merging shard databases"""
+    parser = argparse.ArgumentParser(description="Merge the databases of a sharded foamCD parse run")
+    parser.add_argument("shards", nargs="*", help="Shard databases, as written by foamcd-parse --shard")
+    parser.add_argument("--output", "-o", type=str, help="Merged SQLite database file, overrides the YAML config")
+    parser.add_argument("--config", "-c", type=str, help="Path to YAML configuration file")
+    parser.add_argument("--verbose", "-v", action="store_true", help="Enable verbose output")
+    parser.add_argument("--version", action="store_true", help="Show version information and exit")
+    args = parser.parse_args()
+
+    if args.version:
+        print(f"foamCD {get_version()}")
+        return 0
+    if not args.shards:
+        parser.error("no shard databases given")
+
+    setup_logging(args.verbose)
+    try:
+        config = Config(args.config)
+        output = args.output or config.get('database.path', 'docs.db')
+        db = merge_shards(output, args.shards, config)
+        db.close()
+        logger.info(f"Merged {len(args.shards)} shards into {output}")
+        return 0
+    except Exception as e:
+        import traceback
+        logger.error(f"Error merging shards: {e}\nTraceback: {traceback.format_exc()}")
+        return 1
+
+
+if __name__ == '__main__':
+    sys.exit(main() or 0)
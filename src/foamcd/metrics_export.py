@@ -0,0 +1,191 @@
+#!/usr/bin/env python3
+
+"""
+Machine-readable metrics of parse and markdown runs
+
+At the end of a run, foamcd-parse and foamcd-markdown can write what the run
+did and cost (files parsed, cached or failed, entities, phase durations,
+database size, pages, peak RSS, cache hit rates) to a directory, as
+foamcd_<command>.prom in the OpenMetrics text format and foamcd_<command>.json.
+Pointing the textfile collector of a node exporter at that directory makes the
+metrics scrapeable without foamCD running any network service.
+
+All metrics describe the last run, so they are gauges. Files are replaced
+atomically, so that a collector never reads a half-written one.
+"""
+
+import os
+import json
+import time
+import tempfile
+from typing import Any, Dict, List, Optional, Tuple
+
+from .logs import setup_logging
+from .memory import peak_rss_kb
+from .version import get_version
+
+logger = setup_logging()
+
+try:
+    import resource
+except ImportError:  # Not on Windows
+    resource = None
+
+
+def _escape_label(value: Any) -> str:
+    return str(value).replace('\\', '\\\\').replace('"', '\\"').replace('\n', '\\n')
+
+
+def _format_value(value: float) -> str:
+    if isinstance(value, bool):
+        return '1' if value else '0'
+    if isinstance(value, int) or float(value).is_integer():
+        return str(int(value))
+    return repr(float(value))
+
+
+class RunMetrics:
+    """Metrics of one run of a command, written when it ends"""
+
+    def __init__(self, command: str):
+        """
+        Args:
+            command: Name of the run's command, 'parse' or 'markdown'
+        """
+        self.command = command
+        self.started = time.time()
+        self._started_monotonic = time.monotonic()
+        # Metric name -> (help text, unit, samples as (labels, value))
+        self.families: Dict[str, Tuple[str, Optional[str], List[Tuple[Dict[str, str], float]]]] = {}
+        self._phase_started: Dict[str, float] = {}
+
+    def set(self, name: str, value: Optional[float], help_text: str, unit: Optional[str] = None, **labels):
+        """Set a sample of a metric, replacing the one with the same labels
+
+        Args:
+            name: Metric name without the foamcd_ prefix; names of metrics with a unit end with it
+            value: Sample value, nothing is recorded if None
+            help_text: Description of the metric, the same for all its samples
+            unit: OpenMetrics unit, e.g. 'seconds' or 'bytes'
+            **labels: Labels of the sample
+        """
+        if value is None:
+            return
+        help_text, unit, samples = self.families.setdefault(f"foamcd_{name}", (help_text, unit, []))
+        labels = {key: str(label) for key, label in labels.items()}
+        samples[:] = [sample for sample in samples if sample[0] != labels]
+        samples.append((labels, value))
+
+    def get(self, name: str, **labels) -> Optional[float]:
+        """Value of a sample, None if not set"""
+        family = self.families.get(f"foamcd_{name}")
+        labels = {key: str(label) for key, label in labels.items()}
+        for sample_labels, value in family[2] if family else []:
+            if sample_labels == labels:
+                return value
+        return None
+
+    def start_phase(self, phase: str):
+        """Start timing a phase of the run, see end_phase"""
+        self._phase_started[phase] = time.monotonic()
+
+    def end_phase(self, phase: str):
+        """Record the duration of a phase started with start_phase"""
+        started = self._phase_started.pop(phase, None)
+        if started is not None:
+            self.set_phase(phase, time.monotonic() - started)
+
+    def set_phase(self, phase: str, seconds: float):
+        """Record the duration of a phase of the run"""
+        self.set('phase_duration_seconds', round(seconds, 6), "Wall-clock time of a phase of the run",
+                 'seconds', phase=phase)
+
+    def set_cache(self, cache: str, hits: int, misses: int):
+        """Record the hits, misses and hit ratio of a cache"""
+        self.set('cache_hits', hits, "Lookups answered by a cache", cache=cache)
+        self.set('cache_misses', misses, "Lookups a cache could not answer", cache=cache)
+        if hits + misses:
+            self.set('cache_hit_ratio', round(hits / (hits + misses), 6),
+                     "Share of the lookups answered by a cache", 'ratio', cache=cache)
+
+    def finish(self, success: bool, db_path: Optional[str] = None):
+        """Record what every run reports: outcome, duration, peak RSS and database size
+
+        Args:
+            success: Whether the run completed
+            db_path: Database of the run, to report its size
+        """
+        self.set('run_info', 1, "Version of foamCD and command of the run",
+                 version=get_version(), command=self.command)
+        self.set('run_success', bool(success), "Whether the run completed")
+        self.set('run_timestamp_seconds', round(self.started, 3), "Unix time the run started", 'seconds')
+        self.set('run_duration_seconds', round(time.monotonic() - self._started_monotonic, 3),
+                 "Wall-clock time of the run", 'seconds')
+        own_peak = peak_rss_kb()
+        if own_peak is not None:
+            self.set('peak_rss_bytes', own_peak * 1024, "RSS high-water mark", 'bytes', process='main')
+            # Parse lanes and workers are waited for, so they count as children
+            children_peak = resource.getrusage(resource.RUSAGE_CHILDREN).ru_maxrss
+            if children_peak:
+                self.set('peak_rss_bytes', children_peak * 1024, "RSS high-water mark", 'bytes',
+                         process='largest_worker')
+        if db_path and os.path.exists(db_path):
+            size = os.path.getsize(db_path)
+            if os.path.exists(db_path + '-wal'):
+                size += os.path.getsize(db_path + '-wal')
+            self.set('database_size_bytes', size, "Size of the SQLite database", 'bytes')
+
+    def to_openmetrics(self) -> str:
+        """Metrics in the OpenMetrics text format"""
+        lines = []
+        for name, (help_text, unit, samples) in self.families.items():
+            lines.append(f"# TYPE {name} gauge")
+            if unit:
+                lines.append(f"# UNIT {name} {unit}")
+            lines.append(f"# HELP {name} {help_text}")
+            for labels, value in samples:
+                label_text = ','.join(f'{key}="{_escape_label(label)}"' for key, label in labels.items())
+                lines.append(f"{name}{{{label_text}}} {_format_value(value)}" if label_text
+                             else f"{name} {_format_value(value)}")
+        lines.append("# EOF")
+        return "\n".join(lines) + "\n"
+
+    def to_dict(self) -> Dict[str, Any]:
+        """Metrics as a JSON-serializable dictionary"""
+        return {
+            'command': self.command,
+            'version': get_version(),
+            'started': self.started,
+            'metrics': {name: {'help': help_text, 'unit': unit,
+                               'samples': [{'labels': labels, 'value': value} for labels, value in samples]}
+                        for name, (help_text, unit, samples) in self.families.items()},
+        }
+
+    def write(self, directory: str) -> bool:
+        """Replace foamcd_<command>.prom and foamcd_<command>.json in a directory
+
+        Returns:
+            True if both files were written
+        """
+        try:
+            os.makedirs(directory, exist_ok=True)
+            base = os.path.join(directory, f"foamcd_{self.command}")
+            _write_atomically(base + '.prom', self.to_openmetrics())
+            _write_atomically(base + '.json', json.dumps(self.to_dict(), indent=2) + "\n")
+            logger.info(f"Wrote run metrics to {base}.prom and {base}.json")
+            return True
+        except OSError as e:
+            logger.error(f"Could not write run metrics to {directory}: {e}")
+            return False
+
+
+def _write_atomically(path: str, text: str):
+    fd, temporary = tempfile.mkstemp(dir=os.path.dirname(path), prefix='.foamcd-metrics-')
+    try:
+        with os.fdopen(fd, 'w') as f:
+            f.write(text)
+        os.chmod(temporary, 0o644)
+        os.replace(temporary, path)
+    except BaseException:
+        os.unlink(temporary)
+        raise
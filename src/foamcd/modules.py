@@ -0,0 +1,232 @@
+#!/usr/bin/env python3
+
+"""
+C++20 named modules: finding module units and prebuilding their interfaces
+
+Translation units importing a module need its built module interface (BMI)
+to parse. Module interface units of the compilation database are found by a
+lexical scan, then built once, in import order, into a foamCD-managed cache
+directory with clang's --precompile. Importers get -fmodule-file= arguments
+for every module they reach.
+
+BMIs are named after a hash of the interface source, its arguments and the
+BMIs it imports, so unchanged interfaces are reused across runs, and parse
+cache keys of importers change whenever an interface they reach does.
+Scan results are kept per modification time and size of each file, so later
+runs only read the files which changed.
+libclang cannot write BMIs itself, so this needs a clang++ matching libclang.
+"""
+
+import os
+import re
+import shutil
+import hashlib
+import subprocess
+from typing import Callable, Dict, List, Optional, Set, Tuple
+
+from .logs import setup_logging
+
+logger = setup_logging()
+
+# Module declarations and imports start a line once comments are stripped;
+# header units (import <vector>;) are left to the preprocessor
+MODULE_DECLARATION = re.compile(r'^\s*(export\s+)?module\s+([\w.]+(?::[\w.]+)?)\s*;', re.MULTILINE)
+MODULE_IMPORT = re.compile(r'^\s*(?:export\s+)?import\s+([\w.]+|:[\w.]+)\s*;', re.MULTILINE)
+COMMENTS = re.compile(r'//[^\n]*|/\*.*?\*/', re.DOTALL)
+
+# Arguments of a compile command which do not apply to building a BMI
+_DROPPED_ARGS = {'-c', '-MD', '-MMD', '-MP'}
+_DROPPED_ARGS_WITH_VALUE = {'-o', '-MF', '-MT', '-MQ', '-x'}
+
+
+def scan_module_unit(path: str) -> Tuple[Optional[str], bool, List[str]]:
+    """Module a source file belongs to, and the modules it imports
+
+    Args:
+        path: Source file
+
+    Returns:
+        Tuple of (module name or None, whether it is an interface unit, imported module names);
+        partitions are named 'module:partition', and implementation units import their module
+    """
+    try:
+        with open(path, 'r', errors='ignore') as f:
+            text = COMMENTS.sub('', f.read())
+    except OSError:
+        return None, False, []
+    declaration = MODULE_DECLARATION.search(text)
+    name = declaration.group(2) if declaration else None
+    is_interface = bool(declaration and declaration.group(1))
+    imports = []
+    for imported in MODULE_IMPORT.findall(text):
+        if imported.startswith(':'):
+            if not name:
+                continue
+            imported = name.split(':')[0] + imported
+        imports.append(imported)
+    if name and not is_interface and ':' not in name:
+        imports.append(name)
+    return name, is_interface, list(dict.fromkeys(imports))
+
+
+def file_stamp(path: str) -> Optional[Tuple[int, int]]:
+    """Modification time and size of a file, under which its scan is reused"""
+    try:
+        stats = os.stat(path)
+    except OSError:
+        return None
+    return stats.st_mtime_ns, stats.st_size
+
+
+def find_module_compiler() -> Optional[str]:
+    """clang++ on PATH to build BMIs with, else the newest versioned one"""
+    for candidate in ['clang++'] + [f"clang++-{version}" for version in range(21, 13, -1)]:
+        path = shutil.which(candidate)
+        if path:
+            return path
+    return None
+
+
+class ModuleCache:
+    """Directory of prebuilt module interfaces for the importers of a run"""
+
+    def __init__(self, cache_dir: str, compiler: Optional[str] = None):
+        self.cache_dir = os.path.abspath(cache_dir)
+        self.compiler = compiler
+        # Module name -> interface unit path, and path -> imported module names
+        self.interfaces: Dict[str, str] = {}
+        self.interface_files: Set[str] = set()
+        self.imports: Dict[str, List[str]] = {}
+        # Module name -> built BMI path
+        self.built: Dict[str, str] = {}
+        self.failed: Set[str] = set()
+        self.builds = 0
+        self.reused = 0
+        # Path -> (file stamp, scan result) of the files read by scan, for later runs
+        self.rescanned: Dict[str, Tuple[Tuple[int, int], Tuple[Optional[str], bool, List[str]]]] = {}
+
+    def scan(self, files: List[str], known: Optional[Dict[str, Tuple[Tuple[int, int], Tuple]]] = None) -> int:
+        """Find the module units among the files of a run
+
+        Args:
+            files: Source files of the run
+            known: Scan results of earlier runs, as in rescanned; files with the same stamp are not read
+
+        Returns:
+            Number of module interface units found
+        """
+        known = known or {}
+        for path in files:
+            path = os.path.realpath(path)
+            stamp = file_stamp(path)
+            previous = known.get(path)
+            if stamp is not None and previous and tuple(previous[0]) == stamp:
+                name, is_interface, imports = previous[1]
+            else:
+                name, is_interface, imports = scan_module_unit(path)
+                if stamp is not None:
+                    self.rescanned[path] = (stamp, (name, is_interface, imports))
+            if is_interface:
+                if name in self.interfaces and self.interfaces[name] != path:
+                    logger.warning(f"Module {name} has interfaces {self.interfaces[name]} and {path}, using the first")
+                    continue
+                self.interfaces[name] = path
+                self.interface_files.add(path)
+            if imports:
+                self.imports[path] = imports
+        return len(self.interfaces)
+
+    def reachable(self, filepath: str) -> List[str]:
+        """Modules a file imports, directly or through other modules, dependencies first"""
+        order = []
+        visiting = set()
+
+        def visit(module):
+            if module in order or module in visiting:
+                return
+            visiting.add(module)
+            interface = self.interfaces.get(module)
+            for dependency in self.imports.get(interface, []) if interface else []:
+                visit(dependency)
+            order.append(module)
+
+        for module in self.imports.get(os.path.realpath(filepath), []):
+            visit(module)
+        return order
+
+    @staticmethod
+    def _build_args(compile_args: List[str]) -> List[str]:
+        args = []
+        skip_next = False
+        for arg in compile_args:
+            if skip_next:
+                skip_next = False
+            elif arg in _DROPPED_ARGS_WITH_VALUE:
+                skip_next = True
+            elif arg not in _DROPPED_ARGS and not arg.startswith('--driver-mode'):
+                args.append(arg)
+        return args
+
+    def build_all(self, args_provider: Callable[[str], List[str]]) -> int:
+        """Build the BMI of every module interface found, dependencies first
+
+        Args:
+            args_provider: Compilation arguments of a file
+
+        Returns:
+            Number of modules with a BMI
+        """
+        if not self.interfaces:
+            return 0
+        if not self.compiler:
+            logger.warning(f"No clang++ found to build the {len(self.interfaces)} module interfaces; "
+                           "set parser.modules.compiler, importers will not find their modules")
+            return 0
+        for module in sorted(self.interfaces):
+            for dependency in self.reachable(self.interfaces[module]) + [module]:
+                if dependency in self.interfaces and dependency not in self.built and dependency not in self.failed:
+                    self._build(dependency, args_provider)
+        logger.info(f"Module interfaces: {self.builds} built, {self.reused} reused from {self.cache_dir}")
+        return len(self.built)
+
+    def _build(self, module: str, args_provider: Callable[[str], List[str]]):
+        self.failed.add(module)
+        source = self.interfaces[module]
+        args = self._build_args(args_provider(source)) + self.importer_args(source)
+        try:
+            with open(source, 'rb') as f:
+                content_hash = hashlib.sha256(f.read()).hexdigest()
+        except OSError as e:
+            logger.error(f"Cannot read module interface {source}: {e}")
+            return
+        key = hashlib.sha256("\n".join([content_hash, self.compiler] + args).encode('utf-8')).hexdigest()
+        bmi = os.path.join(self.cache_dir, f"{module.replace(':', '-')}-{key[:16]}.pcm")
+        if os.path.exists(bmi):
+            self.built[module] = bmi
+            self.failed.discard(module)
+            self.reused += 1
+            return
+        os.makedirs(self.cache_dir, exist_ok=True)
+        temp_bmi = f"{bmi}.{os.getpid()}.tmp"
+        command = [self.compiler, *args, '-x', 'c++-module', '--precompile', source, '-o', temp_bmi]
+        logger.debug(f"Building module {module}: {' '.join(command)}")
+        try:
+            result = subprocess.run(command, capture_output=True, text=True)
+            if result.returncode != 0:
+                logger.error(f"Could not build module {module} from {source}:\n{result.stderr}")
+                return
+            os.replace(temp_bmi, bmi)
+        except OSError as e:
+            logger.error(f"Could not run {self.compiler} for module {module}: {e}")
+            return
+        finally:
+            if os.path.exists(temp_bmi):
+                os.unlink(temp_bmi)
+        self.built[module] = bmi
+        self.failed.discard(module)
+        self.builds += 1
+
+    def importer_args(self, filepath: str) -> List[str]:
+        """-fmodule-file= arguments for the BMIs of the modules a file reaches"""
+        return [f"-fmodule-file={module}={self.built[module]}"
+                for module in self.reachable(filepath) if module in self.built]
@@ -3,14 +3,19 @@
 import os
 import sys
 import hashlib
+import json
 import argparse
 import platform
+import time
+import signal
+import multiprocessing
+from datetime import datetime
 import re
 from pathlib import Path
-from typing import Dict, List, Optional, Set, Any, Union
+from typing import Dict, List, Optional, Set, Any, Tuple, Union
 
 try:
-    from .tree_sitter_subparser import TreeSitterSubparser, is_tree_sitter_available
+    from .tree_sitter_subparser import TreeSitterSubparser, is_tree_sitter_available, extract_skeleton_file
     TREE_SITTER_IMPORT_SUCCESS = True
 except ImportError:
     TREE_SITTER_IMPORT_SUCCESS = False
@@ -21,13 +26,32 @@ from .config import Config
 from .version import get_version
 from .feature_detectors import FeatureDetectorRegistry, DeprecatedAttributeDetector
 from .plugin_system import PluginManager
+from .detector_cache import DetectorCache
+from .macro_index import MacroIndex
+from .scheduler import (schedule_translation_units, report_makespan, parse_shard_spec,
+                        shard_database_path, select_shard)
+from .parse_cache import ParseCache
+from .modules import ModuleCache, find_module_compiler, scan_module_unit
+from .tracing import tracer, traced
+from .memory import memory, current_rss_kb
+from .sql_profile import profiler
+from .metrics_export import RunMetrics
 from clang.cindex import CursorKind
 
 logger = setup_logging()
 
-from .common import CPP_HEADER_EXTENSIONS, CPP_IMPLEM_EXTENSIONS, CPP_FILE_EXTENSIONS
+from .common import CPP_HEADER_EXTENSIONS, CPP_IMPLEM_EXTENSIONS, CPP_FILE_EXTENSIONS, MODULE_INTERFACE_EXTENSIONS
 CURRENT_PARSER = None
 
+# Parse worker outcomes which route a file to the Tree-sitter fallback
+TU_OVER_BUDGET = ('timeout', 'memory', 'crashed')
+TU_WORKER_ERROR = 2
+TU_WORKER_OUT_OF_MEMORY = 3
+
+# Lexical pre-scan of files deciding on their parse options
+PRESCAN_INCLUDE = re.compile(r'^[ \t]*#[ \t]*include[ \t]*([<"])([^>"\n]+)[>"]', re.MULTILINE)
+PRESCAN_IDENTIFIER = re.compile(r'[A-Za-z_][A-Za-z0-9_]*')
+
 def configure_libclang(libclang_path: Optional[str] = None):
     """Configure libclang library path if necessary
     
@@ -117,7 +141,7 @@ if not LIBCLANG_CONFIGURED:
 
 import clang.cindex
 from clang.cindex import CursorKind, TokenKind, TypeKind, AccessSpecifier, LinkageKind
-from .entity import Entity
+from .entity import Entity, PlaceholderEntity
 
 # Map to track C++ language features by version
 CPP_FEATURES = {
@@ -169,12 +193,54 @@ class ClangParser:
         self.index = clang.cindex.Index.create()
         self.entities: Dict[str, List[Entity]] = {}
         self.db = db
+        # Placeholders for entities under parser.prefixes_to_skip, interned run-wide by
+        # USR or qualified name; those met by the current file, and those stored already
+        self._placeholders: Dict[str, PlaceholderEntity] = {}
+        self._tu_placeholders: Dict[str, PlaceholderEntity] = {}
+        self._stored_placeholders: Set[str] = set()
+        
+        # Prebuilt databases of dependencies; their headers are not traversed, and
+        # references into them resolve against their entities
+        self.dependency_dbs = list(self.config.get("parser.dependency_dbs", []) or [])
+        self.dependency_prefixes = [prefix for dependency in self.dependency_dbs
+                                    for prefix in dependency.get('prefixes', [])]
+        if self.db and self.dependency_dbs:
+            self.db.attach_dependencies([dependency['path'] for dependency in self.dependency_dbs])
 
         # TODO: consider adding PARSE_INCOMPLETE dynamically for headers...
         self.tu_options = (
             clang.cindex.TranslationUnit.PARSE_DETAILED_PROCESSING_RECORD |
             clang.cindex.TranslationUnit.PARSE_INCLUDE_BRIEF_COMMENTS_IN_CODE_COMPLETION
         )
+        # Per-file options are picked by a lexical pre-scan, see select_tu_options
+        self.adaptive_tu_options = self.config.get("parser.tu_options.adaptive", True)
+        self.parse_function_bodies = self.config.get("parser.tu_options.function_bodies", True)
+        self._prescan_cache: Dict[str, Tuple[Tuple[float, frozenset], Set[str], List[Tuple[str, bool]]]] = {}
+        
+        self.feature_registry = FeatureDetectorRegistry()
+        self.feature_registry.register_all_detectors()
+        self.available_cursor_kinds = dir(CursorKind)
+        self.detector_cache = None
+        if self.db and self.config.get("parser.detector_cache", True):
+            self.detector_cache = DetectorCache(self.db)
+        
+        # Per-file parse budget; with any limit set, libclang parses run in supervised workers
+        self.tu_timeout = float(self.config.get("parser.tu_budget.timeout", 0) or 0)
+        self.tu_memory_limit_mb = int(self.config.get("parser.tu_budget.memory_limit_mb", 0) or 0)
+        self.in_tu_worker = False
+        # Files which went through the Tree-sitter fallback, for the run metrics
+        self.fallback_count = 0
+        # Retaining call sites parse lanes and workers report with their memory records
+        self.memory_top = int(self.config.get("metrics.memory.top", 10) or 10)
+        parse_cache_dir = self.config.get("parser.parse_cache.dir")
+        self.parse_cache = ParseCache(parse_cache_dir) if parse_cache_dir else None
+        # Journal of the current run (see EntityDatabase.begin_run), None outside of runs
+        self.run_id = None
+        # Prebuilt C++20 module interfaces, see prepare_modules; and the file being parsed
+        self.module_cache = None
+        self._current_file = None
+        # Selected compilation arguments per file, see get_compile_commands
+        self._compile_args_cache: Dict[str, List[str]] = {}
         
         self.use_tree_sitter_fallback = use_tree_sitter_fallback and TREE_SITTER_IMPORT_SUCCESS
         self.tree_sitter_subparser = None
@@ -187,11 +253,12 @@ class ClangParser:
                     logger.warning("Tree-sitter is not available. Fallback parsing is disabled.")
                     self.use_tree_sitter_fallback = False
             except Exception as e:
-                logger.warning(f"Could not initialize Tree-sitter fallback parser: {e}")
+                logger.error(f"Could not initialize Tree-sitter fallback parser: {e}")
                 self.use_tree_sitter_fallback = False
         
         # Initialize plugin system if not disabled
         self.disable_plugins = disable_plugins
+        self.deferred_plugin_results: List[Tuple[Entity, List[Tuple[str, Any]], Optional[str]]] = []
         if not disable_plugins:
             if plugin_dirs is None and self.config:
                 plugin_dirs = self.config.get("parser.plugin_dirs", [])
@@ -199,6 +266,7 @@ class ClangParser:
             if self.config:
                 plugin_config = self.config.get("parser.plugins", {})
             self.plugin_manager = PluginManager(plugin_dirs, plugin_config)
+            self.plugin_manager.compile_args_provider = self.get_compile_commands
             self.plugin_manager.discover_plugins()
             plugin_count = len(self.plugin_manager.detectors)
             if plugin_count > 0:
@@ -227,29 +295,70 @@ class ClangParser:
         relative paths absolute based on the 'directory' field in the database entry.
 
         Why? because that's the current format of Bear's compile_commands.json files.
+        
+        Files with several compile commands get the arguments of one of them, see
+        select_compile_command. Arguments are worked out once per file and run; callers
+        get their own copy.
+        """
+        cached_args = self._compile_args_cache.get(filepath)
+        if cached_args is None:
+            cached_args = self._resolve_compile_commands(filepath)
+            self._compile_args_cache[filepath] = cached_args
+        return list(cached_args)
+    
+    def select_compile_command(self, filepath: str, commands) -> List[str]:
+        """Arguments of the compile command a file is parsed with
+        
+        Commands differing only in output and dependency files are one configuration.
+        Among distinct configurations, those with more of parser.compile_commands.prefer
+        flags win, then parser.compile_commands.select decides: 'first' or 'last' in the
+        compilation database, or 'most_flags'.
+        
+        Args:
+            filepath: Source file
+            commands: Its compile commands from the compilation database
+            
+        Returns:
+            Arguments of the selected command, without the compiler, or an empty list
         """
+        configurations: Dict[Tuple[str, ...], List[str]] = {}
+        for command in commands:
+            args = _command_arguments(command)
+            if args:
+                configurations.setdefault(tuple(_semantic_compile_flags(args, filepath)), args)
+        if not configurations:
+            return []
+        candidates = list(configurations.items())
+        if len(candidates) == 1:
+            return candidates[0][1]
+        
+        policy = self.config.get('parser.compile_commands.select', 'first')
+        if policy not in ('first', 'last', 'most_flags'):
+            logger.warning(f"Unknown parser.compile_commands.select '{policy}', using 'first'")
+            policy = 'first'
+        prefer = list(self.config.get('parser.compile_commands.prefer', []) or [])
+        
+        def rank(item):
+            index, (flags, _) = item
+            preferred = sum(1 for flag in prefer if flag in flags)
+            if policy == 'last':
+                return (-preferred, -index)
+            if policy == 'most_flags':
+                return (-preferred, -len(flags), index)
+            return (-preferred, index)
+        
+        index, (flags, args) = min(enumerate(candidates), key=rank)
+        logger.info(f"{filepath} has {len(candidates)} compile configurations, parsing configuration "
+                    f"{index + 1} ({policy}{', preferring ' + ' '.join(prefer) if prefer else ''})")
+        return args
+    
+    def _resolve_compile_commands(self, filepath: str) -> List[str]:
+        """Compilation arguments of a file, see get_compile_commands"""
         try:
             if hasattr(self, 'compilation_database'):
                 commands = self.compilation_database.getCompileCommands(filepath)
                 if commands:
-                    all_args = []
-                    for command in commands:
-                        try:
-                            command_dir = command.directory if hasattr(command, 'directory') else None
-                            if hasattr(command, 'arguments') and isinstance(command.arguments, list):
-                                args = command.arguments[1:] if len(command.arguments) > 1 else []
-                                if command_dir:
-                                    args = [_normalize_path_in_argument(arg, command_dir) for arg in args]
-                                all_args.extend(args)
-                            elif hasattr(command, 'arguments'):
-                                args = list(command.arguments)
-                                if args and len(args) > 1:
-                                    args = args[1:]
-                                    if command_dir:
-                                        args = [_normalize_path_in_argument(arg, command_dir) for arg in args]
-                                    all_args.extend(args)
-                        except (IndexError, TypeError) as e:
-                            logger.debug(f"Could not extract arguments from command: {e}")
+                    all_args = self.select_compile_command(filepath, commands)
                     if all_args:
                         # add include paths from config, eg. to point to clang sys-includes
                         # also, remove the source file from the arguments, will be replaced 
@@ -366,6 +475,18 @@ class ClangParser:
             except Exception as e:
                 logger.debug(f"Error manually extracting comment: {e}")
         
+        return self._clean_doc_comment(raw_comment)
+    
+    @staticmethod
+    def _clean_doc_comment(raw_comment: str) -> str:
+        """Strip comment markers from a raw comment
+        
+        Args:
+            raw_comment: Comment text as found in the source
+            
+        Returns:
+            Cleaned comment string
+        """
         if not raw_comment:
             return ""
         lines = raw_comment.split('\n')
@@ -404,12 +525,20 @@ class ClangParser:
         # Get token information once for efficiency
         all_token_spellings = [t.spelling for t in cursor.get_tokens()]
         all_token_text = ' '.join(all_token_spellings)
-        available_cursor_kinds = dir(CursorKind)
+        available_cursor_kinds = self.available_cursor_kinds
+        
+        # Results of unchanged entities come from the detector cache
+        fingerprint = cached = fresh = None
+        if self.detector_cache:
+            fingerprint = DetectorCache.fingerprint(cursor, all_token_text)
+            cached = self.detector_cache.lookup(fingerprint)
+            fresh = {}
         
         # Detect standard C++ features
-        registry = FeatureDetectorRegistry()
-        registry.register_all_detectors()
-        features = registry.detect_features(cursor, all_token_spellings, all_token_text, available_cursor_kinds)
+        registry = self.feature_registry
+        with tracer.timed('detection'):
+            features = registry.detect_features(cursor, all_token_spellings, all_token_text, available_cursor_kinds,
+                                                cached, fresh)
         
         # Set is_deprecated flag if we see the C++14 [[deprecated]] attribute
         if entity and 'deprecated_attribute' in features:
@@ -430,9 +559,10 @@ class ClangParser:
             global CURRENT_PARSER
             CURRENT_PARSER = self
             
-            dsl_result = self.plugin_manager.detect_features(
-                cursor, all_token_spellings, all_token_text, available_cursor_kinds
-            )
+            with tracer.timed('plugins'):
+                dsl_result = self.plugin_manager.detect_features(
+                    cursor, all_token_spellings, all_token_text, available_cursor_kinds, cached, fresh
+                )
             
             # Add DSL features to the set
             if dsl_result['features']:
@@ -442,9 +572,62 @@ class ClangParser:
             # Add custom fields to the entity if provided
             if entity and dsl_result['custom_fields']:
                 entity.custom_fields.update(dsl_result['custom_fields'])
+            
+            # Results some plugins batch until the end of the translation unit
+            if entity and dsl_result.get('deferred'):
+                self.deferred_plugin_results.append((entity, dsl_result['deferred'], fingerprint))
         
+        if fresh:
+            self.detector_cache.record(fingerprint, fresh)
         return features
 
+    def _resolve_deferred_plugin_results(self):
+        """Resolve plugin results deferred during the traversal of a translation unit
+        
+        Plugins get all their deferred keys in one batch and the outcome is merged
+        into the entities' features and custom fields before they are stored.
+        """
+        if not self.deferred_plugin_results:
+            return
+        pending = self.deferred_plugin_results
+        self.deferred_plugin_results = []
+        resolved = self.plugin_manager.resolve_deferred(
+            [item for _, deferred, _ in pending for item in deferred]
+        )
+        for entity, deferred, fingerprint in pending:
+            fresh = {}
+            for item in deferred:
+                result = resolved.get(item)
+                if not result:
+                    continue
+                entity.cpp_features.update(result['features'])
+                entity.custom_fields.update(result['custom_fields'])
+                detector = self.plugin_manager.get_detector(item[0])
+                if fingerprint and detector and detector.cacheable:
+                    fresh[item[0]] = (detector.version, detector.cache_value({
+                        'detected': item[0] in result['features'],
+                        'fields': result['custom_fields']
+                    }))
+            if fresh:
+                self.detector_cache.record(fingerprint, fresh)
+        logger.debug(f"Resolved {len(resolved)} deferred plugin results")
+
+    def record_plugin_stats(self, run_started: str):
+        """Store plugin timings and circuit breaker trips of this run in the database
+        
+        Args:
+            run_started: ISO timestamp identifying the run
+        """
+        if self.disable_plugins or not hasattr(self, 'plugin_manager'):
+            return
+        stats = self.plugin_manager.get_run_stats()
+        for name, detector_stats in stats.items():
+            if detector_stats['state'] != 'active':
+                logger.warning(f"DSL detector {name} was {detector_stats['state']} ({detector_stats['reason']}), "
+                               f"skipped on {detector_stats['skipped']} cursors")
+        if self.db and stats:
+            self.db.store_detector_run_stats(run_started, stats)
+
     def _get_access_specifier(self, cursor):
         """Get the access specifier (public, protected, private) of a cursor within a class
         
@@ -550,23 +733,33 @@ class ClangParser:
             return None
             
     def _create_placeholder_entity(self, cursor: clang.cindex.Cursor, parent: Optional[Entity] = None) -> Optional[Entity]:
-        """Create a placeholder entity for external references (e.g., standard library)
+        """Get the placeholder entity for an external reference (e.g., standard library)
         
-        This creates a minimal entity with just enough information to serve as a reference.
-        It doesn't recursively process the entity's children or extract detailed information.
+        Placeholders carry just enough information to serve as a reference, without
+        processing the entity's children or details. They are interned for the whole
+        run: every reopening of namespace std, in any file, yields the same one.
         Users choose which entities are treated this way, mainly for performance reasons.
         """
         if not cursor.location.file:
             return None
-            
+        
+        key = cursor.get_usr()
+        if not key:
+            key = f"{cursor.kind.name}:{self._get_namespace_path(cursor)}::{cursor.spelling}"
+        if parent is not None:
+            key += f":{parent.uuid}"
+        entity = self._placeholders.get(key)
+        if entity is not None:
+            return entity
         file_path = os.path.realpath(cursor.location.file.name)
         location = (file_path, cursor.location.line, cursor.location.column, 
                   cursor.location.line, cursor.location.column)
-        entity = Entity(cursor.spelling, cursor.kind, location, "", parent)
+        entity = PlaceholderEntity(cursor.spelling, cursor.kind, location, key, parent)
         entity.access = cursor.access_specifier
+        entity.namespace = self._get_namespace_path(cursor)
         if cursor.type and cursor.type.spelling:
             entity.type_info = cursor.type.spelling
-        entity.is_external_reference = True
+        self._placeholders[key] = entity
         return entity
         
     def _create_entity(self, cursor: clang.cindex.Cursor, parent: Optional[Entity] = None) -> Optional[Entity]:
@@ -944,6 +1137,10 @@ class ClangParser:
             simple_name = simple_name[namespace_pos + 2:]
         
         found = False
+        dependency_uuid = self._find_dependency_base(cursor)
+        if dependency_uuid:
+            base_class_info['uuid'] = dependency_uuid
+            return base_class_info
         for _, entities in self.entities.items():
             for entity in entities:
                 if entity.name == base_class_name:
@@ -975,6 +1172,28 @@ class ClangParser:
                 
         return base_class_info
         
+    def _find_dependency_base(self, cursor: clang.cindex.Cursor) -> Optional[str]:
+        """UUID of a base class declared in a dependency's headers, from the dependency's database"""
+        if not self.db or not self.dependency_prefixes:
+            return None
+        declaration = cursor.type.get_declaration()
+        if declaration.kind == CursorKind.NO_DECL_FOUND or not declaration.location.file:
+            # Dependent bases, like fvPatchField<Type>, only reference their template
+            references = [child.referenced for child in cursor.get_children()
+                          if child.kind in (CursorKind.TEMPLATE_REF, CursorKind.TYPE_REF)]
+            declaration = references[0] if references else None
+        if not declaration or not declaration.location.file:
+            return None
+        file_path = os.path.realpath(declaration.location.file.name)
+        if not any(file_path.startswith(prefix) for prefix in self.dependency_prefixes):
+            return None
+        uuid = self.db.find_dependency_class(declaration.spelling, self._get_namespace_path(declaration))
+        if uuid:
+            logger.debug(f"Found base class {declaration.spelling} with UUID {uuid} in a dependency database")
+        else:
+            logger.debug(f"Base class {declaration.spelling} from {file_path} is not in its dependency database")
+        return uuid
+    
     def parse_file(self, filepath: str, force_tree_sitter: bool = False) -> List[Entity]:
         """Parse a C++ file and return its entities
         
@@ -985,21 +1204,42 @@ class ClangParser:
         Returns:
             List of entity objects extracted from the file
         """
-        compile_args = self.get_compile_commands(filepath)
+        with tracer.span('translation unit', 'tu', file=filepath), memory.phase('translation unit', filepath):
+            return self._parse_file(filepath, force_tree_sitter)
+    
+    def _unchanged_file_entities(self, filepath: str, last_modified: int, file_hash: str) -> Optional[List[Any]]:
+        """Stored entities of a file unchanged since its last parse, None if it has to be parsed"""
+        if self.db.file_changed(filepath, last_modified, file_hash):
+            return None
+        cached_entities = self.db.get_entities_by_file(filepath)
+        if not cached_entities:
+            return None
+        logger.info(f"Using cached entities for {filepath} (unchanged)")
+        self.entities[filepath] = cached_entities
+        if self.run_id is not None:
+            self.db.journal_tu(self.run_id, filepath, 'done')
+        return cached_entities
+    
+    def _parse_file(self, filepath: str, force_tree_sitter: bool = False) -> List[Entity]:
+        """Body of parse_file, see there"""
+        if (self.tu_timeout > 0 or self.tu_memory_limit_mb > 0) and self.db and hasattr(os, 'fork') \
+                and not force_tree_sitter and not self.in_tu_worker:
+            return self._parse_file_supervised(filepath)
+        with tracer.span('compile args'):
+            compile_args = self.get_compile_commands(filepath)
         if self.db:
             file_stats = os.stat(filepath)
             last_modified = int(file_stats.st_mtime)
             with open(filepath, 'rb') as f:
                 file_content = f.read()
                 file_hash = hashlib.md5(file_content).hexdigest()
-            if not self.db.file_changed(filepath, last_modified, file_hash):
-                cached_entities = self.db.get_entities_by_file(filepath)
-                if cached_entities:
-                    logger.info(f"Using cached entities for {filepath} (unchanged)")
-                    self.entities[filepath] = cached_entities
-                    return cached_entities
+            cached_entities = self._unchanged_file_entities(filepath, last_modified, file_hash)
+            if cached_entities:
+                return cached_entities
             self.db.clear_file_entities(filepath)
             self.db.track_file(filepath, last_modified, file_hash)
+        parse_started = time.monotonic()
+        parse_rss = current_rss_kb()
         
         extension = os.path.splitext(filepath)[1].lower()
         if extension in CPP_FILE_EXTENSIONS and '-x' not in compile_args:
@@ -1011,15 +1251,34 @@ class ClangParser:
         for arg in compile_args:
             if arg != filepath and not arg.endswith(filepath):
                 clean_args.append(arg)
+        if self.module_cache:
+            clean_args.extend(self.module_cache.importer_args(filepath))
+        self._current_file = os.path.realpath(filepath)
                 
+        cache_key = None
+        if self.parse_cache and self.db and not force_tree_sitter:
+            cache_key = self._parse_cache_key(filepath, file_hash, clean_args)
+            cached_batch = self.parse_cache.lookup(cache_key)
+            if cached_batch is not None:
+                return self._replay_cached_batch(filepath, file_hash, cached_batch)
+        
         logger.info(f"Parsing {filepath} with args: {clean_args}")
         
         use_fallback = force_tree_sitter
         libclang_error = None
         if not force_tree_sitter:
             try:
+                tu_options = self.select_tu_options(filepath, clean_args)
+                if self.db:
+                    self.db.set_file_tu_options(filepath, tu_options)
                 logger.debug(f"parsing translation unit {filepath} with index.parse")
-                translation_unit = self.index.parse(filepath, clean_args, options=self.tu_options)
+                with tracer.span('libclang parse'), memory.phase('libclang parse', filepath):
+                    translation_unit = self.index.parse(filepath, clean_args, options=tu_options)
+            except MemoryError:
+                if self.in_tu_worker:
+                    raise  # Reported to the supervisor, which reroutes the file
+                logger.error(f"Out of memory while parsing {filepath}")
+                use_fallback = True
             except Exception as e:
                 import traceback
                 libclang_error = e
@@ -1027,34 +1286,46 @@ class ClangParser:
                 use_fallback = True
             
         if use_fallback and self.use_tree_sitter_fallback and self.tree_sitter_subparser:
+            self.fallback_count += 1
             logger.info(f"Heavy-duty macro code? But that is OK, trying a fail-tolerant alternative...")
             logger.info(f"Trying Tree-sitter fallback for {filepath} after libclang error: {libclang_error}")
             try:
-                tree_sitter_result = self.tree_sitter_subparser.parse_file(filepath)
-                file_entities = self._convert_tree_sitter_result(tree_sitter_result, filepath)
+                with tracer.span('tree-sitter parse'):
+                    tree_sitter_result = self.tree_sitter_subparser.parse_file(filepath)
+                    file_entities = self._convert_tree_sitter_result(tree_sitter_result, filepath)
                 if file_entities:
                     logger.info(f"Successfully parsed {len(file_entities)} entities with Tree-sitter fallback")
                     self.entities[filepath] = file_entities
                     if self.db:
-                        for entity in file_entities:
-                            if not self._should_skip_entity(entity):
-                                self.db.store_entity(entity.to_dict())
-                            else:
-                                logger.debug(f"Skipped storing entity {entity.name} to database (matches skip pattern)")
+                        with self.db.atomic():
+                            for entity in file_entities:
+                                if not self._should_skip_entity(entity):
+                                    self.db.store_entity(entity.to_dict())
+                                else:
+                                    logger.debug(f"Skipped storing entity {entity.name} to database (matches skip pattern)")
+                            if self.run_id is not None:
+                                self.db.journal_tu(self.run_id, filepath, 'done')
                     return file_entities
                 else:
                     logger.warning(f"No entities extracted with Tree-sitter fallback")
             except Exception as fallback_e:
                 logger.error(f"Tree-sitter fallback also failed for {filepath}: {fallback_e}")
+            self._journal_parse_failure(filepath)
             return []
             
         if use_fallback:
+            self._journal_parse_failure(filepath)
             return []
         try:
             if translation_unit is None:
                 import traceback
                 logger.error(f"Error parsing {filepath}: Translation unit is None\nTraceback: {traceback.format_exc()}")
+                self._journal_parse_failure(filepath)
                 return []
+            includes = []
+            if self.db:
+                includes = self._translation_unit_includes(filepath, translation_unit)
+                self._store_tu_includes(filepath, includes)
                 
             if len(translation_unit.diagnostics) > 0:
                 error_count = 0
@@ -1082,24 +1353,74 @@ class ClangParser:
                     logger.error(f"Parsing diagnostics for {filepath}: {error_count} errors, {warning_count} warnings, {note_count} notes")
                     if error_count > 0:
                         logger.error(f"Error parsing {filepath}: Failed to parse translation unit due to compilation errors.")
+                        if self.db and not self.in_tu_worker:
+                            self._record_tu_cost(filepath, file_hash, self._tu_cost(parse_started, parse_rss), 'error')
+                        self._journal_parse_failure(filepath)
                         return []
                 elif warning_count > 0:
                     logger.warning(f"Parsing diagnostics for {filepath}: {warning_count} warnings, {note_count} notes")
             
             cursor = translation_unit.cursor
             file_entities = []
-            self._process_cursor(cursor, file_entities)
+            self._tu_placeholders = {}
+            with tracer.span('traverse') as traversal, memory.phase('traverse', filepath):
+                if not self.disable_plugins:
+                    macro_names = self.plugin_manager.macro_names()
+                    if macro_names and tu_options & clang.cindex.TranslationUnit.PARSE_DETAILED_PROCESSING_RECORD:
+                        self.plugin_manager.set_macro_index(MacroIndex.build(translation_unit, macro_names))
+                self._process_cursor(cursor, file_entities)
+                if not self.disable_plugins:
+                    with tracer.timed('plugins'):
+                        self._resolve_deferred_plugin_results()
+                    self.plugin_manager.set_macro_index(None)
+                traversal.set(entities=len(file_entities), **tracer.take_totals())
             self.entities[filepath] = file_entities
             
             if self.db:
-                # First store all entities
-                for entity in file_entities:
-                    if not self._should_skip_entity(entity):
-                        self.db.store_entity(entity.to_dict())
-                    else:
-                        logger.debug(f"Skipped storing entity {entity.name} to database (matches skip pattern)")
-                self._find_and_link_declarations_definitions(cursor, filepath)
-                self._store_member_type_aliases(file_entities)
+                # Everything about the file is committed at once, with its journal record
+                with tracer.span('db write'), memory.phase('db write', filepath), self.db.atomic():
+                    # First store all entities
+                    stored_entities = []
+                    for entity in file_entities:
+                        if not self._should_skip_entity(entity):
+                            entity_dict = entity.to_dict()
+                            self.db.store_entity(entity_dict)
+                            stored_entities.append(entity_dict)
+                        else:
+                            logger.debug(f"Skipped storing entity {entity.name} to database (matches skip pattern)")
+                    # Skeleton rows from a quick pass which did not coincide with a parsed entity
+                    covered_files = {os.path.realpath(filepath)} | {entity.file for entity in file_entities}
+                    for covered_file in covered_files:
+                        self.db.clear_skeleton_entities(covered_file)
+                    links = self._find_and_link_declarations_definitions(cursor, filepath)
+                    type_aliases = self._store_member_type_aliases(file_entities)
+                    cost = self._tu_cost(parse_started, parse_rss)
+                    if cache_key:
+                        # Placeholders stored by earlier files are part of the entry too
+                        stored_uuids = {entity['uuid'] for entity in stored_entities}
+                        placeholders = [placeholder.to_dict() for uuid, placeholder in self._tu_placeholders.items()
+                                        if uuid not in stored_uuids and placeholder.parent is None]
+                        self.parse_cache.store(cache_key, includes, {
+                            'entities': [_compact_entity_dict(entity) for entity in stored_entities] + placeholders,
+                            'covered_files': sorted(covered_files),
+                            'links': links,
+                            'type_aliases': type_aliases,
+                            'includes': includes,
+                            'duration': cost[0],
+                            'rss_kb': cost[1],
+                        })
+                    if self.detector_cache:
+                        self.detector_cache.flush()
+                    if not self.in_tu_worker:
+                        self._record_tu_cost(filepath, file_hash, cost, 'ok')
+                    if self.run_id is not None:
+                        self.db.journal_tu(self.run_id, filepath, 'done')
+                self._stored_placeholders.update(self._tu_placeholders)
+        except MemoryError:
+            if self.in_tu_worker:
+                raise
+            logger.error(f"Out of memory while processing file {filepath}")
+            return []
         except Exception as e:
             import traceback
             logger.error(f"Error processing file {filepath}: {e}\nTraceback: {traceback.format_exc()}")
@@ -1108,6 +1429,452 @@ class ClangParser:
         logger.info(f"Successfully parsed {len(file_entities)} top-level entities")
         return file_entities
         
+    def prepare_modules(self, files: List[str], importers: Optional[List[str]] = None) -> int:
+        """Build the interfaces of the C++20 modules among the files of a run, for their importers
+        
+        Module interfaces are built once, dependencies first, into parser.modules.cache_dir;
+        files parsed afterwards get the interfaces of the modules they import. Scan results
+        are kept in the database, so only files changed since the last run are read.
+        
+        Args:
+            files: All source files of the run
+            importers: Files about to be parsed, if not all of them; nothing is scanned
+                       unless one of these imports a module
+            
+        Returns:
+            Number of module interfaces built or reused
+        """
+        if not self.config.get('parser.modules.enabled', True):
+            return 0
+        if importers is not None and not any(scan_module_unit(path)[2] for path in importers):
+            return 0
+        cache_dir = self.config.get('parser.modules.cache_dir')
+        if not cache_dir:
+            base_dir = os.path.dirname(self.db.db_path) if self.db else os.getcwd()
+            cache_dir = os.path.join(base_dir, '.foamcd-modules')
+        compiler = self.config.get('parser.modules.compiler')
+        if not compiler:
+            compiler = find_module_compiler()
+        module_cache = ModuleCache(cache_dir, compiler)
+        interface_count = module_cache.scan(files, self.db.get_module_scans() if self.db else None)
+        if self.db and module_cache.rescanned:
+            self.db.store_module_scans(module_cache.rescanned)
+        if not interface_count:
+            return 0
+        self.module_cache = module_cache
+        return module_cache.build_all(self.get_compile_commands)
+    
+    def _translation_unit_includes(self, filepath: str, translation_unit) -> List[str]:
+        """Real paths of all headers a translation unit includes"""
+        try:
+            return sorted({os.path.realpath(inclusion.include.name) for inclusion in translation_unit.get_includes()})
+        except Exception as e:
+            logger.debug(f"Could not list the includes of {filepath}: {e}")
+            return []
+
+    def _store_tu_includes(self, filepath: str, includes: List[str]):
+        """Record the headers a translation unit includes from outside parser.prefixes_to_skip"""
+        prefixes_to_skip = self.config.get('parser.prefixes_to_skip', [])
+        includes = [include for include in includes if not any(include.startswith(prefix) for prefix in prefixes_to_skip)]
+        self.db.store_tu_includes(os.path.realpath(filepath), includes)
+
+    def _parse_cache_key(self, filepath: str, file_hash: str, compile_args: List[str]) -> str:
+        """Key of a file in the parse cache, see ParseCache"""
+        detectors = [f"{name}:{detector.version}" for name, detector in self.feature_registry.detectors.items()]
+        if not self.disable_plugins:
+            detectors += [f"{name}:{detector.version}" for name, detector in self.plugin_manager.detectors.items()]
+        # Output options do not change what the parser sees
+        args = []
+        skip_next = False
+        for arg in compile_args:
+            if skip_next:
+                skip_next = False
+            elif arg in ('-o', '-MF', '-MT', '-MQ'):
+                skip_next = True
+            elif arg not in ('-c', '-MD', '-MMD'):
+                args.append(arg)
+        return ParseCache.digest(json.dumps({
+            'version': get_version(),
+            'file': os.path.realpath(filepath),
+            'content': file_hash,
+            'args': args,
+            'detectors': sorted(detectors),
+            'settings': {key: self.config.get(f"parser.{key}") for key in
+                         ('prefixes_to_skip', 'entities_to_skip', 'tu_options', 'dependency_dbs')},
+        }, sort_keys=True, default=str))
+
+    def _replay_cached_batch(self, filepath: str, file_hash: str, batch: Dict[str, Any]) -> List[Dict[str, Any]]:
+        """Store the entity batch of a parse cache hit, as parse_file would have"""
+        logger.info(f"Using parse cache entry for {filepath}")
+        try:
+            with self.db.atomic():
+                self._store_tu_includes(filepath, batch['includes'])
+                if not self.in_tu_worker:
+                    # The cost of parsing the file, should the next run miss the cache
+                    self._record_tu_cost(filepath, file_hash, (batch['duration'], batch['rss_kb']), 'ok')
+                for entity in batch['entities']:
+                    self.db.store_entity(entity)
+                for covered_file in batch['covered_files']:
+                    self.db.clear_skeleton_entities(covered_file)
+                for decl_uuid, def_uuid in batch['links']:
+                    self.db.link_declaration_definition(decl_uuid, def_uuid)
+                for type_alias in batch['type_aliases']:
+                    self.db.store_class_member_type(**type_alias)
+                if self.run_id is not None:
+                    self.db.journal_tu(self.run_id, filepath, 'done')
+        except Exception as e:
+            logger.error(f"Error storing the cached entities of {filepath}: {e}")
+            return []
+        self.entities[filepath] = batch['entities']
+        return batch['entities']
+
+    def _journal_parse_failure(self, filepath: str):
+        """Mark a file no parser could read as failed in the run journal
+        
+        Files whose entities could not be stored stay pending, so that --resume retries them.
+        """
+        if self.db and self.run_id is not None:
+            self.db.journal_tu(self.run_id, filepath, 'failed')
+
+    def _tu_cost(self, started: float, started_rss: Optional[int]) -> Tuple[float, Optional[int]]:
+        """Duration of a parse in this process, and the RSS it added, while its translation unit is loaded
+
+        The process' RSS high-water mark only ever grows across files, so the file's own
+        growth of the current RSS is measured instead.
+        """
+        rss = current_rss_kb()
+        rss_kb = max(rss - started_rss, 0) if rss is not None and started_rss is not None else None
+        return time.monotonic() - started, rss_kb
+
+    def _record_tu_cost(self, filepath: str, file_hash: str, cost: Tuple[float, Optional[int]], status: str):
+        """Record the parse cost of a file parsed in this process, for scheduling later runs"""
+        duration, rss_kb = cost
+        self.db.store_tu_stats(os.path.realpath(filepath), file_hash, duration, rss_kb, status, 'libclang')
+
+    def select_tu_options(self, filepath: str, compile_args: List[str]) -> int:
+        """Pick the libclang parse options a file needs
+        
+        The detailed processing record is only requested when a lexical scan of the
+        file and the project headers it includes finds calls to macros plugins want
+        indexed; detectors fall back to their token streams otherwise. Function bodies
+        are skipped when body-level feature detection is turned off.
+        
+        Args:
+            filepath: Path to the file to parse
+            compile_args: Compilation arguments the file is parsed with
+            
+        Returns:
+            Bitmask of TranslationUnit parse options
+        """
+        TU = clang.cindex.TranslationUnit
+        if not self.adaptive_tu_options:
+            options = self.tu_options
+        else:
+            options = self.tu_options & ~TU.PARSE_DETAILED_PROCESSING_RECORD
+            macro_names = self.plugin_manager.macro_names() if not self.disable_plugins else set()
+            if macro_names and self._prescan_finds(filepath, compile_args, macro_names):
+                options |= TU.PARSE_DETAILED_PROCESSING_RECORD
+        if not self.parse_function_bodies:
+            options |= TU.PARSE_SKIP_FUNCTION_BODIES
+        names = [name for name in ('DETAILED_PROCESSING_RECORD', 'INCLUDE_BRIEF_COMMENTS_IN_CODE_COMPLETION',
+                                   'SKIP_FUNCTION_BODIES') if options & getattr(TU, f"PARSE_{name}")]
+        logger.debug(f"Parse options for {filepath}: {' | '.join(names) or 'NONE'}")
+        return options
+
+    def _prescan_finds(self, filepath: str, compile_args: List[str], names: Set[str]) -> bool:
+        """Whether any of the names appears in a file or in the headers it includes
+        
+        Includes are followed through the file's folder and the -I folders of its
+        compilation arguments, except those under parser.prefixes_to_skip, since
+        entities from there are not processed anyway.
+        """
+        include_dirs = [arg[2:] for arg in compile_args if arg.startswith('-I') and len(arg) > 2]
+        include_dirs += [compile_args[i + 1] for i, arg in enumerate(compile_args[:-1]) if arg in ('-I', '-isystem')]
+        include_dirs = [os.path.realpath(d) for d in include_dirs]
+        prefixes_to_skip = self.config.get('parser.prefixes_to_skip', [])
+        pending = [os.path.realpath(filepath)]
+        seen = set(pending)
+        while pending:
+            current = pending.pop()
+            found, includes = self._prescan_file(current, names)
+            if found:
+                logger.debug(f"Pre-scan of {filepath} found macros {sorted(found)} in {current}")
+                return True
+            for include, quoted in includes:
+                search_dirs = ([os.path.dirname(current)] if quoted else []) + include_dirs
+                for directory in search_dirs:
+                    candidate = os.path.realpath(os.path.join(directory, include))
+                    if os.path.isfile(candidate):
+                        if candidate not in seen and not any(candidate.startswith(p) for p in prefixes_to_skip):
+                            seen.add(candidate)
+                            pending.append(candidate)
+                        break
+        return False
+
+    def _prescan_file(self, path: str, names: Set[str]) -> Tuple[Set[str], List[Tuple[str, bool]]]:
+        """Which of the names a file mentions, and its #include directives; cached per modification time"""
+        try:
+            mtime = os.stat(path).st_mtime
+        except OSError:
+            return set(), []
+        cached = self._prescan_cache.get(path)
+        if cached and cached[0] == (mtime, names):
+            return cached[1], cached[2]
+        try:
+            with open(path, 'r', errors='ignore') as f:
+                text = f.read()
+        except OSError:
+            return set(), []
+        identifiers = names.intersection(PRESCAN_IDENTIFIER.findall(text))
+        includes = [(name, opening == '"') for opening, name in PRESCAN_INCLUDE.findall(text)]
+        self._prescan_cache[path] = ((mtime, frozenset(names)), identifiers, includes)
+        return identifiers, includes
+
+    def _parse_file_supervised(self, filepath: str) -> List[Any]:
+        """Parse a file in a forked worker held to the per-file parse budget
+        
+        The worker runs the regular parse and stores its entities through its own
+        database connection. If it runs out of time or memory, it is killed and the
+        file goes through the Tree-sitter fallback instead; the cost is recorded so
+        that the file keeps taking the fallback route until its content changes.
+        
+        Args:
+            filepath: Path to the file to parse
+            
+        Returns:
+            List of entities of the file, as stored in the database
+        """
+        realpath = os.path.realpath(filepath)
+        with open(filepath, 'rb') as f:
+            file_hash = hashlib.md5(f.read()).hexdigest()
+        # Unchanged files are served from the database without forking a worker
+        cached_entities = self._unchanged_file_entities(filepath, int(os.stat(filepath).st_mtime), file_hash)
+        if cached_entities:
+            return cached_entities
+        previous = self.db.get_tu_stats(realpath)
+        if previous and previous['hash'] == file_hash and previous['status'] in TU_OVER_BUDGET:
+            logger.info(f"{filepath} went over its parse budget before ({previous['status']}), using Tree-sitter until it changes")
+            return self.parse_file(filepath, force_tree_sitter=True)
+        
+        self.db.commit()
+        # Trace events and memory records of the worker come back through a spool file, lost if it is killed
+        trace_spool = None
+        if tracer.enabled or memory.enabled or profiler.enabled:
+            import tempfile
+            spool_fd, trace_spool = tempfile.mkstemp(prefix='foamcd-trace-', suffix='.json')
+            os.close(spool_fd)
+        started = time.monotonic()
+        pid = os.fork()
+        if pid == 0:
+            os._exit(self._run_tu_worker(filepath, trace_spool))
+        status, peak_rss_kb = self._supervise_tu_worker(pid, started)
+        duration = time.monotonic() - started
+        if trace_spool:
+            try:
+                with open(trace_spool) as f:
+                    report = json.loads(f.read() or '{}')
+                tracer.extend(report.get('trace'))
+                memory.extend(report.get('memory'))
+                profiler.extend(report.get('sql'))
+            except (OSError, ValueError) as e:
+                logger.debug(f"No trace events or statistics from the parse worker of {filepath}: {e}")
+            os.unlink(trace_spool)
+        
+        if status in TU_OVER_BUDGET:
+            logger.warning(f"Parsing {filepath} went over budget ({status} after {duration:.1f}s), trying Tree-sitter instead")
+            route = 'tree-sitter' if self.use_tree_sitter_fallback else 'skipped'
+            entities = self.parse_file(filepath, force_tree_sitter=True)
+        else:
+            route = 'libclang'
+            entities = self.db.get_entities_by_file(realpath)
+            if entities:
+                self.entities[filepath] = entities
+        self.db.store_tu_stats(realpath, file_hash, duration, peak_rss_kb, status, route)
+        logger.debug(f"Parsed {filepath} in {duration:.2f}s (peak RSS {peak_rss_kb} KB, {status}, via {route})")
+        return entities
+    
+    def _run_tu_worker(self, filepath: str, trace_spool: Optional[str] = None) -> int:
+        """Body of a forked parse worker; returns its exit code"""
+        code = TU_WORKER_ERROR
+        tracer.drain()
+        tracer.name_process(f"parse worker ({os.getpid()})")
+        memory.reset_worker()
+        profiler.drain()
+        try:
+            if self.tu_memory_limit_mb > 0:
+                import resource
+                limit = self.tu_memory_limit_mb * 1024 * 1024
+                _, hard = resource.getrlimit(resource.RLIMIT_AS)
+                resource.setrlimit(resource.RLIMIT_AS, (limit, hard))
+            self.in_tu_worker = True
+            self._reconnect_database()
+            self.parse_file(filepath)
+            if trace_spool:
+                with open(trace_spool, 'w') as f:
+                    json.dump({'trace': tracer.drain(), 'memory': memory.drain(self.memory_top),
+                               'sql': profiler.drain()}, f)
+            code = 0
+        except MemoryError:
+            code = TU_WORKER_OUT_OF_MEMORY
+        except BaseException as e:
+            logger.error(f"Parse worker for {filepath} failed: {e}")
+        finally:
+            try:
+                if not self.disable_plugins:
+                    self.plugin_manager.shutdown()
+                self.db.close()
+            except BaseException:
+                pass
+        return code
+    
+    def _reconnect_database(self):
+        # SQLite connections must not be shared with the parent process
+        self.db = EntityDatabase(self.db.db_path, create_tables=False)
+        if self.dependency_dbs:
+            self.db.attach_dependencies([dependency['path'] for dependency in self.dependency_dbs])
+        if self.detector_cache:
+            self.detector_cache.db = self.db
+
+    def parse_lanes(self, lanes: List[List[str]]) -> Tuple[int, int, List[Optional[float]]]:
+        """Parse the files of a schedule, each lane in its own forked process
+        
+        Lanes write their entities through their own database connections and
+        report their counts and plugin statistics back through a pipe. A single
+        lane, or a parser without a database, parses in this process.
+        
+        Args:
+            lanes: Files to parse, per lane, in parse order
+            
+        Returns:
+            Tuple of (parsed count, error count, wall time of each lane or None if it failed)
+        """
+        if len([lane for lane in lanes if lane]) <= 1 or not self.db or not hasattr(os, 'fork'):
+            started = time.monotonic()
+            result = self._parse_lane([path for lane in lanes for path in lane])
+            return result['parsed'], result['errors'], [time.monotonic() - started if lane else None for lane in lanes]
+        
+        self.db.commit()
+        started = time.monotonic()
+        children = {}
+        for i, lane in enumerate(lanes):
+            if not lane:
+                continue
+            read_fd, write_fd = os.pipe()
+            pid = os.fork()
+            if pid == 0:
+                os.close(read_fd)
+                tracer.drain()
+                tracer.name_process(f"parse lane {i}")
+                memory.reset_worker()
+                profiler.drain()
+                os._exit(self._run_lane(lane, write_fd))
+            os.close(write_fd)
+            children[i] = (pid, read_fd)
+        
+        parsed_count = error_count = 0
+        lane_durations: List[Optional[float]] = [None] * len(lanes)
+        for i, (pid, read_fd) in children.items():
+            with os.fdopen(read_fd) as pipe:
+                report = pipe.read()
+            _, wait_status = os.waitpid(pid, 0)
+            if not report or os.WIFSIGNALED(wait_status):
+                logger.error(f"Parse lane {i} died, its {len(lanes[i])} files are not (all) parsed")
+                error_count += len(lanes[i])
+                continue
+            result = json.loads(report)
+            parsed_count += result['parsed']
+            error_count += result['errors']
+            lane_durations[i] = result['duration']
+            if result.get('plugin_stats') and not self.disable_plugins:
+                self.plugin_manager.merge_run_stats(result['plugin_stats'])
+            if result.get('parse_cache') and self.parse_cache:
+                self.parse_cache.hits += result['parse_cache'][0]
+                self.parse_cache.misses += result['parse_cache'][1]
+            if result.get('detector_cache') and self.detector_cache:
+                self.detector_cache.hits += result['detector_cache'][0]
+                self.detector_cache.misses += result['detector_cache'][1]
+            self.fallback_count += result.get('fallbacks', 0)
+            tracer.extend(result.get('trace'))
+            memory.extend(result.get('memory'))
+            profiler.extend(result.get('sql'))
+        logger.debug(f"Parse lanes finished after {time.monotonic() - started:.1f}s")
+        return parsed_count, error_count, lane_durations
+
+    def _parse_lane(self, files: List[str]) -> Dict[str, Any]:
+        parsed_count = error_count = 0
+        for filepath in files:
+            logger.debug(f"Parsing file: {filepath}")
+            if self.parse_file(filepath):
+                parsed_count += 1
+            else:
+                error_count += 1
+        return {'parsed': parsed_count, 'errors': error_count}
+
+    def _run_lane(self, files: List[str], write_fd: int) -> int:
+        """Body of a forked parse lane; returns its exit code"""
+        code = TU_WORKER_ERROR
+        try:
+            started = time.monotonic()
+            self._reconnect_database()
+            result = self._parse_lane(files)
+            result['duration'] = time.monotonic() - started
+            if not self.disable_plugins:
+                result['plugin_stats'] = self.plugin_manager.get_run_stats()
+            if self.parse_cache:
+                result['parse_cache'] = [self.parse_cache.hits, self.parse_cache.misses]
+            if self.detector_cache:
+                result['detector_cache'] = [self.detector_cache.hits, self.detector_cache.misses]
+            result['fallbacks'] = self.fallback_count
+            if tracer.enabled:
+                result['trace'] = tracer.drain()
+            if memory.enabled:
+                result['memory'] = memory.drain(self.memory_top)
+            if profiler.enabled:
+                result['sql'] = profiler.drain()
+            with os.fdopen(write_fd, 'w') as pipe:
+                pipe.write(json.dumps(result))
+            code = 0
+        except BaseException as e:
+            logger.error(f"Parse lane failed: {e}")
+        finally:
+            try:
+                if not self.disable_plugins:
+                    self.plugin_manager.shutdown()
+                self.db.close()
+            except BaseException:
+                pass
+        return code
+
+    def _supervise_tu_worker(self, pid: int, started: float) -> Tuple[str, Optional[int]]:
+        """Wait for a parse worker, killing it once it exceeds the time budget
+        
+        Returns:
+            Tuple of (status, peak RSS of the worker in KB)
+        """
+        timed_out = False
+        while True:
+            wpid, wait_status, rusage = os.wait4(pid, os.WNOHANG)
+            if wpid:
+                break
+            if self.tu_timeout > 0 and time.monotonic() - started > self.tu_timeout:
+                os.kill(pid, signal.SIGKILL)
+                _, wait_status, rusage = os.wait4(pid, 0)
+                timed_out = True
+                break
+            time.sleep(0.02)
+        if timed_out:
+            status = 'timeout'
+        elif os.WIFSIGNALED(wait_status):
+            # Allocation failures under an address space cap usually abort libclang
+            status = 'memory' if self.tu_memory_limit_mb > 0 else 'crashed'
+        elif os.WEXITSTATUS(wait_status) == TU_WORKER_OUT_OF_MEMORY:
+            status = 'memory'
+        elif os.WEXITSTATUS(wait_status) != 0:
+            status = 'error'
+        else:
+            status = 'ok'
+        return status, rusage.ru_maxrss
+    
     def _store_member_type_aliases(self, entities):
         """Process and store member type aliases for all entities recursively
         
@@ -1116,15 +1883,19 @@ class ClangParser:
         
         Args:
             entities: List of entities to process
+            
+        Returns:
+            List of the stored type aliases, as store_class_member_type arguments
         """
+        stored = []
         if not self.db:
-            return
+            return stored
             
         for entity in entities:
             if hasattr(entity, 'member_type_aliases') and entity.member_type_aliases:
                 for type_alias in entity.member_type_aliases:
                     try:
-                        self.db.store_class_member_type(
+                        type_alias_row = dict(
                             class_uuid=type_alias['parent_uuid'],
                             name=type_alias['name'],
                             underlying_type=type_alias['underlying_type'],
@@ -1134,11 +1905,14 @@ class ClangParser:
                             end_line=type_alias['end_line'],
                             doc_comment=type_alias['doc_comment']
                         )
+                        self.db.store_class_member_type(**type_alias_row)
+                        stored.append(type_alias_row)
                         logger.debug(f"Stored class member type alias: {type_alias['name']} for class {entity.name}")
                     except Exception as e:
                         logger.error(f"Error storing class member type alias: {e}")
             if hasattr(entity, 'children') and entity.children:
-                self._store_member_type_aliases(entity.children)
+                stored.extend(self._store_member_type_aliases(entity.children))
+        return stored
     
     def _find_and_link_declarations_definitions(self, cursor: clang.cindex.Cursor, filepath: str):
         """Find declarations and their matching definitions and link them in the database
@@ -1150,9 +1924,13 @@ class ClangParser:
         Args:
             cursor: libclang cursor for the translation unit
             filepath: Path to the file being parsed
+            
+        Returns:
+            List of the (declaration UUID, definition UUID) pairs linked
         """
         logger.debug(f"Finding and linking declarations and definitions in {filepath}")
         processed_usrs = {}
+        links = []
         def process_cursor_for_links(current_cursor):
             if not current_cursor.location.file:
                 return
@@ -1220,6 +1998,7 @@ class ClangParser:
                         def_uuid = def_row[0]
                         logger.debug(f"Linking declaration {current_cursor.spelling} in {decl_file} to definition in {def_file}")
                         self.db.link_declaration_definition(decl_uuid, def_uuid)
+                        links.append((decl_uuid, def_uuid))
                 except Exception as e:
                     logger.debug(f"Error processing declaration-definition: {e}")
                     raise
@@ -1228,6 +2007,7 @@ class ClangParser:
                 process_cursor_for_links(child)
 
         process_cursor_for_links(cursor)
+        return links
     
     def _process_cursor(self, cursor: clang.cindex.Cursor, entities: List[Entity], 
                     parent: Optional[Entity] = None):
@@ -1236,6 +2016,14 @@ class ClangParser:
             file_path = os.path.realpath(cursor.location.file.name)
             prefixes_to_skip = self.config.get('parser.prefixes_to_skip', [])
             
+            # Entities of dependencies are in their databases already, and those
+            # of module interfaces are extracted from the interfaces themselves
+            if any(file_path.startswith(prefix) for prefix in self.dependency_prefixes):
+                return
+            if self.module_cache and file_path in self.module_cache.interface_files \
+                    and file_path != self._current_file:
+                return
+            
             if any(file_path.startswith(prefix) for prefix in prefixes_to_skip):
                 # Instead of completely skipping external references,
                 # create a placeholder entity without recursing into children
@@ -1249,7 +2037,12 @@ class ClangParser:
                     CursorKind.ENUM_DECL
                 ]:
                     entity = self._create_placeholder_entity(cursor, parent)
-                    if entity:
+                    # Each placeholder is listed once per file, until it is stored; those
+                    # under a documented entity go with it, as storing it replaces its children
+                    if entity and entity.uuid not in self._tu_placeholders:
+                        self._tu_placeholders[entity.uuid] = entity
+                        if entity.uuid in self._stored_placeholders and not parent:
+                            return
                         if parent:
                             parent.add_child(entity)
                         else:
@@ -1375,6 +2168,7 @@ class ClangParser:
             for child in cursor.get_children():
                 self._process_cursor(child, entities, parent)
 
+    @traced('resolve scoped template functions', 'resolve')
     def resolve_scoped_template_functions(self) -> None:
         """Resolve parent UUIDs for template functions defined with scope resolution notation
         
@@ -1467,6 +2261,7 @@ class ClangParser:
         logger.info(f"Resolved parent UUIDs for {resolved_count} out of {len(template_functions)} template functions")
         self.db.commit()
     
+    @traced('resolve enclosing relationships', 'resolve')
     def resolve_enclosing_relationships(self):
         """Resolve enclosing entity relationships (nested classes, enums, etc.)
         
@@ -1644,6 +2439,7 @@ class ClangParser:
             import traceback
             logger.error(f"Traceback: {traceback.format_exc()}")
     
+    @traced('resolve inheritance relationships', 'resolve')
     def resolve_inheritance_relationships(self):
         """Resolve inheritance relationships between entities
         
@@ -1666,6 +2462,13 @@ class ClangParser:
             WHERE name = ? AND kind IN ('CLASS_DECL', 'CLASS_TEMPLATE', 'STRUCT_DECL', 'STRUCT_TEMPLATE')
             """, (base_name,))
             base_result = self.db.cursor.fetchone()
+            if not base_result and self.db.dependency_schemas:
+                # Base classes of dependencies, by qualified name without template arguments
+                qualified_name = base_name.split('<', 1)[0].strip()
+                namespace, _, name = qualified_name.rpartition('::')
+                dependency_uuid = self.db.find_dependency_class(name, namespace or None)
+                if dependency_uuid and self.db.import_dependency_entity(dependency_uuid):
+                    base_result = (dependency_uuid,)
             
             if base_result:
                 base_uuid = base_result[0]
@@ -1706,6 +2509,86 @@ class ClangParser:
             db.close()
             logger.info(f"Exported entities to {output_path}")
             
+    def parse_skeletons(self, filepaths: List[str], processes: Optional[int] = None) -> int:
+        """Quick first pass storing a tree-sitter entity skeleton of each file
+        
+        Files are parsed in parallel worker processes; entities are flagged as
+        skeletons and stored with libclang-compatible locations, so a later
+        libclang parse replaces them in place. Files which already have entities
+        from a libclang parse are left alone.
+        
+        Args:
+            filepaths: Files to index
+            processes: Number of worker processes (CPU count if None)
+            
+        Returns:
+            Number of files whose skeleton was stored
+        """
+        if not (TREE_SITTER_IMPORT_SUCCESS and is_tree_sitter_available()):
+            logger.error("Quick parsing requires tree-sitter, which is not available")
+            return 0
+        pending = []
+        for filepath in dict.fromkeys(os.path.realpath(path) for path in filepaths):
+            if self.db and self.db.has_parsed_entities(filepath):
+                logger.debug(f"Keeping libclang entities of {filepath}")
+                continue
+            pending.append(filepath)
+        processes = min(processes or os.cpu_count() or 1, len(pending))
+        logger.info(f"Extracting entity skeletons of {len(pending)} files with {max(processes, 1)} processes")
+        if processes > 1:
+            context = multiprocessing.get_context("spawn")
+            with context.Pool(processes) as pool:
+                return self._store_skeletons(pool.imap_unordered(extract_skeleton_file, pending, chunksize=4))
+        return self._store_skeletons(map(extract_skeleton_file, pending))
+    
+    def _store_skeletons(self, results) -> int:
+        stored = 0
+        for filepath, infos in results:
+            file_entities = [self._skeleton_to_entity(info, filepath) for info in infos]
+            file_entities = [entity for entity in file_entities if not self._should_skip_entity(entity)]
+            self.entities[filepath] = file_entities
+            if self.db:
+                self.db.clear_skeleton_entities(filepath)
+                for entity in file_entities:
+                    self.db.store_entity(entity.to_dict())
+            stored += 1
+        return stored
+    
+    def _skeleton_to_entity(self, info: Dict[str, Any], filepath: str, parent: Optional[Entity] = None) -> Entity:
+        """Convert a tree-sitter skeleton entry into a skeleton Entity
+        
+        Args:
+            info: Skeleton dictionary from TreeSitterSubparser.extract_skeleton
+            filepath: Path to the file the entity belongs to
+            parent: Parent entity
+        """
+        location = (filepath, info["line"], info["column"], info["end_line"], info["end_column"])
+        entity = Entity(info["name"], getattr(CursorKind, info["kind"]), location,
+                        self._clean_doc_comment(info.get("doc_comment", "")), parent)
+        entity.is_skeleton = True
+        entity.namespace = info.get("namespace")
+        if info.get("access"):
+            entity.access = getattr(clang.cindex.AccessSpecifier, info["access"], entity.access)
+        entity.type_info = info.get("type_info")
+        entity.full_signature = info.get("full_signature")
+        for flag in ("is_virtual", "is_pure_virtual", "is_override", "is_final", "is_static",
+                     "is_abstract", "is_defaulted", "is_deleted"):
+            if info.get(flag):
+                setattr(entity, flag, True)
+        for base in info.get("bases", []):
+            entity.add_base_class(base)
+        if info.get("enclosed") and parent is not None:
+            # Named and linked like libclang does for nested classes, after the UUID is set
+            entity.name = f"{parent.name}::{entity.name}"
+            entity.custom_fields['needs_enclosing_link'] = {
+                'enclosing_uuid': parent.uuid,
+                'enclosed_kind': str(entity.kind),
+                'enclosing_kind': str(parent.kind)
+            }
+        for child in info.get("children", []):
+            entity.add_child(self._skeleton_to_entity(child, filepath, entity))
+        return entity
+    
     def _convert_tree_sitter_result(self, tree_sitter_result: Dict[str, Any], filepath: str) -> List[Entity]:
         """Convert Tree-sitter parsing result to Entity objects
         
@@ -1725,14 +2608,16 @@ class ClangParser:
         
         for class_info in tree_sitter_result.get("classes", []):
             try:
+                kind = (clang.cindex.CursorKind.STRUCT_DECL if class_info.get("kind") == "struct"
+                        else clang.cindex.CursorKind.CLASS_DECL)
                 class_entity = Entity(
                     name=class_info.get("name", "UnknownClass"),
-                    kind="CLASS_DECL",
-                    file=filepath,
-                    line=class_info.get("start_line", 0) + 1,  # Tree-sitter uses 0-indexed lines
-                    column=class_info.get("start_column", 0),
-                    end_line=class_info.get("end_line", 0) + 1,
-                    end_column=class_info.get("end_column", 0),
+                    kind=kind,
+                    location=(filepath,
+                              int(class_info.get("start_line", 0)) + 1,  # Tree-sitter uses 0-indexed lines
+                              int(class_info.get("start_column", 0)),
+                              int(class_info.get("end_line", 0)) + 1,
+                              int(class_info.get("end_column", 0))),
                     parent=None
                 )
                 class_entity.access_specifier = "public"
@@ -1960,6 +2845,69 @@ def _normalize_path_in_argument(arg, base_dir):
             return os.path.normpath(os.path.join(base_dir, arg))
     return arg
 
+def _command_arguments(command) -> List[str]:
+    """Arguments of a compilation database command, without the compiler, paths made absolute"""
+    try:
+        args = list(command.arguments)[1:]
+    except (AttributeError, TypeError) as e:
+        logger.debug(f"Could not extract arguments from command: {e}")
+        return []
+    command_dir = getattr(command, 'directory', None)
+    if command_dir:
+        args = [_normalize_path_in_argument(arg, command_dir) for arg in args]
+    return args
+
+def _semantic_compile_flags(args: List[str], filepath: str) -> List[str]:
+    """Compilation arguments which change how a file parses
+    
+    Output and dependency files, -c and the source file itself are dropped, so that
+    commands of the same configuration compare equal.
+    """
+    source = os.path.realpath(filepath)
+    flags = []
+    skip_next = False
+    for arg in args:
+        if skip_next:
+            skip_next = False
+        elif arg in ('-o', '-MF', '-MT', '-MQ'):
+            skip_next = True
+        elif arg in ('-c', '-MD', '-MMD', '-MP', '--') or arg.startswith(('-MF', '-MT', '-MQ')):
+            continue
+        elif not arg.startswith('-') and os.path.realpath(arg) == source:
+            continue
+        else:
+            flags.append(arg)
+    return flags
+
+def _compact_entity_dict(entity: Dict[str, Any]) -> Dict[str, Any]:
+    """Entity dictionary without the per-access member lists, which repeat its children"""
+    compact = {key: value for key, value in entity.items() if key != 'members'}
+    compact['children'] = [_compact_entity_dict(child) for child in entity.get('children', [])]
+    return compact
+
+def with_sibling_headers(filepaths: List[str]) -> List[str]:
+    """Add the headers next to the given files
+    
+    Args:
+        filepaths: Source files
+        
+    Returns:
+        The source files followed by the headers found in their directories
+    """
+    files = list(dict.fromkeys(filepaths))
+    seen = set(os.path.realpath(path) for path in files)
+    for directory in dict.fromkeys(os.path.dirname(os.path.abspath(path)) for path in filepaths):
+        try:
+            names = sorted(os.listdir(directory))
+        except OSError:
+            continue
+        for name in names:
+            path = os.path.join(directory, name)
+            if name.endswith(tuple(CPP_HEADER_EXTENSIONS)) and os.path.realpath(path) not in seen:
+                seen.add(os.path.realpath(path))
+                files.append(path)
+    return files
+
 def get_source_files_from_compilation_database(compilation_database):
     """Extract source files from compilation database
     
@@ -1986,21 +2934,54 @@ def get_source_files_from_compilation_database(compilation_database):
         logger.error(f"Invalid compilation database object: {compilation_database}\nTraceback: {traceback.format_exc()}")
         return []
     
-    files = set()
+    # One translation unit per file, however its compile commands spell its path
+    files = {}
     try:
         for cmd in compilation_database.getAllCompileCommands():
             src_file = cmd.filename
-            if src_file.endswith(tuple(CPP_FILE_EXTENSIONS)):
+            if src_file.endswith(tuple(CPP_FILE_EXTENSIONS + MODULE_INTERFACE_EXTENSIONS)):
                 src_path = Path(src_file)
                 if not src_path.is_absolute():
                     src_path = Path(cmd.directory) / src_path
-                files.add(str(src_path))
+                files.setdefault(os.path.realpath(src_path), str(src_path))
         logger.debug(f"Found {len(files)} source files in compilation database")
     except Exception as e:
         import traceback
         logger.error(f"Error extracting files from compilation database: {e}\nTraceback: {traceback.format_exc()}")
     
-    return list(files)
+    return list(files.values())
+
+def drop_reassigned_shard_files(db: EntityDatabase, shard_files: List[str]) -> List[str]:
+    """Remove the files a shard database holds but the shard no longer owns
+    
+    Cost-balanced shards are recomputed every run, so a file can move to another shard;
+    its rows must then only come from that shard when the shards are merged.
+    
+    Args:
+        db: Database of the shard, kept from earlier runs
+        shard_files: Files of the shard in this run
+        
+    Returns:
+        The files removed
+    """
+    shard_files = set(shard_files)
+    dropped = sorted(path for path in db.get_all_files() if path not in shard_files)
+    for path in dropped:
+        logger.info(f"{path} is no longer part of this shard, removing its entities")
+        db.forget_file(path)
+    return dropped
+
+
+def record_parse_metrics(run_metrics: RunMetrics, parser: ClangParser, db: EntityDatabase):
+    """Add what a finished parse run stored and its cache and fallback counts to its metrics"""
+    counts = db.get_entity_counts()
+    run_metrics.set('entities', counts.get('entities'), "Entities in the database after the run")
+    run_metrics.set('skeleton_entities', counts.get('skeletons'), "Entities only indexed by a quick pass")
+    run_metrics.set('fallbacks', parser.fallback_count, "Files parsed by the Tree-sitter fallback instead of libclang")
+    if parser.parse_cache:
+        run_metrics.set_cache('parse', parser.parse_cache.hits, parser.parse_cache.misses)
+    if parser.detector_cache:
+        run_metrics.set_cache('detector', parser.detector_cache.hits, parser.detector_cache.misses)
 
 def main():
     # Extract any +key=value arguments before argparse sees them
@@ -2043,6 +3024,34 @@ def main():
     parser.add_argument('--test-libclang', action='store_true', help='Test libclang configuration and print diagnostic information')
     parser.add_argument('--debug-libclang', action='store_true', help='Enable detailed debug output for libclang configuration')
     parser.add_argument('--version', action='store_true', help='Show version information and exit')
+    parser.add_argument('--jobs', '-j', type=int,
+                      help='Number of processes parsing translation units concurrently, overrides the YAML config')
+    parser.add_argument('--cache-dir', type=str,
+                      help='Parse cache directory, can be shared between machines and CI jobs; overrides the YAML config')
+    parser.add_argument('--resume', action='store_true',
+                      help='Continue the last run if it was interrupted, from its first file not parsed yet,\n'
+                           'then run the resolution passes')
+    parser.add_argument('--shard', type=str, metavar='I/N',
+                      help='Only parse shard I (from 0) of N of the target files, into <output>.shard-I-of-N.db;\n'
+                           'combine the shard databases with foamcd-merge, which runs the resolution passes')
+    parser.add_argument('--shard-history', type=str, metavar='DB',
+                      help='Database of a previous (merged) run, to balance shards by recorded parse cost;\n'
+                           'all shards of a run must be given the same one')
+    parser.add_argument('--quick', action='store_true',
+                      help='Only index an entity skeleton of the target files and the headers next to them\n'
+                           'with tree-sitter, in parallel; a later full parse replaces it')
+    parser.add_argument('--trace', type=str, metavar='OUT.json',
+                      help='Write a Chrome/Perfetto trace of the run: phases of each translation unit,\n'
+                           'resolution passes, one row per parse lane')
+    parser.add_argument('--memory', action='store_true',
+                      help='Account RSS and Python allocations of each phase of each translation unit into the\n'
+                           'run_metrics table, and summarize them with the call sites retaining the most memory')
+    parser.add_argument('--sql-profile', action='store_true',
+                      help='Time SQL statements per call site, with whether their query plan uses an index,\n'
+                           'and report the most expensive ones at exit')
+    parser.add_argument('--metrics-dir', type=str, metavar='DIR',
+                      help='Write metrics of the run to DIR/foamcd_parse.prom (OpenMetrics) and .json,\n'
+                           'e.g. for a node exporter textfile collector; overrides the YAML config')
     
     # Plugin system options
     plugin_group = parser.add_argument_group('Plugin Options')
@@ -2073,6 +3082,14 @@ def main():
         
     config_obj = Config(args.config)
     logger = setup_logging(args.verbose or args.debug_libclang)
+    if args.trace:
+        tracer.enable()
+    if args.memory or config_obj.get('metrics.memory.enabled', False):
+        memory.enable(config_obj.get('metrics.memory.frames', 1))
+    if args.sql_profile or config_obj.get('database.profile', False):
+        profiler.enable()
+    metrics_dir = args.metrics_dir or config_obj.get('metrics.export_dir')
+    run_metrics = RunMetrics('parse')
     
     # Handle plugin listing if requested
     if args.list_plugins and not args.disable_plugins:
@@ -2172,6 +3189,8 @@ def main():
             logger.error(f"libclang is not properly configured. Add 'parser.libclang_path' to your config file.\nTraceback: {traceback.format_exc()}")
             return 1
     
+    db_path = None
+    completed = False
     try:
         # Command line args have priority over config values
         compile_commands_dir = args.compile_commands_dir or config_obj.get('parser.compile_commands_dir')
@@ -2180,7 +3199,16 @@ def main():
         else:
             logger.warning("No compilation database provided, using default compilation settings")
         db_path = args.output or config_obj.get('database.path', 'docs.db')
+        shard = None
+        if args.shard:
+            if args.file or args.quick:
+                logger.error("--shard only applies to full runs over the target files")
+                return 1
+            shard = parse_shard_spec(args.shard)
+            db_path = shard_database_path(db_path, *shard)
+            logger.info(f"Parsing shard {shard[0]} of {shard[1]} into {db_path}")
         db = EntityDatabase(db_path)
+        run_started = datetime.now().isoformat(timespec='seconds')
         
         # Setup plugin configuration from both config file and command line args
         plugin_config = config_obj.get('parser.plugins', {})
@@ -2199,6 +3227,48 @@ def main():
             plugin_dirs=args.plugin_dir,
             disable_plugins=args.disable_plugins
         )
+        if args.cache_dir:
+            parser.parse_cache = ParseCache(args.cache_dir)
+        
+        if args.quick:
+            quick_files = [args.file] if args.file else config_obj.get('parser.target_files', [])
+            if compile_commands_dir and not quick_files:
+                quick_files = get_source_files_from_compilation_database(compile_commands_dir)
+            quick_files = with_sibling_headers([path for path in quick_files if os.path.exists(path)])
+            if not quick_files:
+                logger.error("No files to index. Specify --file, or compile_commands_dir or target_files in config.")
+                return 1
+            run_metrics.start_phase('parse')
+            indexed_count = parser.parse_skeletons(quick_files)
+            run_metrics.end_phase('parse')
+            run_metrics.start_phase('resolve')
+            parser.resolve_inheritance_relationships()
+            parser.resolve_enclosing_relationships()
+            run_metrics.end_phase('resolve')
+            logger.info(f"Quick indexing complete: skeletons of {indexed_count} files (from {len(quick_files)} total files)")
+            run_metrics.set('translation_units', indexed_count, "Files of the run, by outcome", status='skeleton')
+            record_parse_metrics(run_metrics, parser, db)
+            completed = True
+            return 0
+        
+        # Runs over target files are journaled, so that an interrupted one can be resumed
+        run_id = None
+        interrupted = db.get_interrupted_run() if args.resume and not args.file else None
+        if args.resume and not args.file and not interrupted:
+            logger.info("No interrupted run to resume, starting a new one")
+        
+        run_files = config_obj.get('parser.target_files', [])
+        if compile_commands_dir and not run_files:
+            run_files = get_source_files_from_compilation_database(compile_commands_dir)
+        # Module interfaces are built before any file importing them is parsed; all
+        # files of the run are scanned, whether they end up parsed in this process or not,
+        # unless a single --file imports no module
+        run_metrics.start_phase('modules')
+        with tracer.span('prepare modules'):
+            parser.prepare_modules([path for path in run_files if os.path.exists(path)] +
+                                   ([args.file] if args.file and os.path.exists(args.file) else []),
+                                   importers=[args.file] if args.file else None)
+        run_metrics.end_phase('modules')
         
         if args.file:
             if not os.path.exists(args.file):
@@ -2206,60 +3276,104 @@ def main():
                 logger.error(f"File not found: {args.file}\nTraceback: {traceback.format_exc()}")
                 return 1
             logger.debug(f"Parsing file: {args.file}")
+            run_metrics.start_phase('parse')
             entities = parser.parse_file(args.file)
+            run_metrics.end_phase('parse')
             logger.debug(f"Parsed {len(entities)} top-level entities")
+            run_metrics.set('translation_units', 1 if entities else 0, "Files of the run, by outcome", status='parsed')
+            run_metrics.set('translation_units', 0 if entities else 1, "Files of the run, by outcome", status='failed')
         else:
-            target_files = config_obj.get('parser.target_files', [])
-            if compile_commands_dir and not target_files:
-                target_files = get_source_files_from_compilation_database(compile_commands_dir)
-            if not target_files:
-                import traceback
-                logger.error(f"""No files to parse. Specify --file, --compile-commands, or (compile_commands_dir or target_files) in config.
-                             Kudos to you for somehow missing every single option! Get it together please!\nTraceback: {traceback.format_exc()}""")
-                return 1
-            parsed_count = 0
             unchanged_count = 0
             error_count = 0
-            
-            for filepath in target_files:
-                if not os.path.exists(filepath):
-                    logger.warning(f"File not found: {filepath}")
-                    error_count += 1
-                    continue
-                    
-                # Check if the file has changed since last parsing
-                if db:
-                    file_stats = os.stat(filepath)
-                    last_modified = int(file_stats.st_mtime)
-                    
-                    with open(filepath, 'rb') as f:
-                        file_content = f.read()
-                        file_hash = hashlib.md5(file_content).hexdigest()
-                    
-                    if not db.file_changed(filepath, last_modified, file_hash):
-                        cached_entities = db.get_entities_by_file(filepath)
-                        if cached_entities:
-                            logger.debug(f"Using cached entities for unchanged file: {filepath}")
-                            parser.entities[filepath] = cached_entities
-                            unchanged_count += 1
-                            continue
+            files_to_parse = []
+            if interrupted:
+                run_id = interrupted['run_id']
+                run_started = interrupted['started']
+                files_to_parse = interrupted['pending']
+                total_count = len(files_to_parse)
+                logger.info(f"Resuming run {run_id} started {run_started}: {total_count} files left to parse")
+            else:
+                target_files = list(run_files)
+                if not target_files:
+                    import traceback
+                    logger.error(f"""No files to parse. Specify --file, --compile-commands, or (compile_commands_dir or target_files) in config.
+                                 Kudos to you for somehow missing every single option! Get it together please!\nTraceback: {traceback.format_exc()}""")
+                    return 1
+                if shard:
+                    shard_history = None
+                    if args.shard_history:
+                        history_db = EntityDatabase(args.shard_history)
+                        shard_history = history_db.get_tu_history()
+                        history_db.close()
+                    target_files = select_shard(target_files, *shard, history=shard_history)
+                    drop_reassigned_shard_files(db, target_files)
+                total_count = len(target_files)
                 
-                logger.debug(f"Parsing file: {filepath}")
-                entities = parser.parse_file(filepath)
-                if entities:
-                    parsed_count += 1
-                else:
-                    error_count += 1
+                for filepath in target_files:
+                    if not os.path.exists(filepath):
+                        logger.warning(f"File not found: {filepath}")
+                        error_count += 1
+                        continue
+                        
+                    # Check if the file has changed since last parsing
+                    if db:
+                        file_stats = os.stat(filepath)
+                        last_modified = int(file_stats.st_mtime)
+                        
+                        with open(filepath, 'rb') as f:
+                            file_content = f.read()
+                            file_hash = hashlib.md5(file_content).hexdigest()
+                        
+                        if not db.file_changed(filepath, last_modified, file_hash):
+                            cached_entities = db.get_entities_by_file(filepath)
+                            if cached_entities:
+                                logger.debug(f"Using cached entities for unchanged file: {filepath}")
+                                parser.entities[filepath] = cached_entities
+                                unchanged_count += 1
+                                continue
+                    files_to_parse.append(filepath)
+                run_id = db.begin_run(run_started, files_to_parse)
+            parser.run_id = run_id
             
-            logger.info(f"Processing complete: {parsed_count} parsed, {unchanged_count} unchanged, {error_count} errors (from {len(target_files)} total files)")
-        
-        parser.resolve_scoped_template_functions()
-        parser.resolve_inheritance_relationships()
-        parser.resolve_enclosing_relationships()
+            # Order and distribute the files by the parse cost recorded in earlier runs
+            jobs = args.jobs or int(config_obj.get('parser.jobs', 1) or 1)
+            schedule = schedule_translation_units(files_to_parse, db.get_tu_history(), jobs)
+            run_metrics.start_phase('parse')
+            with tracer.span('parse lanes', lanes=len(schedule.lanes), files=len(files_to_parse)):
+                parsed_count, lane_error_count, lane_durations = parser.parse_lanes(schedule.lanes)
+            run_metrics.end_phase('parse')
+            error_count += lane_error_count
+            for status, count in [('parsed', parsed_count), ('unchanged', unchanged_count), ('failed', error_count)]:
+                run_metrics.set('translation_units', count, "Files of the run, by outcome", status=status)
+            run_metrics.set('parse_lanes', len([lane for lane in schedule.lanes if lane]), "Processes files were parsed in")
+            report_makespan(schedule, lane_durations)
+            
+            logger.info(f"Processing complete: {parsed_count} parsed, {unchanged_count} unchanged, {error_count} errors (from {total_count} total files)")
+            if parser.parse_cache:
+                logger.info(f"Parse cache {parser.parse_cache.cache_dir}: {parser.parse_cache.hits} hits, {parser.parse_cache.misses} misses")
+        
+        # Resolution passes run once all files of the run are in; a run interrupted
+        # from here on resumes with them. Shards leave them to foamcd-merge
+        if run_id is not None:
+            db.set_run_status(run_id, 'resolving')
+        parser.record_plugin_stats(run_started)
+        if not shard:
+            run_metrics.start_phase('resolve')
+            parser.resolve_scoped_template_functions()
+            parser.resolve_inheritance_relationships()
+            parser.resolve_enclosing_relationships()
+            run_metrics.end_phase('resolve')
+        if run_id is not None:
+            db.set_run_status(run_id, 'complete')
         
         logger.info(f"Parsed {len(parser.entities)} files with {sum(len(entities) for entities in parser.entities.values())} top-level entities")
+        if memory.enabled:
+            summary = memory.log_summary(parser.memory_top)
+            db.store_run_metrics(run_started, 'parse', memory.records, summary['sites'])
+        record_parse_metrics(run_metrics, parser, db)
         
         logger.info("Parsing complete")
+        completed = True
         return 0
         
     except Exception as e:
@@ -2267,6 +3381,12 @@ def main():
         logger.error(f"Error: {e}\nTraceback: {traceback.format_exc()}")
         logger.debug("Exception details:", exc_info=True)
         return 1
+    finally:
+        if args.trace:
+            tracer.write(args.trace, {'command': 'foamcd-parse', 'version': get_version()})
+        if metrics_dir:
+            run_metrics.finish(completed, db_path)
+            run_metrics.write(metrics_dir)
     
     return 0
 
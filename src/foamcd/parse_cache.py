@@ -0,0 +1,137 @@
+#!/usr/bin/env python3
+
+"""
+Content-addressed cache of parse results, shareable between machines
+
+Works like ccache's direct mode: the key of a translation unit covers its
+content, compilation arguments, foamCD version, enabled detectors and the
+parser settings shaping its entities. Under that key, a manifest lists the
+headers the translation unit included; the entity batch itself is stored
+under a second key adding the current content hashes of those headers.
+A lookup therefore costs hashing the included headers (memoized per run)
+and reading one compressed file.
+
+Entries are written to temporary files first and renamed into place, so the
+directory can live on shared storage used by concurrent jobs. Entity UUIDs
+depend on file paths, so entries only help jobs seeing the sources at the
+same paths.
+"""
+
+import os
+import json
+import zlib
+import hashlib
+import tempfile
+from typing import Dict, List, Any, Optional, Tuple
+
+from .logs import setup_logging
+
+logger = setup_logging()
+
+# Bumped whenever the layout of cache entries changes
+CACHE_FORMAT = "3"
+
+
+class ParseCache:
+    """Directory of parse results keyed by translation unit content"""
+
+    def __init__(self, cache_dir: str):
+        self.cache_dir = os.path.abspath(cache_dir)
+        os.makedirs(self.cache_dir, exist_ok=True)
+        self._file_hashes: Dict[str, Tuple[int, int, str]] = {}
+        self.hits = 0
+        self.misses = 0
+
+    @staticmethod
+    def digest(text: str) -> str:
+        return hashlib.sha256(f"{CACHE_FORMAT}\n{text}".encode('utf-8')).hexdigest()
+
+    def _entry_path(self, key: str, suffix: str) -> str:
+        return os.path.join(self.cache_dir, key[:2], key[2:] + suffix)
+
+    def file_hash(self, path: str) -> Optional[str]:
+        """Content hash of a file, memoized by modification time and size"""
+        try:
+            stat = os.stat(path)
+        except OSError:
+            return None
+        memo = self._file_hashes.get(path)
+        if memo and memo[0] == stat.st_mtime_ns and memo[1] == stat.st_size:
+            return memo[2]
+        try:
+            with open(path, 'rb') as f:
+                content_hash = hashlib.md5(f.read()).hexdigest()
+        except OSError:
+            return None
+        self._file_hashes[path] = (stat.st_mtime_ns, stat.st_size, content_hash)
+        return content_hash
+
+    def _result_key(self, key: str, includes: List[str]) -> Optional[str]:
+        lines = [key]
+        for include in includes:
+            include_hash = self.file_hash(include)
+            if include_hash is None:
+                return None
+            lines.append(f"{include}:{include_hash}")
+        return self.digest("\n".join(lines))
+
+    def _write(self, path: str, data: bytes):
+        directory = os.path.dirname(path)
+        os.makedirs(directory, exist_ok=True)
+        fd, temp_path = tempfile.mkstemp(dir=directory, prefix='.tmp-')
+        try:
+            with os.fdopen(fd, 'wb') as f:
+                f.write(data)
+            os.replace(temp_path, path)
+        except BaseException:
+            if os.path.exists(temp_path):
+                os.unlink(temp_path)
+            raise
+
+    def lookup(self, key: str) -> Optional[Dict[str, Any]]:
+        """Entity batch stored for a translation unit key, if its headers did not change
+
+        Args:
+            key: Key of the translation unit
+
+        Returns:
+            The payload given to `store`, or None on a miss
+        """
+        payload = None
+        try:
+            with open(self._entry_path(key, '.manifest'), 'r') as f:
+                manifest = json.load(f)
+            result_key = self._result_key(key, manifest['includes'])
+            if result_key is not None:
+                with open(self._entry_path(result_key, '.entities'), 'rb') as f:
+                    payload = json.loads(zlib.decompress(f.read()))
+        except FileNotFoundError:
+            pass
+        except (OSError, ValueError, KeyError, zlib.error) as e:
+            logger.warning(f"Ignoring unreadable parse cache entry {key}: {e}")
+        if payload is None:
+            self.misses += 1
+        else:
+            self.hits += 1
+        return payload
+
+    def store(self, key: str, includes: List[str], payload: Dict[str, Any]):
+        """Store the entity batch of a translation unit
+
+        Args:
+            key: Key of the translation unit
+            includes: Paths of all headers the translation unit included
+            payload: JSON-serializable entity batch
+        """
+        includes = sorted(set(includes))
+        result_key = self._result_key(key, includes)
+        if result_key is None:
+            logger.debug(f"Not caching {key}: some of its headers are gone")
+            return
+        try:
+            self._write(self._entry_path(result_key, '.entities'),
+                        zlib.compress(json.dumps(payload, default=str).encode('utf-8')))
+            self._write(self._entry_path(key, '.manifest'),
+                        json.dumps({'includes': includes}).encode('utf-8'))
+        except OSError as e:
+            logger.warning(f"Could not write parse cache entry {key}: {e}")
@@ -0,0 +1,222 @@
+#!/usr/bin/env python3
+
+"""
+Out-of-process execution of heavy DSL plugins
+
+Selected plugins run in a pool of long-lived helper processes instead of the
+parser process. They never see live libclang cursors; the parser hands them
+compact, picklable cursor snapshots and gets the results back in batches at
+the end of each translation unit.
+"""
+
+import os
+import atexit
+import multiprocessing
+from typing import Dict, List, Any, Optional, Tuple
+
+from .logs import setup_logging
+
+logger = setup_logging()
+
+
+class SnapshotFile:
+    def __init__(self, name: str):
+        self.name = name
+
+
+class SnapshotLocation:
+    def __init__(self, file: Optional[str], line: int = 0, column: int = 0):
+        self.file = SnapshotFile(file) if file else None
+        self.line = line
+        self.column = column
+
+
+class SnapshotToken:
+    def __init__(self, spelling: str):
+        self.spelling = spelling
+
+
+class SnapshotType:
+    def __init__(self, spelling: str):
+        self.spelling = spelling
+
+
+class CursorSnapshot:
+    """Picklable stand-in for a libclang cursor
+
+    Mimics the parts of the cursor API plugins commonly rely on: kind, spelling,
+    location, type spelling, tokens and the semantic parent chain (kind and
+    spelling only), plus the macro invocations the detector asked for.
+    Children are not captured; `get_children` returns nothing.
+    """
+
+    def __init__(self, kind_name: Optional[str], spelling: str, file: Optional[str] = None,
+                 line: int = 0, column: int = 0, type_spelling: str = "",
+                 token_spellings: Optional[List[str]] = None,
+                 semantic_parent: Optional['CursorSnapshot'] = None,
+                 compile_args: Optional[List[str]] = None):
+        self.kind_name = kind_name
+        self.spelling = spelling
+        self.location = SnapshotLocation(file, line, column)
+        self.type = SnapshotType(type_spelling)
+        self.token_spellings = token_spellings or []
+        self.semantic_parent = semantic_parent
+        self.compile_args = compile_args
+        # Macro invocations inside the cursor's extent, for detectors declaring `macros`
+        self.macro_invocations = None
+
+    @property
+    def kind(self):
+        from clang.cindex import CursorKind
+        return getattr(CursorKind, self.kind_name) if self.kind_name else None
+
+    @property
+    def qualified_name(self) -> str:
+        parts = []
+        parent = self.semantic_parent
+        while parent is not None and parent.kind_name != 'TRANSLATION_UNIT':
+            if parent.spelling:
+                parts.insert(0, parent.spelling)
+            parent = parent.semantic_parent
+        return "::".join(parts + [self.spelling])
+
+    def get_tokens(self):
+        return [SnapshotToken(spelling) for spelling in self.token_spellings]
+
+    def get_children(self):
+        return []
+
+    @classmethod
+    def from_cursor(cls, cursor, token_spellings: List[str], compile_args: Optional[List[str]] = None,
+                    with_parents: bool = True) -> 'CursorSnapshot':
+        """Capture a snapshot of a live libclang cursor
+
+        Args:
+            cursor: libclang cursor
+            token_spellings: Token spellings already computed for the cursor
+            compile_args: Compilation arguments of the cursor's file
+            with_parents: Whether to capture the semantic parent chain
+        """
+        kind = getattr(cursor, 'kind', None)
+        location = getattr(cursor, 'location', None)
+        file = location.file.name if location is not None and location.file else None
+        parent_snapshot = None
+        if with_parents:
+            chain = []
+            parent = getattr(cursor, 'semantic_parent', None)
+            while parent is not None:
+                chain.append((parent.kind.name, parent.spelling))
+                if parent.kind.name == 'TRANSLATION_UNIT':
+                    break
+                parent = parent.semantic_parent
+            for kind_name, spelling in reversed(chain):
+                parent_snapshot = cls(kind_name, spelling, semantic_parent=parent_snapshot)
+        type_info = getattr(cursor, 'type', None)
+        return cls(
+            kind.name if kind is not None else None,
+            cursor.spelling,
+            file,
+            location.line if file else 0,
+            location.column if file else 0,
+            getattr(type_info, 'spelling', '') or '',
+            list(token_spellings),
+            parent_snapshot,
+            compile_args
+        )
+
+
+# Plugin manager living in each helper process
+_WORKER_MANAGER = None
+
+
+def _init_worker(plugin_files: Dict[str, str]):
+    global _WORKER_MANAGER
+    from .plugin_system import PluginManager
+    _WORKER_MANAGER = PluginManager([], {"only_plugins": list(plugin_files.keys())})
+    for plugin_file in sorted(set(plugin_files.values())):
+        _WORKER_MANAGER.load_plugin(plugin_file)
+
+
+def _run_batch(name: str, items: List[Tuple[Any, CursorSnapshot, str]]) -> Dict[Any, Any]:
+    """Run a detector over a batch of snapshots inside a helper process
+
+    Results the detector defers are resolved before returning, so the parser
+    always receives final results.
+    """
+    from clang.cindex import CursorKind
+    detector = _WORKER_MANAGER.get_detector(name)
+    if detector is None:
+        return {}
+    available_cursor_kinds = dir(CursorKind)
+    results = {}
+    deferred = {}
+    for key, snapshot, token_str in items:
+        try:
+            result = detector.detect(snapshot, snapshot.token_spellings, token_str, available_cursor_kinds)
+        except Exception as e:
+            logger.warning(f"Error in DSL detector {name} (pid {os.getpid()}): {e}")
+            continue
+        if isinstance(result, dict) and result.get('deferred') is not None:
+            deferred[key] = result.pop('deferred')
+        results[key] = result
+    if deferred:
+        try:
+            resolved = detector.resolve_deferred(list(dict.fromkeys(deferred.values()))) or {}
+            for key, inner_key in deferred.items():
+                if inner_key in resolved:
+                    results[key] = resolved[inner_key]
+        except Exception as e:
+            logger.warning(f"Error resolving deferred results of DSL detector {name} (pid {os.getpid()}): {e}")
+    return results
+
+
+class PluginHost:
+    """Pool of long-lived helper processes running selected plugins"""
+
+    def __init__(self, plugin_files: Dict[str, str], processes: int = 2):
+        """Initialize the plugin host; helper processes are started on first use
+
+        Args:
+            plugin_files: Mapping of detector name -> plugin file defining it
+            processes: Number of helper processes
+        """
+        self.plugin_files = dict(plugin_files)
+        self.processes = max(1, int(processes))
+        self._pool = None
+        self._pool_pid = None
+        atexit.register(self.shutdown)
+
+    def _get_pool(self):
+        # A pool is only usable from the process that created it
+        if self._pool is None or self._pool_pid != os.getpid():
+            context = multiprocessing.get_context("spawn")
+            self._pool = context.Pool(self.processes, initializer=_init_worker,
+                                      initargs=(self.plugin_files,))
+            self._pool_pid = os.getpid()
+            logger.info(f"Started {self.processes} plugin host processes for: {', '.join(self.plugin_files)}")
+        return self._pool
+
+    def run(self, name: str, items: List[Tuple[Any, CursorSnapshot, str]]) -> Dict[Any, Any]:
+        """Run a detector over snapshots, spreading them across the helper processes
+
+        Args:
+            name: Detector name
+            items: List of (key, snapshot, token string) tuples
+
+        Returns:
+            Dictionary mapping keys to detector results
+        """
+        if not items:
+            return {}
+        chunk_size = -(-len(items) // self.processes)
+        chunks = [items[i:i + chunk_size] for i in range(0, len(items), chunk_size)]
+        results = {}
+        for chunk_results in self._get_pool().starmap(_run_batch, [(name, chunk) for chunk in chunks]):
+            results.update(chunk_results)
+        return results
+
+    def shutdown(self):
+        if self._pool is not None and self._pool_pid == os.getpid():
+            self._pool.terminate()
+            self._pool.join()
+        self._pool = None
@@ -2,16 +2,145 @@
 
 import os
 import sys
+import json
+import time
+import signal
+import fnmatch
+import threading
 import importlib.util
 import inspect
-from typing import Dict, List, Any, Type, Optional, Set
+from contextlib import contextmanager
+from typing import Dict, List, Any, Type, Optional, Set, Tuple
 from pathlib import Path
 
 from .feature_detectors import FeatureDetector
+from .plugin_host import PluginHost, CursorSnapshot
+from .detector_cache import cached_result
 from .logs import setup_logging
 
 logger = setup_logging()
 
+# Bumped whenever the layout of cost tables written by foamcd-bench-detectors changes
+COST_TABLE_FORMAT = "1"
+
+
+def load_cost_table(path: str) -> Dict[str, Dict[str, Any]]:
+    """Detector costs of a cost table written by foamcd-bench-detectors, empty if unusable"""
+    try:
+        with open(path) as f:
+            table = json.load(f)
+    except (OSError, ValueError) as e:
+        logger.warning(f"Could not read detector cost table {path}: {e}")
+        return {}
+    if str(table.get('format')) != COST_TABLE_FORMAT:
+        logger.warning(f"Detector cost table {path} has an unsupported format, ignoring it")
+        return {}
+    return table.get('detectors', {})
+
+class DetectorFilter:
+    """Precompiled interest filter of a single detector
+
+    Built once at registration time from the detector's declarative
+    `cursor_kinds`, `required_tokens` and `path_globs` attributes.
+    """
+
+    def __init__(self, detector: FeatureDetector):
+        kinds = getattr(detector, 'cursor_kinds', None)
+        tokens = getattr(detector, 'required_tokens', None)
+        globs = getattr(detector, 'path_globs', None)
+        self.kinds: Optional[frozenset] = (
+            frozenset(k if isinstance(k, str) else k.name for k in kinds)
+            if kinds is not None else None
+        )
+        self.tokens: Optional[Tuple[str, ...]] = tuple(tokens) if tokens is not None else None
+        self.globs: Optional[Tuple[str, ...]] = tuple(globs) if globs is not None else None
+
+    def accepts_kind(self, kind_name: Optional[str]) -> bool:
+        return self.kinds is None or kind_name in self.kinds
+
+    def accepts_tokens(self, token_str: str) -> bool:
+        if self.tokens is None:
+            return True
+        if not token_str:
+            return False
+        return any(token in token_str for token in self.tokens)
+
+    def accepts_path(self, file_path: Optional[str]) -> bool:
+        if self.globs is None:
+            return True
+        if not file_path:
+            return False
+        return any(fnmatch.fnmatch(file_path, pattern) for pattern in self.globs)
+
+
+def _cursor_kind_name(cursor) -> Optional[str]:
+    kind = getattr(cursor, 'kind', None)
+    if kind is None or isinstance(kind, str):
+        return kind
+    return getattr(kind, 'name', None)
+
+
+def _cursor_file_path(cursor) -> Optional[str]:
+    location = getattr(cursor, 'location', None)
+    file = getattr(location, 'file', None) if location is not None else None
+    return getattr(file, 'name', None) if file is not None else None
+
+
+class DetectorTimeout(BaseException):
+    """Raised inside a detector call that exceeds its per-call budget
+
+    Not an Exception, so that the `except Exception` handlers of a detector cannot swallow it.
+    """
+
+
+@contextmanager
+def _call_deadline(seconds: float):
+    """Interrupt the enclosed call after the given time (main thread only)
+
+    Relies on SIGALRM, which also interrupts regular expression matching; where
+    it is not available, overruns are only detected after the call returns.
+    """
+    if seconds <= 0 or not hasattr(signal, 'setitimer') or threading.current_thread() is not threading.main_thread():
+        yield
+        return
+    def _on_alarm(signum, frame):
+        raise DetectorTimeout()
+    previous = signal.signal(signal.SIGALRM, _on_alarm)
+    signal.setitimer(signal.ITIMER_REAL, seconds)
+    try:
+        yield
+    finally:
+        signal.setitimer(signal.ITIMER_REAL, 0)
+        signal.signal(signal.SIGALRM, previous)
+
+
+class DetectorStats:
+    """Run-wide timing and circuit breaker state of a single detector"""
+
+    def __init__(self):
+        self.calls = 0
+        self.skipped = 0
+        self.timeouts = 0
+        self.errors = 0
+        self.total_time = 0.0
+        self.max_call_time = 0.0
+        self.state = 'active'  # active, sampled or disabled
+        self.reason = None
+        self._sample_counter = 0
+
+    def to_dict(self) -> Dict[str, Any]:
+        return {
+            'calls': self.calls,
+            'skipped': self.skipped,
+            'timeouts': self.timeouts,
+            'errors': self.errors,
+            'total_time': self.total_time,
+            'max_call_time': self.max_call_time,
+            'state': self.state,
+            'reason': self.reason
+        }
+
+
 class PluginManager:
     """Manages DSL feature detector plugins and custom entity field definitions"""
     
@@ -24,6 +153,12 @@ class PluginManager:
                    - enabled: Whether plugins are enabled at all
                    - disabled_plugins: List of plugin names to disable
                    - only_plugins: Whitelist of plugins to enable (if empty, all non-disabled are enabled)
+                   - out_of_process: Plugins to run in helper processes, fed cursor snapshots
+                   - host_processes: Number of helper processes for out-of-process plugins
+                   - budgets: Time budgets per detector with keys per_call_ms, per_run_s,
+                     action ('disable' or 'sample') and sample_every
+                   - cost_ceiling: Benchmarked cost ceilings checked when loading, with keys
+                     table (cost table path), p99_us and per_detector
         """
         self.plugin_dirs = plugin_dirs or []
         
@@ -46,6 +181,31 @@ class PluginManager:
         self.plugins_enabled = self.config.get("enabled", True)
         self.disabled_plugins = set(self.config.get("disabled_plugins", []))
         self.only_plugins = set(self.config.get("only_plugins", []))
+        # Interest filters per detector, and detector names per cursor kind
+        # (lazily filled, reset whenever a detector is registered)
+        self.detector_filters: Dict[str, DetectorFilter] = {}
+        self._detectors_by_kind: Dict[Optional[str], List[str]] = {}
+        # Out-of-process plugins: snapshots queued per detector until the batch is resolved
+        self.out_of_process = set(self.config.get("out_of_process", []))
+        self.host_processes = self.config.get("host_processes", 2)
+        self.plugin_files: Dict[str, str] = {}
+        self.plugin_host: Optional[PluginHost] = None
+        self.compile_args_provider = None
+        self.macro_index = None
+        self._remote_items: Dict[str, Dict[int, Tuple[CursorSnapshot, str]]] = {}
+        self._remote_key = 0
+        # Time budgets and circuit breaking; a budget of 0 means unlimited
+        budgets = self.config.get("budgets", {}) or {}
+        self.per_call_budget = float(budgets.get("per_call_ms", 0) or 0) / 1000.0
+        self.per_run_budget = float(budgets.get("per_run_s", 0) or 0)
+        self.budget_action = budgets.get("action", "disable")
+        self.sample_every = max(1, int(budgets.get("sample_every", 10) or 10))
+        self.detector_stats: Dict[str, DetectorStats] = {}
+        # Plugins whose benchmarked p99 time per call exceeds their ceiling are not loaded
+        cost_ceiling = self.config.get("cost_ceiling", {}) or {}
+        self.cost_table = load_cost_table(cost_ceiling.get("table")) if cost_ceiling.get("table") else {}
+        self.default_cost_ceiling_us = float(cost_ceiling.get("p99_us", 0) or 0)
+        self.cost_ceilings = dict(cost_ceiling.get("per_detector", {}) or {})
         
     def discover_plugins(self):
         """Discover and load all plugins from the plugin directories"""
@@ -107,7 +267,8 @@ class PluginManager:
                 return False
             for detector_class in detector_classes:
                 detector = detector_class()
-                self.register_detector(detector)
+                if self.register_detector(detector):
+                    self.plugin_files[detector.name] = abs_plugin_path
                 if hasattr(detector_class, "entity_fields") and isinstance(detector_class.entity_fields, dict):
                     logger.debug(f"Found entity_fields in {detector.name}: {detector_class.entity_fields.keys()}")
                     self.register_custom_entity_fields(detector.name, detector_class.entity_fields)
@@ -141,7 +302,15 @@ class PluginManager:
         if detector.name in self.detectors:
             logger.warning(f"Detector already registered with name: {detector.name}")
             return False
+        over_ceiling = self._over_cost_ceiling(detector)
+        if over_ceiling:
+            logger.warning(f"Not loading plugin {detector.name}: {over_ceiling}")
+            self.disabled_plugins.add(detector.name)
+            return False
         self.detectors[detector.name] = detector
+        self.detector_filters[detector.name] = DetectorFilter(detector)
+        self.detector_stats[detector.name] = DetectorStats()
+        self._detectors_by_kind.clear()
         logger.debug(f"Registered plugin: {detector.name} ({detector.description})")
         if hasattr(detector, 'entity_fields') and detector.entity_fields:
             for field_name, field_def in detector.entity_fields.items():
@@ -154,6 +323,20 @@ class PluginManager:
                 
         return True
     
+    def _over_cost_ceiling(self, detector: FeatureDetector) -> Optional[str]:
+        """Why a detector's benchmarked cost is over its ceiling, None if it is not (or unknown)"""
+        ceiling = float(self.cost_ceilings.get(detector.name, self.default_cost_ceiling_us) or 0)
+        cost = self.cost_table.get(detector.name)
+        if ceiling <= 0 or not cost:
+            return None
+        if str(cost.get('version')) != str(detector.version):
+            logger.debug(f"Cost of {detector.name} was benchmarked at version {cost.get('version')}, "
+                         f"not {detector.version}; not checking its ceiling")
+            return None
+        if cost.get('p99_us', 0) > ceiling:
+            return f"benchmarked p99 of {cost['p99_us']:g} us per call, ceiling is {ceiling:g} us"
+        return None
+    
     def register_custom_entity_field(self, field_name: str, field_type: str, description: str, plugin_name: str) -> None:
         """Register a single custom entity field defined by a plugin
         
@@ -223,47 +406,261 @@ class PluginManager:
             Detector instance or None if not found
         """
         return self.detectors.get(name)
+
+    def _candidate_detectors(self, kind_name: Optional[str]) -> List[str]:
+        """Names of detectors whose cursor kind filter accepts the given kind"""
+        candidates = self._detectors_by_kind.get(kind_name)
+        if candidates is None:
+            candidates = [name for name, detector_filter in self.detector_filters.items()
+                          if detector_filter.accepts_kind(kind_name)]
+            self._detectors_by_kind[kind_name] = candidates
+        return candidates
     
-    def detect_features(self, cursor, token_spellings, token_str, available_cursor_kinds) -> Dict[str, Any]:
+    def detect_features(self, cursor, token_spellings, token_str, available_cursor_kinds,
+                        cached: Optional[Dict[str, Dict[str, Any]]] = None,
+                        fresh: Optional[Dict[str, Tuple[str, Any]]] = None) -> Dict[str, Any]:
         """Run all DSL plugin detectors and return detected features and custom entity fields
+
+        Detectors whose declared interest filters (cursor kinds, required tokens,
+        path globs) reject the cursor are skipped without calling `detect`.
         
         Args:
             cursor: Clang cursor
             token_spellings: List of token spellings
             token_str: Combined token string
             available_cursor_kinds: List of available cursor kinds
+            cached: Optional cached results ({detector: {version: result}}); detectors
+                    with a result at their current version are not run
+            fresh: Optional dictionary receiving (version, result) of detectors that ran
             
         Returns:
-            Dictionary with 'features' (set of feature names) and 'custom_fields' (dict of field values)
+            Dictionary with 'features' (set of feature names), 'custom_fields' (dict of field values)
+            and 'deferred' (list of (detector name, key) pairs to pass to `resolve_deferred`)
         """
         features = set()
         custom_fields = {}
+        deferred = []
+        candidates = self._candidate_detectors(_cursor_kind_name(cursor))
+        file_path = None
         
-        for name, detector in self.detectors.items():
+        for name in candidates:
+            detector = self.detectors[name]
+            detector_filter = self.detector_filters[name]
+            if not detector_filter.accepts_tokens(token_str):
+                continue
+            if detector_filter.globs is not None:
+                if file_path is None:
+                    file_path = _cursor_file_path(cursor) or ""
+                if not detector_filter.accepts_path(file_path):
+                    continue
+            hit, value = cached_result(cached, detector)
+            if hit:
+                self._apply_result(name, detector.restore_cached(value), features, custom_fields)
+                continue
+            stats = self.detector_stats[name]
+            if not self._admit(stats):
+                stats.skipped += 1
+                continue
+            if self._is_remote(name):
+                deferred.append((name, self._queue_remote(name, cursor, token_spellings, token_str)))
+                continue
+            start = time.perf_counter()
             try:
-                result = detector.detect(cursor, token_spellings, token_str, available_cursor_kinds)
+                try:
+                    with _call_deadline(self.per_call_budget):
+                        result = detector.detect(cursor, token_spellings, token_str, available_cursor_kinds)
+                finally:
+                    self._account(name, time.perf_counter() - start)
                 logger.debug(f"Detector {name} returned result: {result}")
-                if isinstance(result, bool):
-                    if result:
-                        features.add(name)
-                        logger.debug(f"Added feature {name} from boolean result")
-                elif isinstance(result, dict):
-                    if result.get('detected', False):
-                        features.add(name)
-                        logger.debug(f"Added feature {name} from dict result with 'detected': {result.get('detected')}")
-                    if 'fields' in result and isinstance(result['fields'], dict):
-                        logger.debug(f"Fields from {name}: {result['fields']}")
-                        logger.debug(f"Registered custom_entity_fields: {list(self.custom_entity_fields.keys())}")
-                        for field_name, value in result['fields'].items():
-                            if field_name in self.custom_entity_fields:
-                                logger.debug(f"Adding field {field_name}={value} to custom_fields")
-                                custom_fields[field_name] = value
-                            else:
-                                logger.warning(f"Plugin {name} returned unregistered field: {field_name}")
+                self._apply_result(name, result, features, custom_fields)
+                if isinstance(result, dict) and result.get('deferred') is not None:
+                    deferred.append((name, result['deferred']))
+                elif fresh is not None and detector.cacheable:
+                    fresh[name] = (detector.version, detector.cache_value(result))
+            except DetectorTimeout:
+                # Already counted and tripped by _account
+                logger.debug(f"DSL detector {name} interrupted after exceeding its per-call budget")
             except Exception as e:
+                stats.errors += 1
                 logger.warning(f"Error in DSL detector {name}: {e}")
                 
         return {
             'features': features,
-            'custom_fields': custom_fields
+            'custom_fields': custom_fields,
+            'deferred': deferred
         }
+
+    def macro_names(self) -> Set[str]:
+        """Names of all macros registered detectors want indexed"""
+        names = set()
+        for detector in self.detectors.values():
+            if detector.macros:
+                names.update(detector.macros)
+        return names
+
+    def set_macro_index(self, macro_index):
+        """Hand the macro index of the current translation unit to interested detectors"""
+        self.macro_index = macro_index
+        for detector in self.detectors.values():
+            if detector.macros:
+                detector.macro_index = macro_index
+
+    def _admit(self, stats: DetectorStats) -> bool:
+        """Whether a detector gets to run on the current cursor, given its breaker state"""
+        if stats.state == 'active':
+            return True
+        if stats.state == 'sampled':
+            stats._sample_counter += 1
+            return stats._sample_counter % self.sample_every == 0
+        return False
+
+    def _account(self, name: str, elapsed: float, is_call: bool = True):
+        """Record time spent in a detector and trip its breaker when over budget"""
+        stats = self.detector_stats[name]
+        stats.total_time += elapsed
+        if is_call:
+            stats.calls += 1
+            stats.max_call_time = max(stats.max_call_time, elapsed)
+            if self.per_call_budget and elapsed > self.per_call_budget:
+                stats.timeouts += 1
+                self._trip(name, f"call took {elapsed * 1000:.1f} ms, budget is {self.per_call_budget * 1000:g} ms")
+        if self.per_run_budget and stats.total_time > self.per_run_budget and stats.state != 'disabled':
+            self._trip(name, f"spent {stats.total_time:.1f} s, run budget is {self.per_run_budget:g} s", disable=True)
+
+    def _trip(self, name: str, reason: str, disable: bool = False):
+        """Disable or sample a detector for the rest of the run
+
+        Exhausting the run budget, or overrunning again while sampled, disables it.
+        """
+        stats = self.detector_stats[name]
+        if stats.state == 'disabled':
+            return
+        if disable or stats.state == 'sampled' or self.budget_action != 'sample':
+            stats.state = 'disabled'
+        else:
+            stats.state = 'sampled'
+        stats.reason = reason
+        if stats.state == 'sampled':
+            logger.warning(f"DSL detector {name} is now sampled (1 in {self.sample_every} cursors): {reason}")
+        else:
+            logger.warning(f"DSL detector {name} is disabled for the rest of the run: {reason}")
+
+    def get_run_stats(self) -> Dict[str, Dict[str, Any]]:
+        """Timing and circuit breaker state of all registered detectors"""
+        return {name: stats.to_dict() for name, stats in self.detector_stats.items()}
+
+    def merge_run_stats(self, run_stats: Dict[str, Dict[str, Any]]):
+        """Fold statistics gathered by another process of the same run into this manager's
+
+        Args:
+            run_stats: Statistics in the form `get_run_stats` returns
+        """
+        severity = {'active': 0, 'sampled': 1, 'disabled': 2}
+        for name, other in run_stats.items():
+            stats = self.detector_stats.setdefault(name, DetectorStats())
+            stats.calls += other['calls']
+            stats.skipped += other['skipped']
+            stats.timeouts += other['timeouts']
+            stats.errors += other['errors']
+            stats.total_time += other['total_time']
+            stats.max_call_time = max(stats.max_call_time, other['max_call_time'])
+            if severity.get(other['state'], 0) > severity.get(stats.state, 0):
+                stats.state = other['state']
+                stats.reason = other['reason']
+
+    def _is_remote(self, name: str) -> bool:
+        return name in self.out_of_process and name in self.plugin_files
+
+    def _queue_remote(self, name: str, cursor, token_spellings, token_str) -> int:
+        """Snapshot a cursor for an out-of-process detector and return its deferred key"""
+        compile_args = None
+        file_path = _cursor_file_path(cursor)
+        if self.compile_args_provider and file_path:
+            try:
+                compile_args = self.compile_args_provider(file_path)
+            except Exception as e:
+                logger.debug(f"Could not get compile arguments for {file_path}: {e}")
+        snapshot = CursorSnapshot.from_cursor(cursor, token_spellings, compile_args)
+        detector = self.detectors[name]
+        if detector.macros and self.macro_index is not None:
+            snapshot.macro_invocations = self.macro_index.within_cursor(cursor, detector.macros)
+        self._remote_key += 1
+        self._remote_items.setdefault(name, {})[self._remote_key] = (snapshot, token_str)
+        return self._remote_key
+
+    def _resolve_remote(self, name: str, keys: List[Any]) -> Dict[Any, Any]:
+        """Ship queued snapshots of an out-of-process detector to the plugin host"""
+        queued = self._remote_items.get(name, {})
+        items = [(key, *queued.pop(key)) for key in keys if key in queued]
+        if not items:
+            return {}
+        if self.plugin_host is None:
+            remote_files = {n: f for n, f in self.plugin_files.items() if self._is_remote(n)}
+            self.plugin_host = PluginHost(remote_files, self.host_processes)
+        return self.plugin_host.run(name, items)
+
+    def shutdown(self):
+        """Stop the helper processes of out-of-process plugins, if any"""
+        if self.plugin_host is not None:
+            self.plugin_host.shutdown()
+            self.plugin_host = None
+
+    def _apply_result(self, name: str, result, features: Set[str], custom_fields: Dict[str, Any]) -> None:
+        """Merge a single detector result into the detected features and custom fields"""
+        if isinstance(result, bool):
+            if result:
+                features.add(name)
+                logger.debug(f"Added feature {name} from boolean result")
+        elif isinstance(result, dict):
+            if result.get('detected', False):
+                features.add(name)
+                logger.debug(f"Added feature {name} from dict result with 'detected': {result.get('detected')}")
+            if 'fields' in result and isinstance(result['fields'], dict):
+                logger.debug(f"Fields from {name}: {result['fields']}")
+                logger.debug(f"Registered custom_entity_fields: {list(self.custom_entity_fields.keys())}")
+                for field_name, value in result['fields'].items():
+                    if field_name in self.custom_entity_fields:
+                        logger.debug(f"Adding field {field_name}={value} to custom_fields")
+                        custom_fields[field_name] = value
+                    else:
+                        logger.warning(f"Plugin {name} returned unregistered field: {field_name}")
+
+    def resolve_deferred(self, pending: List[Tuple[str, Any]]) -> Dict[Tuple[str, Any], Dict[str, Any]]:
+        """Resolve detection results deferred by plugins, batched per detector
+        
+        Args:
+            pending: List of (detector name, deferred key) pairs as returned in the
+                     'deferred' entry of `detect_features`
+            
+        Returns:
+            Dictionary mapping each (detector name, key) pair to a dictionary with
+            'features' and 'custom_fields', like `detect_features` returns
+        """
+        keys_by_detector: Dict[str, List[Any]] = {}
+        for name, key in pending:
+            keys = keys_by_detector.setdefault(name, [])
+            if key not in keys:
+                keys.append(key)
+        resolved = {}
+        for name, keys in keys_by_detector.items():
+            detector = self.detectors.get(name)
+            if detector is None:
+                continue
+            start = time.perf_counter()
+            try:
+                if self._is_remote(name):
+                    results = self._resolve_remote(name, keys)
+                else:
+                    results = detector.resolve_deferred(keys) or {}
+            except Exception as e:
+                self.detector_stats[name].errors += 1
+                logger.warning(f"Error resolving deferred results of DSL detector {name}: {e}")
+                continue
+            finally:
+                self._account(name, time.perf_counter() - start, is_call=False)
+            for key, result in results.items():
+                features = set()
+                custom_fields = {}
+                self._apply_result(name, result, features, custom_fields)
+                resolved[(name, key)] = {'features': features, 'custom_fields': custom_fields}
+        return resolved
@@ -0,0 +1,145 @@
+#!/usr/bin/env python3
+
+"""
+Cost-model scheduling of translation units across parse lanes
+
+Parse durations and include sets recorded by previous runs (tu_stats and
+tu_includes tables) decide the order and placement of the files of a run:
+longest processing time first for load balance, with each file going to the
+lane that already parsed most of its headers among the lanes whose load is
+within a small slack of the least loaded one, so shared headers stay warm
+in that lane's caches.
+
+The same machinery splits a run into shards parsed on separate nodes, each
+into its own database, to be combined with foamcd-merge.
+"""
+
+import os
+import hashlib
+from statistics import median
+from typing import Dict, List, Any, Optional, Set, Tuple
+
+from .logs import setup_logging
+
+logger = setup_logging()
+
+# Expected parse time of a file, in seconds, before any duration was recorded
+DEFAULT_TU_DURATION = 1.0
+
+
+class TUSchedule:
+    """Files of a run distributed across lanes, with their predicted parse times"""
+
+    def __init__(self, lanes: List[List[str]], durations: Dict[str, float]):
+        self.lanes = lanes
+        self.durations = durations
+
+    @property
+    def predicted_loads(self) -> List[float]:
+        return [sum(self.durations[path] for path in lane) for lane in self.lanes]
+
+    @property
+    def predicted_makespan(self) -> float:
+        return max(self.predicted_loads, default=0.0)
+
+    def __len__(self):
+        return sum(len(lane) for lane in self.lanes)
+
+
+def _history_of(history: Dict[str, Dict[str, Any]], path: str) -> Dict[str, Any]:
+    # Parse cost is recorded by real path
+    return history.get(path) or history.get(os.path.realpath(path)) or {}
+
+
+def estimate_durations(files: List[str], history: Dict[str, Dict[str, Any]]) -> Dict[str, float]:
+    """Expected parse time of each file
+
+    Files parsed before are expected to take as long as last time; the others
+    are assumed to cost the median of all recorded durations.
+    """
+    recorded = [entry['duration'] for entry in history.values() if entry.get('duration')]
+    fallback = median(recorded) if recorded else DEFAULT_TU_DURATION
+    return {path: _history_of(history, path).get('duration') or fallback for path in files}
+
+
+def schedule_translation_units(files: List[str], history: Dict[str, Dict[str, Any]],
+                               lanes: int = 1, affinity_slack: float = 0.1) -> TUSchedule:
+    """Distribute files across parse lanes
+
+    Args:
+        files: Paths of the files to parse
+        history: Recorded parse cost per path, as returned by EntityDatabase.get_tu_history
+        lanes: Number of lanes parsing concurrently
+        affinity_slack: How much more loaded than the least loaded lane, as a fraction
+            of the file's own duration, a lane sharing headers with the file may be
+
+    Returns:
+        The schedule; each lane lists its files in parse order
+    """
+    lanes = max(1, int(lanes))
+    durations = estimate_durations(files, history)
+    loads = [0.0] * lanes
+    lane_files: List[List[str]] = [[] for _ in range(lanes)]
+    lane_includes: List[Set[str]] = [set() for _ in range(lanes)]
+    for path in sorted(files, key=lambda path: (-durations[path], path)):
+        includes = _history_of(history, path).get('includes') or set()
+        bound = min(loads) + affinity_slack * durations[path]
+        candidates = [i for i in range(lanes) if loads[i] <= bound]
+        lane = max(candidates, key=lambda i: (len(includes & lane_includes[i]), -loads[i], -i))
+        lane_files[lane].append(path)
+        lane_includes[lane] |= includes
+        loads[lane] += durations[path]
+    schedule = TUSchedule(lane_files, durations)
+    unknown = sum(1 for path in files if not _history_of(history, path))
+    logger.info(f"Scheduled {len(files)} files on {lanes} lanes, predicted makespan {schedule.predicted_makespan:.2f}s "
+                f"({unknown} without history)")
+    return schedule
+
+
+def report_makespan(schedule: TUSchedule, lane_durations: List[Optional[float]]):
+    """Log the predicted against the actual makespan of a run, lane by lane"""
+    predicted = schedule.predicted_loads
+    for i, (expected, actual) in enumerate(zip(predicted, lane_durations)):
+        if schedule.lanes[i]:
+            actual_str = f"{actual:.2f}s" if actual is not None else "failed"
+            logger.debug(f"Lane {i}: {len(schedule.lanes[i])} files, predicted {expected:.2f}s, actual {actual_str}")
+    actual_makespan = max((d for d in lane_durations if d is not None), default=0.0)
+    logger.info(f"Makespan: predicted {schedule.predicted_makespan:.2f}s, actual {actual_makespan:.2f}s")
+
+
+def parse_shard_spec(spec: str) -> Tuple[int, int]:
+    """Parse a shard specification 'i/N', with 0 <= i < N"""
+    try:
+        index, count = (int(part) for part in spec.split('/'))
+    except ValueError:
+        raise ValueError(f"Invalid shard '{spec}', expected i/N")
+    if count < 1 or not 0 <= index < count:
+        raise ValueError(f"Invalid shard '{spec}', expected 0 <= i < N")
+    return index, count
+
+
+def shard_database_path(db_path: str, index: int, count: int) -> str:
+    """Database a shard writes to, e.g. docs.shard-3-of-8.db for docs.db"""
+    root, extension = os.path.splitext(db_path)
+    return f"{root}.shard-{index}-of-{count}{extension or '.db'}"
+
+
+def select_shard(files: List[str], index: int, count: int,
+                 history: Optional[Dict[str, Dict[str, Any]]] = None) -> List[str]:
+    """Files of one shard of a run
+
+    Every shard computes the same partition independently: by a stable hash of
+    the file paths, or, given the parse history of a previous (merged) run,
+    by cost-balancing the files across shards like lanes.
+
+    Args:
+        files: Paths of all files of the run
+        index: Index of the shard, from 0
+        count: Number of shards
+        history: Recorded parse cost per path, for cost-balanced shards
+    """
+    files = sorted(set(files))
+    if history:
+        return schedule_translation_units(files, history, count).lanes[index]
+    return [path for path in files
+            if int(hashlib.sha256(path.encode('utf-8')).hexdigest()[:16], 16) % count == index]
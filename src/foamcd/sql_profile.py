@@ -0,0 +1,297 @@
+#!/usr/bin/env python3
+
+"""
+Profiling of the SQL statements issued through EntityDatabase
+
+With profiling enabled, EntityDatabase wraps its cursor so that every statement
+is accounted to its normalized text (literals and IN lists collapsed) and the
+Python call site issuing it: execution count, time spent executing and fetching,
+and rows returned. Statements run from the EntityDatabase methods are charged to
+the method and to the code calling that method, so a query repeated once per
+entity from a markdown loop (N+1) shows up as one line with many calls.
+
+The first execution of each statement is also run through EXPLAIN QUERY PLAN,
+to tell whether it searches an index or scans whole tables.
+
+Profiling is off unless enabled with --sql-profile or database.profile; the
+ranked report is logged when the process exits. Parse lanes send their
+statistics back to the parent process.
+"""
+
+import os
+import re
+import sys
+import time
+import atexit
+import sqlite3
+from typing import Any, Dict, List, Optional, Tuple
+
+from .logs import setup_logging
+
+logger = setup_logging()
+
+_THIS_FILE = os.path.normcase(os.path.abspath(__file__))
+_DB_FILE = os.path.join(os.path.dirname(_THIS_FILE), 'db.py')
+
+_STRING_LITERAL = re.compile(r"'(?:[^']|'')*'")
+_NUMBER_LITERAL = re.compile(r"(?<![\w.])-?\d+(?:\.\d+)?(?![\w.])")
+_PARAMETER_LIST = re.compile(r"\(\s*\?(?:\s*,\s*\?)+\s*\)")
+_WHITESPACE = re.compile(r"\s+")
+# Statements EXPLAIN QUERY PLAN tells something about
+_EXPLAINABLE = ('SELECT', 'WITH', 'UPDATE', 'DELETE', 'INSERT', 'REPLACE')
+
+
+def normalize_statement(sql: str) -> str:
+    """Statement text with its literals and parameter lists collapsed, to group executions"""
+    sql = _STRING_LITERAL.sub('?', sql)
+    sql = _NUMBER_LITERAL.sub('?', sql)
+    sql = _WHITESPACE.sub(' ', sql).strip()
+    return _PARAMETER_LIST.sub('(?, ...)', sql)
+
+
+def _call_site() -> str:
+    """Where a statement comes from: the first frame outside this module, and
+    for EntityDatabase methods, also the first frame outside db.py calling it"""
+    frame = sys._getframe(2)
+    while frame and os.path.normcase(frame.f_code.co_filename) == _THIS_FILE:
+        frame = frame.f_back
+    if frame is None:
+        return '?'
+    site = f"{os.path.basename(frame.f_code.co_filename)}:{frame.f_lineno} ({frame.f_code.co_name})"
+    if os.path.normcase(frame.f_code.co_filename) == _DB_FILE:
+        caller = frame.f_back
+        while caller and os.path.normcase(caller.f_code.co_filename) == _DB_FILE:
+            caller = caller.f_back
+        if caller is not None:
+            site += f" <- {os.path.basename(caller.f_code.co_filename)}:{caller.f_lineno} ({caller.f_code.co_name})"
+    return site
+
+
+class StatementStats:
+    """Executions of one normalized statement from one call site"""
+
+    __slots__ = ('calls', 'seconds', 'rows', 'plan')
+
+    def __init__(self):
+        self.calls = 0
+        self.seconds = 0.0
+        self.rows = 0
+        # EXPLAIN QUERY PLAN details, None if not explained
+        self.plan: Optional[List[str]] = None
+
+    @property
+    def uses_index(self) -> Optional[bool]:
+        """Whether the plan searches an index, None if there is no plan"""
+        if not self.plan:
+            return None
+        return any('INDEX' in detail or 'PRIMARY KEY' in detail for detail in self.plan)
+
+    @property
+    def scans(self) -> List[str]:
+        """Tables the plan reads in full, without an index"""
+        scanned = []
+        for detail in self.plan or []:
+            if detail.startswith('SCAN ') and 'INDEX' not in detail and 'CONSTANT ROW' not in detail:
+                scanned.append(detail[5:].split()[0])
+        return scanned
+
+
+class _ProfilingCursor:
+    """sqlite3 cursor recording what its statements cost"""
+
+    def __init__(self, cursor: sqlite3.Cursor, profiler: 'SqlProfiler'):
+        self._cursor = cursor
+        self._profiler = profiler
+        self._current: Optional[StatementStats] = None
+
+    def __getattr__(self, name):
+        return getattr(self._cursor, name)
+
+    def _run(self, method, sql: str, parameters: Any, many: bool = False):
+        stats, explain = self._profiler._stats_for(sql)
+        if explain:
+            stats.plan = self._profiler._explain(self._cursor.connection, sql, parameters, many)
+        started = time.perf_counter()
+        try:
+            return method(sql, parameters)
+        finally:
+            stats.calls += 1
+            stats.seconds += time.perf_counter() - started
+            self._current = stats
+
+    def execute(self, sql: str, parameters: Any = ()):
+        self._run(self._cursor.execute, sql, parameters)
+        return self
+
+    def executemany(self, sql: str, seq_of_parameters):
+        seq_of_parameters = list(seq_of_parameters)
+        self._run(self._cursor.executemany, sql, seq_of_parameters, many=True)
+        return self
+
+    def executescript(self, sql_script: str):
+        stats, _ = self._profiler._stats_for(sql_script)
+        started = time.perf_counter()
+        try:
+            self._cursor.executescript(sql_script)
+        finally:
+            stats.calls += 1
+            stats.seconds += time.perf_counter() - started
+            self._current = None
+        return self
+
+    def _fetched(self, started: float, rows: int):
+        # Rows are stepped through while fetching, which is part of what the statement costs
+        if self._current is not None:
+            self._current.seconds += time.perf_counter() - started
+            self._current.rows += rows
+
+    def fetchone(self):
+        started = time.perf_counter()
+        row = self._cursor.fetchone()
+        self._fetched(started, row is not None)
+        return row
+
+    def fetchmany(self, size: int = None):
+        started = time.perf_counter()
+        rows = self._cursor.fetchmany(size if size is not None else self._cursor.arraysize)
+        self._fetched(started, len(rows))
+        return rows
+
+    def fetchall(self):
+        started = time.perf_counter()
+        rows = self._cursor.fetchall()
+        self._fetched(started, len(rows))
+        return rows
+
+    def __iter__(self):
+        while True:
+            row = self.fetchone()
+            if row is None:
+                return
+            yield row
+
+
+class SqlProfiler:
+    """Collects statement statistics of this process and of the workers reporting to it"""
+
+    def __init__(self):
+        self.enabled = False
+        self.stats: Dict[Tuple[str, str], StatementStats] = {}
+        self._plans: Dict[str, Optional[List[str]]] = {}
+        self._reporting = False
+
+    def enable(self, report_at_exit: bool = True):
+        """Profile the cursors of databases opened from now on
+
+        Args:
+            report_at_exit: Log the ranked report when the process exits
+        """
+        self.enabled = True
+        if report_at_exit and not self._reporting:
+            self._reporting = True
+            atexit.register(self._report_at_exit)
+
+    def disable(self):
+        """Stop profiling new cursors and drop the statistics"""
+        self.enabled = False
+        self.stats = {}
+        self._plans = {}
+
+    def wrap(self, cursor: sqlite3.Cursor):
+        """Cursor to use in place of the given one, profiled if profiling is enabled"""
+        if not self.enabled:
+            return cursor
+        return _ProfilingCursor(cursor, self)
+
+    def _stats_for(self, sql: str) -> Tuple[StatementStats, bool]:
+        """Statistics of a statement from the current call site, and whether it needs explaining"""
+        statement = normalize_statement(sql)
+        key = (statement, _call_site())
+        stats = self.stats.get(key)
+        if stats is None:
+            stats = self.stats[key] = StatementStats()
+            if statement in self._plans:
+                stats.plan = self._plans[statement]
+            else:
+                return stats, statement.upper().startswith(_EXPLAINABLE)
+        return stats, False
+
+    def _explain(self, connection: sqlite3.Connection, sql: str, parameters: Any, many: bool) -> Optional[List[str]]:
+        statement = normalize_statement(sql)
+        if many:
+            parameters = parameters[0] if parameters else ()
+        try:
+            plan = [row[3] for row in connection.execute(f"EXPLAIN QUERY PLAN {sql}", parameters).fetchall()]
+        except (sqlite3.Error, ValueError, TypeError) as e:
+            logger.debug(f"Could not explain {statement}: {e}")
+            plan = None
+        self._plans[statement] = plan
+        return plan
+
+    def drain(self) -> List[List[Any]]:
+        """Statistics so far, removed; workers send these to their parent"""
+        report = [[statement, site, stats.calls, stats.seconds, stats.rows, stats.plan]
+                  for (statement, site), stats in self.stats.items()]
+        self.stats = {}
+        return report
+
+    def extend(self, report: Optional[List[List[Any]]]):
+        """Add the statistics of a worker"""
+        if not self.enabled or not report:
+            return
+        for statement, site, calls, seconds, rows, plan in report:
+            stats = self.stats.setdefault((statement, site), StatementStats())
+            stats.calls += calls
+            stats.seconds += seconds
+            stats.rows += rows
+            if stats.plan is None:
+                stats.plan = plan
+
+    def ranked(self, top: int = 25) -> List[Dict[str, Any]]:
+        """Statements by total time, with their call site, counts and index use
+
+        Args:
+            top: Number of entries to return
+
+        Returns:
+            List of {statement, site, calls, total_ms, mean_us, rows, uses_index, scans}
+        """
+        ranked = sorted(self.stats.items(), key=lambda item: -item[1].seconds)[:top]
+        return [{
+            'statement': statement,
+            'site': site,
+            'calls': stats.calls,
+            'total_ms': round(stats.seconds * 1e3, 3),
+            'mean_us': round(stats.seconds / stats.calls * 1e6, 1) if stats.calls else 0.0,
+            'rows': stats.rows,
+            'uses_index': stats.uses_index,
+            'scans': stats.scans,
+        } for (statement, site), stats in ranked]
+
+    def report(self, top: int = 25) -> str:
+        """Ranked report as text, most expensive statement and call site first"""
+        total = sum(stats.seconds for stats in self.stats.values())
+        calls = sum(stats.calls for stats in self.stats.values())
+        lines = [f"SQL profile: {calls} executions of {len({key[0] for key in self.stats})} statements, "
+                 f"{total:.3f} s",
+                 f"{'Total ms':>10} {'Calls':>8} {'Mean us':>9} {'Rows':>9}  {'Plan':<12} Statement / call site",
+                 "-" * 100]
+        for entry in self.ranked(top):
+            if entry['scans']:
+                plan = 'SCAN ' + ','.join(entry['scans'])
+            else:
+                plan = {True: 'index', False: 'no index', None: '-'}[entry['uses_index']]
+            statement = entry['statement'] if len(entry['statement']) <= 120 else entry['statement'][:117] + '...'
+            lines.append(f"{entry['total_ms']:>10.1f} {entry['calls']:>8} {entry['mean_us']:>9.1f} "
+                         f"{entry['rows']:>9}  {plan:<12} {statement}")
+            lines.append(f"{'':>52}@ {entry['site']}")
+        return "\n".join(lines)
+
+    def _report_at_exit(self):
+        if self.enabled and self.stats:
+            for line in self.report().splitlines():
+                logger.info(line)
+
+
+# SQL profiler of this process, enabled by the --sql-profile options of the entry points
+profiler = SqlProfiler()
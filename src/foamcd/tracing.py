@@ -0,0 +1,185 @@
+#!/usr/bin/env python3
+
+"""
+Per-phase tracing of parse runs and markdown generation
+
+Spans record the phases of each translation unit (compile arguments, libclang
+parse, traversal, database write), the resolution passes and the sections of
+each generated page. They are written in the Chrome trace event format, which
+Perfetto and chrome://tracing open; every parse lane or worker process gets its
+own row. Time spent in feature detectors and plugins is scattered across the
+traversal, so it is summed per translation unit and reported in the arguments
+of the traversal span.
+
+Tracing is off unless enabled with --trace; disabled spans are a shared no-op
+context manager, so instrumented code pays one attribute check per span.
+"""
+
+import os
+import json
+import time
+import functools
+from typing import Any, Callable, Dict, List, Optional
+
+from .logs import setup_logging
+
+logger = setup_logging()
+
+
+class _NullSpan:
+    """Span of a disabled tracer"""
+
+    def __enter__(self):
+        return self
+
+    def __exit__(self, *exc):
+        return False
+
+    def set(self, **args):
+        pass
+
+
+_NULL_SPAN = _NullSpan()
+
+
+class _Span:
+    """Complete event recorded when the span exits"""
+
+    __slots__ = ('tracer', 'name', 'category', 'args', 'started')
+
+    def __init__(self, tracer: 'Tracer', name: str, category: str, args: Dict[str, Any]):
+        self.tracer = tracer
+        self.name = name
+        self.category = category
+        self.args = args
+
+    def __enter__(self):
+        self.started = time.monotonic_ns()
+        return self
+
+    def __exit__(self, exc_type, *exc):
+        ended = time.monotonic_ns()
+        if exc_type is not None:
+            self.args['error'] = exc_type.__name__
+        self.tracer._complete(self.name, self.category, self.started, ended, self.args)
+        return False
+
+    def set(self, **args):
+        """Add arguments to the span, e.g. outcomes only known at its end"""
+        self.args.update(args)
+
+
+class _Timer:
+    """Adds its duration to a per translation unit total"""
+
+    __slots__ = ('totals', 'name', 'started')
+
+    def __init__(self, totals: Dict[str, int], name: str):
+        self.totals = totals
+        self.name = name
+
+    def __enter__(self):
+        self.started = time.monotonic_ns()
+        return self
+
+    def __exit__(self, *exc):
+        self.totals[self.name] = self.totals.get(self.name, 0) + time.monotonic_ns() - self.started
+        return False
+
+
+class Tracer:
+    """Collects trace events of this process and of the workers reporting to it"""
+
+    def __init__(self):
+        self.enabled = False
+        self.events: List[Dict[str, Any]] = []
+        self._origin_ns = 0
+        self._totals: Dict[str, int] = {}
+
+    def enable(self):
+        """Start recording; forked workers inherit the clock origin"""
+        self.enabled = True
+        self._origin_ns = time.monotonic_ns()
+        self.name_process(f"foamcd ({os.getpid()})")
+
+    def span(self, name: str, category: str = 'parse', **args):
+        """Context manager timing a phase
+
+        Args:
+            name: Span name, e.g. the phase
+            category: Trace category, to filter spans in the viewer
+            **args: Arguments shown with the span, e.g. the file
+        """
+        if not self.enabled:
+            return _NULL_SPAN
+        return _Span(self, name, category, args)
+
+    def timed(self, name: str):
+        """Context manager adding its duration to the running total of name, see take_totals"""
+        if not self.enabled:
+            return _NULL_SPAN
+        return _Timer(self._totals, name)
+
+    def take_totals(self) -> Dict[str, float]:
+        """Totals accumulated since the last call, in milliseconds"""
+        totals = {f"{name}_ms": round(ns / 1e6, 3) for name, ns in self._totals.items()}
+        self._totals.clear()
+        return totals
+
+    def name_process(self, name: str):
+        """Label the row of this process in the trace viewer"""
+        if self.enabled:
+            self.events.append({'name': 'process_name', 'ph': 'M', 'pid': os.getpid(), 'tid': os.getpid(),
+                                'args': {'name': name}})
+
+    def _complete(self, name: str, category: str, started: int, ended: int, args: Dict[str, Any]):
+        pid = os.getpid()
+        self.events.append({'name': name, 'cat': category, 'ph': 'X', 'pid': pid, 'tid': pid,
+                            'ts': (started - self._origin_ns) / 1000, 'dur': (ended - started) / 1000,
+                            'args': args})
+
+    def drain(self) -> List[Dict[str, Any]]:
+        """Events recorded so far, removed from the tracer; workers send these to their parent"""
+        events = self.events
+        self.events = []
+        return events
+
+    def extend(self, events: List[Dict[str, Any]]):
+        """Add the events of a worker"""
+        if self.enabled and events:
+            self.events.extend(events)
+
+    def write(self, path: str, metadata: Optional[Dict[str, Any]] = None) -> bool:
+        """Write the recorded events as a Chrome trace JSON file
+
+        Returns:
+            True if the trace was written
+        """
+        try:
+            with open(path, 'w') as f:
+                json.dump({'traceEvents': self.events, 'displayTimeUnit': 'ms',
+                           'otherData': metadata or {}}, f)
+            logger.info(f"Wrote {len(self.events)} trace events to {path}")
+            return True
+        except OSError as e:
+            logger.error(f"Could not write trace to {path}: {e}")
+            return False
+
+
+# Tracer of this process, enabled by the --trace options of the entry points
+tracer = Tracer()
+
+
+def traced(name: Optional[str] = None, category: str = 'parse') -> Callable:
+    """Decorator recording a span for each call of a function, named after it by default"""
+    def decorator(function):
+        span_name = name or function.__name__
+
+        @functools.wraps(function)
+        def wrapper(*args, **kwargs):
+            if not tracer.enabled:
+                return function(*args, **kwargs)
+            with tracer.span(span_name, category):
+                return function(*args, **kwargs)
+        return wrapper
+    return decorator
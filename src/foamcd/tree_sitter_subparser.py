@@ -10,7 +10,7 @@ eg. for macro-heavy unit-testing frameworks
 !!!a bunch of TODO: NOT fully implemented   !!!
 """
 
-from typing import List, Dict, Any
+from typing import List, Dict, Any, Tuple
 
 from .logs import setup_logging
 
@@ -26,9 +26,107 @@ except ImportError:
     logger.warning("Tree-sitter module not found, fallback parsing will not be available")
     TREE_SITTER_AVAILABLE = False
 
+TEST_CASE_MACROS = [
+    "TEST_CASE",
+    "TEMPLATE_TEST_CASE",
+    "SECTION",
+    "SCENARIO",
+    "GIVEN",
+    "WHEN",
+    "THEN"
+]
+
+# Top-level entities: definitions anywhere in the file, Catch2 test cases at file scope.
+# A test case is a macro call parsed as an expression statement followed by its body;
+# TEMPLATE_TEST_CASE often ends up in an ERROR node instead.
+DEFINITIONS_QUERY = f"""
+(class_specifier name: (_) @class.name body: (field_declaration_list)) @class
+(struct_specifier name: (_) @struct.name body: (field_declaration_list)) @struct
+(function_definition
+  declarator: [
+    (function_declarator declarator: (_) @function.name)
+    (_ (function_declarator declarator: (_) @function.name))
+  ]) @function
+(namespace_definition name: (_) @namespace.name) @namespace
+(translation_unit
+  (expression_statement
+    (call_expression
+      function: (identifier) @test.kind
+      arguments: (argument_list) @test.args)) @test.call
+  .
+  (compound_statement) @test.body
+  (#match? @test.kind "^({'|'.join(TEST_CASE_MACROS)})$"))
+(translation_unit
+  (ERROR (identifier) @template_test.kind (#eq? @template_test.kind "TEMPLATE_TEST_CASE")) @template_test)
+"""
+
+# Candidate type references inside a test body
+TYPE_REFERENCES_QUERY = """
+(type_identifier) @type
+(qualified_identifier) @qualified
+(declaration [(type_identifier) (qualified_identifier)] @declared)
+(parameter_declaration [(type_identifier) (qualified_identifier)] @declared)
+(call_expression function: (identifier) @constructed)
+(new_expression type: (type_identifier) @constructed)
+(declaration (identifier) @constructed)
+(parameter_declaration (identifier) @constructed)
+"""
+
+# Uppercase identifiers that are never type references
+NON_TYPE_IDENTIFIERS = {
+    "TEST_CASE", "REQUIRE", "CHECK", "GIVEN", "WHEN", "THEN",
+    "SECTION", "INFO", "WARN", "FAIL"
+}
+
+
+def _compile_query(source: str):
+    """Compile a query against the C++ grammar
+
+    tree-sitter >= 0.24 constructs queries directly; older bindings go through the language.
+    """
+    from tree_sitter import Query
+    try:
+        return Query(CPP_LANGUAGE, source)
+    except TypeError:
+        return CPP_LANGUAGE.query(source)
+
+
+def _query_matches(query, node) -> List[Tuple[int, Dict[str, List[Any]]]]:
+    """Run a compiled query over a node
+
+    tree-sitter >= 0.25 executes queries through a QueryCursor and older bindings
+    may map a capture name to a single node; both are normalized here.
+
+    Returns:
+        List of (pattern index, {capture name: [nodes]}) in document order
+    """
+    try:
+        from tree_sitter import QueryCursor
+        matches = QueryCursor(query).matches(node)
+    except ImportError:
+        matches = query.matches(node)
+    return [
+        (pattern, {name: nodes if isinstance(nodes, list) else [nodes] for name, nodes in captures.items()})
+        for pattern, captures in matches
+    ]
+
+
+def _location(node, end_node=None) -> Dict[str, int]:
+    end_node = end_node or node
+    return {
+        "start_line": node.start_point[0],
+        "start_column": node.start_point[1],
+        "end_line": end_node.end_point[0],
+        "end_column": end_node.end_point[1],
+    }
+
 
 class TreeSitterSubparser:
-    """Tree-sitter based parser for extracting C++ information when libclang fails"""
+    """Tree-sitter based parser for extracting C++ information when libclang fails
+    
+    Extraction runs compiled tree-sitter queries, so tree traversal happens in the
+    native library and Python only consumes the captures.
+    """
     
     def __init__(self):
         """Initialize the Tree-sitter subparser"""
@@ -39,12 +137,14 @@ class TreeSitterSubparser:
             raise ImportError("Tree-sitter C++ language is not available. Fallback parsing is not possible.")
             
         self.parser = Parser(CPP_LANGUAGE)
+        self.definitions_query = _compile_query(DEFINITIONS_QUERY)
+        self.type_references_query = _compile_query(TYPE_REFERENCES_QUERY)
         
     def parse_file(self, filepath: str) -> Dict[str, Any]:
         """Parse a file using Tree-sitter
         
         This method parses a C++ file using the Tree-sitter parser and returns a dict
-        with the extracted information (classes, functions, test cases, etc.)
+        with the extracted information (classes, functions, namespaces, test cases)
         
         Args:
             filepath: Path to the file to parse
@@ -56,48 +156,15 @@ class TreeSitterSubparser:
         result = {
             "classes": [],
             "functions": [],
+            "namespaces": [],
             "test_cases": []
         }
         
         try:
             with open(filepath, 'rb') as f:
                 content = f.read()
-                tree = self.parser.parse(content)
-                root_node = tree.root_node
-                current_index = 0
-                while current_index < len(root_node.children):
-                    if current_index + 1 < len(root_node.children):
-                        expr_stmt = root_node.children[current_index]
-                        next_node = root_node.children[current_index + 1]
-                        if expr_stmt.type == "expression_statement" and next_node.type == "compound_statement":
-                            call_expr = self._find_call_expression(expr_stmt)
-                            if call_expr and self._is_test_case_call(call_expr):
-                                test_case = self._extract_test_case(call_expr, next_node, filepath)
-                                if test_case:
-                                    result["test_cases"].append(test_case)
-                                current_index += 2  # hard-coded assumption of 2 nodes, well...
-                                continue
-                    current_node = root_node.children[current_index]
-                    if current_node.type == "ERROR":
-                        template_test = self._extract_template_test_case_from_error(current_node)
-                        if template_test:
-                            if current_index + 1 < len(root_node.children) and root_node.children[current_index + 1].type == "compound_statement":
-                                compound_stmt = root_node.children[current_index + 1]
-                                template_test["references"] = self._extract_type_references(compound_stmt)
-                                template_test["end_line"] = compound_stmt.end_point[0]
-                                template_test["end_column"] = compound_stmt.end_point[1]
-                                result["test_cases"].append(template_test)
-                                current_index += 2
-                            else:
-                                result["test_cases"].append(template_test)
-                                current_index += 1
-                            continue
-                    current_index += 1  # Move to next node if not a test case pattern
-                for class_node in self._find_nodes_by_type(root_node, "class_specifier"):
-                    class_info = self._extract_class_info(class_node)
-                    if class_info:
-                        result["classes"].append(class_info)
-                        
+            tree = self.parser.parse(content)
+            self._extract_definitions(tree.root_node, result, filepath)
         except Exception as e:
             logger.error(f"Error parsing {filepath} with Tree-sitter: {e}")
             import traceback
@@ -106,188 +173,49 @@ class TreeSitterSubparser:
         logger.info(f"Tree-sitter extracted {len(result['classes'])} classes, {len(result['functions'])} functions, {len(result['test_cases'])} test cases")
         return result
         
-    def _process_node(self, node, result: Dict[str, Any], content: bytes):
-        """Process a tree-sitter node
+    def _extract_definitions(self, root_node, result: Dict[str, Any], filepath: str):
+        """Collect all entities from a single pass over the definitions query matches
         
         Args:
-            node: Tree-sitter node
-            result: Dictionary to store results
-            content: Original file content as bytes
+            root_node: Root node of the parsed file
+            result: Dictionary to store results, keyed by entity category
+            filepath: Path to the file being parsed
         """
-        if node.type == "function_definition":
-            func_info = self._extract_function_info(node, content)
-            if func_info:
-                result["functions"].append(func_info)
-                if self._is_test_case(func_info, content):
-                    result["test_cases"].append(func_info)
-        elif node.type == "class_definition":
-            class_info = self._extract_class_info(node, content)
-            if class_info:
-                result["classes"].append(class_info)
-        elif node.type == "namespace_definition":
-            namespace_info = self._extract_namespace_info(node, content)
-            if namespace_info:
-                result["namespaces"].append(namespace_info)
-                
-        for child in node.children:
-            self._process_node(child, result, content)
+        for _, captures in _query_matches(self.definitions_query, root_node):
+            if "test.call" in captures:
+                call_expr = captures["test.call"][0].named_children[0]
+                test_case = self._extract_test_case(call_expr, captures["test.body"][0], filepath)
+                if test_case:
+                    result["test_cases"].append(test_case)
+            elif "template_test" in captures:
+                template_test = self._extract_template_test_case_from_error(captures["template_test"][0])
+                if template_test:
+                    result["test_cases"].append(template_test)
+            elif "class" in captures or "struct" in captures:
+                kind = "class" if "class" in captures else "struct"
+                result["classes"].append(self._named_info(captures[kind][0], captures[f"{kind}.name"][0], kind))
+            elif "function" in captures:
+                result["functions"].append(self._named_info(captures["function"][0], captures["function.name"][0], "function"))
+            elif "namespace" in captures:
+                result["namespaces"].append(self._named_info(captures["namespace"][0], captures["namespace.name"][0], "namespace"))
+        result["test_cases"].sort(key=lambda test_case: (test_case["start_line"], test_case["start_column"]))
     
-    def _extract_function_info(self, node, content: bytes) -> Dict[str, Any]:
-        """Extract information about a function
-        
-        Args:
-            node: Tree-sitter node for the function
-            content: Original file content as bytes
-            
-        Returns:
-            Dictionary with function information
-        """
-        # TODO: NOT fully implemented... no parameter extraction and what not
-        function_name_node = self._find_child_with_type(node, "function_declarator")
-        if function_name_node:
-            identifier_node = self._find_child_with_type(function_name_node, "identifier")
-            if identifier_node:
-                name = content[identifier_node.start_byte:identifier_node.end_byte].decode('utf-8')
-                return {
-                    "name": name,
-                    "start_line": node.start_point[0],
-                    "start_column": node.start_point[1],
-                    "end_line": node.end_point[0],
-                    "end_column": node.end_point[1],
-                    "kind": "function",
-                }
-        return {}
-        
-    def _extract_class_info(self, node, content: bytes) -> Dict[str, Any]:
-        """Extract information about a class
-        
-        Args:
-            node: Tree-sitter node for the class
-            content: Original file content as bytes
-            
-        Returns:
-            Dictionary with class information
-        """
-        # TODO: NOT fully implemented... no methods extraction
-        identifier_node = self._find_child_with_type(node, "identifier")
-        if identifier_node:
-            name = content[identifier_node.start_byte:identifier_node.end_byte].decode('utf-8')
-            return {
-                "name": name,
-                "start_line": node.start_point[0],
-                "start_column": node.start_point[1],
-                "end_line": node.end_point[0],
-                "end_column": node.end_point[1],
-                "kind": "class",
-            }
-        return {}
+    def _named_info(self, node, name_node, kind: str) -> Dict[str, Any]:
+        """Information about a named definition (class, struct, function or namespace)
         
-    def _extract_namespace_info(self, node, content: bytes) -> Dict[str, Any]:
-        """Extract information about a namespace
+        TODO: NOT fully implemented... no parameters or members extraction
         
         Args:
-            node: Tree-sitter node for the namespace
-            content: Original file content as bytes
+            node: Tree-sitter node of the definition
+            name_node: Node holding the definition's name
+            kind: Kind of the definition
             
         Returns:
-            Dictionary with namespace information
+            Dictionary with the definition information
         """
-        identifier_node = self._find_child_with_type(node, "identifier")
-        if identifier_node:
-            name = content[identifier_node.start_byte:identifier_node.end_byte].decode('utf-8')
-            return {
-                "name": name,
-                "start_line": node.start_point[0],
-                "start_column": node.start_point[1],
-                "end_line": node.end_point[0],
-                "end_column": node.end_point[1],
-                "kind": "namespace",
-            }
-        return {}
-        
-    def _is_test_case(self, func_info: Dict[str, Any], content: bytes) -> bool:
-        """Check if a function is a test case
-        
-        Args:
-            func_info: Function information
-            content: Original file content as bytes
-            
-        Returns:
-            True if the function is a test case, False otherwise
-        """
-        name = func_info.get("name", "")
-        return name.startswith("TEST_CASE") or name.startswith("TEST_") or "TEST_CASE" in name
-        
-    def _find_child_with_type(self, node, type_name: str):
-        """Find a child node with a specific type
-        
-        Args:
-            node: Parent node
-            type_name: Type name to find
-            
-        Returns:
-            Child node with the specified type, or None if not found
-        """
-        for child in node.children:
-            if child.type == type_name:
-                return child
-            found = self._find_child_with_type(child, type_name)
-            if found:
-                return found
-        return None
-        
-    def _find_call_expression(self, expr_stmt):
-        """Find a call_expression within an expression_statement
-        
-        Structure to look for:
-        (expression_statement
-          (call_expression
-            function: (identifier)
-            arguments: (argument_list ...)))
-
-        TODO: Awkward naming of this method
-            
-        Args:
-            expr_stmt: An expression_statement node
-            
-        Returns:
-            The call_expression node if found, None otherwise
-        """
-        for child in expr_stmt.children:
-            if child.type == "call_expression":
-                return child
-        return self._find_node_by_type(expr_stmt, "call_expression")
-    
-    def _is_test_case_call(self, call_expr):
-        """Check if a call_expression is a test case function call
-        
-        Structure to check:
-        (call_expression
-          function: (identifier)  <-- Should be 'TEST_CASE', 'TEMPLATE_TEST_CASE', etc.
-          arguments: (argument_list ...))
-          
-        Args:
-            call_expr: A call_expression node
-            
-        Returns:
-            True if the call is a test case, False otherwise
-        """
-        function_node = None
-        for child in call_expr.children:
-            if child.type == "identifier":
-                function_node = child
-                break
-        if not function_node:
-            return False
-        function_name = function_node.text.decode('utf8')
-        return function_name in [
-            "TEST_CASE", 
-            "TEMPLATE_TEST_CASE",
-            "SECTION",
-            "SCENARIO",
-            "GIVEN",
-            "WHEN",
-            "THEN"]
+        info = {"name": name_node.text.decode('utf8'), "kind": kind}
+        info.update(_location(node))
+        return info
     
     def _extract_test_case(self, call_expr, compound_stmt, filepath):
         """Extract test case information from a call_expression and compound_statement
@@ -301,24 +229,13 @@ class TreeSitterSubparser:
             A dict with test case information or None if extraction fails
         """
         test_case = {
-            "kind": None,
+            "kind": call_expr.child_by_field_name("function").text.decode('utf8'),
             "name": "",
             "tags": "",
-            "start_line": call_expr.start_point[0],
-            "start_column": call_expr.start_point[1],
-            "end_line": compound_stmt.end_point[0],
-            "end_column": compound_stmt.end_point[1],
             "references": []
         }
-        for child in call_expr.children:
-            if child.type == "identifier":
-                test_case["kind"] = child.text.decode('utf8')
-                break
-        args_node = None
-        for child in call_expr.children:
-            if child.type == "argument_list":
-                args_node = child
-                break
+        test_case.update(_location(call_expr, compound_stmt))
+        args_node = call_expr.child_by_field_name("arguments")
                 
         if args_node:
             description_parts = []
@@ -362,176 +279,71 @@ class TreeSitterSubparser:
         """Extract potential type references from a node and its children
         
         Identifies C++ types used in test cases by looking for:
-        1. Template types in template instantiations
+        1. Named type specifiers, including template types and their arguments
         2. Identifiers in type declarations (variable/param declarations)
         3. Qualified names that might be types (e.g., Namespace::Type)
         4. Constructor calls
-        5. Named type specifiers
         
-        Not sure It needs to be this thorough but AI agents wants to be,
-        so why not
-
         Args:
             node: A Tree-sitter node to search within
             
         Returns:
-            List of unique identifier strings that might be type references
+            Sorted list of unique identifier strings that might be type references
         """
         references = set()
-        if node.type in ["string_literal", "comment", "raw_string_literal", "number_literal"]:
-            return list(references)
-
-        # Case 1: Template instantiations
-        if node.type == "template_instantiation":
-            if len(node.children) > 0:
-                template_name = node.children[0].text.decode('utf8')
-                if template_name[0].isupper() or "::" in template_name:
-                    references.add(template_name)
-                for child in node.children:
-                    if child.type == "template_argument_list":
-                        for arg in child.children:
-                            if arg.type == "type_descriptor" or arg.type == "identifier":
-                                arg_text = arg.text.decode('utf8')
-                                if arg_text and (arg_text[0].isupper() or "::" in arg_text):
-                                    references.add(arg_text)
-        
-        # Case 2: Type declarations in variable declarations
-        elif node.type in ["declaration", "parameter_declaration"]:
-            for child in node.children:
-                if child.type in ["type_identifier", "qualified_identifier"]:
-                    type_name = child.text.decode('utf8')
-                    if type_name and (type_name[0].isupper() or "::" in type_name):
-                        references.add(type_name)
-        
-        # Case 3: Qualified identifiers (Namespace::Type)
-        elif node.type == "qualified_identifier":
-            qualified_name = node.text.decode('utf8')
-            if "::" in qualified_name:
-                parts = qualified_name.split("::") 
-                last_part = parts[-1]
-                if last_part and last_part[0].isupper():
-                    references.add(qualified_name)
-        
-        # Case 4: Constructor calls (usually have a new_expression or call_expression parent)
-        elif node.type == "identifier":
-            identifier = node.text.decode('utf8')
-            test_framework_functions = ["TEST_CASE", "REQUIRE", "CHECK", "GIVEN", "WHEN", "THEN", 
-                                      "SECTION", "INFO", "WARN", "FAIL"]
-            cpp_keywords = ["if", "else", "for", "while", "return", "break", "continue", 
-                           "switch", "case", "default", "try", "catch", "throw", "using", 
-                           "namespace", "public", "private", "protected", "friend", "class", 
-                           "struct", "enum", "typedef", "typename", "const", "static", "volatile"]
-            if (identifier and identifier[0].isupper() and 
-                identifier not in test_framework_functions and 
-                identifier not in cpp_keywords):
-                parent = node.parent
-                if parent and parent.type in ["call_expression", "new_expression", "type_identifier"]:
-                    references.add(identifier)
-                elif parent and parent.type in ["declaration", "parameter_declaration"]:
-                    references.add(identifier)
-        
-        # Case 5: Named type specifiers (class/struct/enum names)
-        elif node.type in ["type_identifier", "scoped_type_identifier"]:
-            type_name = node.text.decode('utf8')
-            if type_name and (type_name[0].isupper() or "::" in type_name):
-                references.add(type_name)
-        for child in node.children:
-            child_refs = self._extract_type_references(child)
-            references.update(child_refs)
-        
-        return list(references)
-    
-    def _find_nodes_by_type(self, root_node, node_type):
-        """Find all nodes of a specific type in the tree
-
-        Starting to feel tree-sitter should provide most
-        of this functionality, but they change their API
-        often...
-        
-        Args:
-            root_node: Root node to start searching from
-            node_type: Type of nodes to find
-            
-        Returns:
-            List of nodes matching the type
-        """
-        result = []
-        cursor = root_node.walk()
-        if root_node.type == node_type:
-            result.append(root_node)
-        reached_end = False
-        while not reached_end:
-            if cursor.node.type == node_type:
-                result.append(cursor.node)
-            if cursor.goto_first_child():
-                continue
-            reached_end = not cursor.goto_next_sibling()
-            if reached_end:
-                while not reached_end and not cursor.goto_next_sibling():
-                    reached_end = not cursor.goto_parent()
-                    if reached_end:
-                        break
-                        
-        return result
+        for _, captures in _query_matches(self.type_references_query, node):
+            for capture, nodes in captures.items():
+                for capture_node in nodes:
+                    text = capture_node.text.decode('utf8')
+                    if not text:
+                        continue
+                    if capture in ("type", "declared"):
+                        if text[0].isupper() or "::" in text:
+                            references.add(text)
+                    elif capture == "qualified":
+                        last_part = text.split("::")[-1]
+                        if "::" in text and last_part and last_part[0].isupper():
+                            references.add(text)
+                    elif capture == "constructed":
+                        if text[0].isupper() and text not in NON_TYPE_IDENTIFIERS:
+                            references.add(text)
+        return sorted(references)
     
     def _extract_template_test_case_from_error(self, error_node):
         """Extract TEMPLATE_TEST_CASE information from an ERROR node
         
         Tree-sitter might parse complex template macro calls as ERROR nodes.
-        This method tries to extract test information from such nodes.
+        This method tries to extract test information from such nodes; the test
+        body is the compound statement following the ERROR node, if any.
         
         Args:
             error_node: An ERROR node from the Tree-sitter parse tree
             
         Returns:
-            A dict with test case information if this is a TEMPLATE_TEST_CASE, None otherwise
+            A dict with test case information
         """
-        first_identifier = None
+        test_name = ""
         for child in error_node.children:
-            if child.type == "identifier":
-                first_identifier = child
-                break
-        if first_identifier and first_identifier.text.decode('utf8') == "TEMPLATE_TEST_CASE":
-            test_name = ""
-            for child in error_node.children:
-                if child.type == "string_literal":
-                    for content_node in child.children:
-                        if content_node.type == "string_content":
-                            test_name = content_node.text.decode('utf8')
-                            break
-                    if test_name:
+            if child.type == "string_literal":
+                for content_node in child.children:
+                    if content_node.type == "string_content":
+                        test_name = content_node.text.decode('utf8')
                         break
-            template_test_case = {
-                "kind": "TEMPLATE_TEST_CASE",
-                "name": test_name or "Template Test Case",
-                "start_line": error_node.start_point[0],
-                "start_column": error_node.start_point[1],
-                "end_line": error_node.end_point[0],
-                "end_column": error_node.end_point[1],
-                "references": []  # Will be filled in by caller if compound statement is found
-            }
-            logger.info(f"Found TEMPLATE_TEST_CASE in ERROR node: {test_name}")
-            return template_test_case
-            
-        return None
-    
-    def _find_node_by_type(self, root_node, node_type):
-        """Find the first node of a specific type in the tree
-        
-        Args:
-            root_node: Root node to start searching from
-            node_type: Type of node to find
-            
-        Returns:
-            The first node matching the type, or None if not found
-        """
-        if root_node.type == node_type:
-            return root_node
-        for child in root_node.children:
-            result = self._find_node_by_type(child, node_type)
-            if result:
-                return result
-        return None
+                if test_name:
+                    break
+        template_test_case = {
+            "kind": "TEMPLATE_TEST_CASE",
+            "name": test_name or "Template Test Case",
+            "references": []
+        }
+        template_test_case.update(_location(error_node))
+        body = error_node.next_named_sibling
+        if body is not None and body.type == "compound_statement":
+            template_test_case["references"] = self._extract_type_references(body)
+            template_test_case["end_line"] = body.end_point[0]
+            template_test_case["end_column"] = body.end_point[1]
+        logger.info(f"Found TEMPLATE_TEST_CASE in ERROR node: {test_name}")
+        return template_test_case
         
     def find_test_cases(self, filepath: str) -> List[Dict[str, Any]]:
         """Find all test cases in a unit-test file with Tree-Sitter
@@ -549,21 +361,13 @@ class TreeSitterSubparser:
                 content = f.read()
                 tree = self.parser.parse(content)
             test_cases = []
-            root_node = tree.root_node
-            current_index = 0
-            while current_index < len(root_node.children):
-                if current_index + 1 < len(root_node.children):
-                    expr_stmt = root_node.children[current_index]
-                    next_node = root_node.children[current_index + 1]
-                    if expr_stmt.type == "expression_statement" and next_node.type == "compound_statement":
-                        call_expr = self._find_call_expression(expr_stmt)
-                        if call_expr and self._is_test_case_call(call_expr):
-                            test_case = self._extract_test_case(call_expr, next_node, filepath)
-                            if test_case:
-                                test_cases.append(test_case)
-                            current_index += 2  # Move past both nodes
-                            continue
-                current_index += 1
+            for _, captures in _query_matches(self.definitions_query, tree.root_node):
+                if "test.call" in captures:
+                    call_expr = captures["test.call"][0].named_children[0]
+                    test_case = self._extract_test_case(call_expr, captures["test.body"][0], filepath)
+                    if test_case:
+                        test_cases.append(test_case)
+            test_cases.sort(key=lambda test_case: (test_case["start_line"], test_case["start_column"]))
             logger.info(f"Found {len(test_cases)} test cases in {filepath}")
             return test_cases
         except Exception as e:
@@ -572,6 +376,260 @@ class TreeSitterSubparser:
             logger.error(traceback.format_exc())
             return []
 
+    def extract_skeleton(self, filepath: str) -> List[Dict[str, Any]]:
+        """Extract a low-fidelity entity skeleton of a file
+        
+        Covers namespaces, classes and structs (with their bases), methods, fields,
+        free functions and variables, along with the comments preceding them.
+        Locations follow libclang conventions (1-based lines and columns, extents
+        of the declarations), so entities coincide with those of a later libclang
+        parse wherever both agree on the extent.
+        
+        Args:
+            filepath: Path to the file to parse
+            
+        Returns:
+            List of top-level entity dictionaries with nested "children"
+        """
+        try:
+            with open(filepath, 'rb') as f:
+                content = f.read()
+            tree = self.parser.parse(content)
+            entities = []
+            self._skeleton_scope(tree.root_node.children, entities, {"namespace": [], "class": None})
+            return entities
+        except Exception as e:
+            logger.error(f"Error extracting skeleton of {filepath} with Tree-sitter: {e}")
+            return []
+    
+    def _skeleton_scope(self, nodes, entities: List[Dict[str, Any]], scope: Dict[str, Any]):
+        """Add skeleton entities for the declarations among nodes
+        
+        Args:
+            nodes: Child nodes of a translation unit, namespace body or class body
+            entities: List receiving the entities
+            scope: Enclosing namespaces, enclosing class (name, kind) and current access
+        """
+        for node in nodes:
+            if not node.is_named or node.type == "comment":
+                continue
+            if node.type in ("preproc_ifdef", "preproc_if", "preproc_else", "preproc_elif"):
+                self._skeleton_scope(node.children, entities, scope)
+            elif node.type == "linkage_specification":
+                body = node.child_by_field_name("body")
+                if body is not None:
+                    self._skeleton_scope(body.children if body.type == "declaration_list" else [body], entities, scope)
+            elif node.type == "access_specifier":
+                scope["access"] = node.text.decode('utf8').strip().upper()
+            elif node.type == "namespace_definition":
+                self._skeleton_namespace(node, entities, scope)
+            elif node.type == "template_declaration":
+                inner = [child for child in node.named_children
+                         if child.type not in ("template_parameter_list", "comment")]
+                if inner:
+                    self._skeleton_declaration(inner[-1], entities, scope, template=node)
+            else:
+                self._skeleton_declaration(node, entities, scope)
+    
+    def _skeleton_namespace(self, node, entities: List[Dict[str, Any]], scope: Dict[str, Any]):
+        name_node = node.child_by_field_name("name")
+        # namespace a::b { } declares one namespace per component
+        names = name_node.text.decode('utf8').replace(" ", "").split("::") if name_node else [""]
+        body = node.child_by_field_name("body")
+        target = entities
+        inner_scope = {"namespace": list(scope["namespace"]), "class": None}
+        for name in names:
+            namespace = self._skeleton_entity("NAMESPACE", name, node, node, inner_scope)
+            target.append(namespace)
+            target = namespace["children"]
+            if name:
+                inner_scope["namespace"].append(name)
+        if body is not None:
+            self._skeleton_scope(body.children, target, inner_scope)
+    
+    def _skeleton_declaration(self, node, entities: List[Dict[str, Any]], scope: Dict[str, Any], template=None):
+        """Add skeleton entities for a class, function, method, field or variable declaration"""
+        start_node = template or node
+        if node.type in ("class_specifier", "struct_specifier"):
+            self._skeleton_class(node, start_node, entities, scope, template is not None)
+            return
+        if node.type == "function_definition":
+            self._skeleton_function(node, node.child_by_field_name("declarator"), start_node, node,
+                                    entities, scope, template is not None)
+            return
+        if node.type not in ("declaration", "field_declaration"):
+            return
+        type_node = node.child_by_field_name("type")
+        if type_node is not None and type_node.type in ("class_specifier", "struct_specifier"):
+            self._skeleton_class(type_node, start_node, entities, scope, template is not None)
+        is_static = any(child.type == "storage_class_specifier" and child.text == b"static"
+                        for child in node.children)
+        declarators = node.children_by_field_name("declarator")
+        for declarator in declarators:
+            # Extent of a declaration ends with its last declarator or initializer
+            end_node = declarator
+            default_value = node.child_by_field_name("default_value")
+            if default_value is not None and declarator == declarators[-1]:
+                end_node = default_value
+            function_declarator = self._find_declarator(declarator, "function_declarator")
+            if function_declarator is not None:
+                self._skeleton_function(node, declarator, start_node, end_node, entities, scope,
+                                        template is not None)
+                continue
+            name_node = self._declarator_name(declarator)
+            if name_node is None or (scope["class"] is None and node.type == "field_declaration"):
+                continue
+            kind = "FIELD_DECL" if scope["class"] is not None and not is_static else "VAR_DECL"
+            entity = self._skeleton_entity(kind, name_node.text.decode('utf8'), start_node, end_node, scope)
+            entity["is_static"] = is_static
+            if type_node is not None:
+                entity["type_info"] = type_node.text.decode('utf8')
+            entities.append(entity)
+    
+    def _skeleton_class(self, node, start_node, entities: List[Dict[str, Any]], scope: Dict[str, Any],
+                        is_template: bool):
+        name_node = node.child_by_field_name("name")
+        body = node.child_by_field_name("body")
+        if name_node is None or body is None:
+            return
+        class_kind = "class" if node.type == "class_specifier" else "struct"
+        name = name_node.text.decode('utf8')
+        if is_template:
+            kind = "CLASS_TEMPLATE"
+        else:
+            kind = "CLASS_DECL" if class_kind == "class" else "STRUCT_DECL"
+        entity = self._skeleton_entity(kind, name, start_node, node, scope)
+        # Nested classes are renamed after their enclosing class once their UUID is set
+        entity["enclosed"] = scope["class"] is not None
+        default_access = "PRIVATE" if class_kind == "class" else "PUBLIC"
+        for clause in node.named_children:
+            if clause.type == "base_class_clause":
+                entity["bases"] = self._skeleton_bases(clause, default_access)
+            elif clause.type == "virtual_specifier" and clause.text == b"final":
+                entity["is_final"] = True
+        class_scope = {
+            "namespace": scope["namespace"],
+            "class": (name_node.text.decode('utf8'), class_kind),
+            "access": default_access
+        }
+        self._skeleton_scope(body.children, entity["children"], class_scope)
+        entity["is_abstract"] = any(child.get("is_pure_virtual") for child in entity["children"])
+        entities.append(entity)
+    
+    def _skeleton_bases(self, clause, default_access: str) -> List[Dict[str, Any]]:
+        bases = []
+        access = None
+        virtual = False
+        for child in clause.children:
+            if child.type == "access_specifier":
+                access = child.text.decode('utf8').upper()
+            elif child.type in ("virtual", "virtual_function_specifier"):
+                virtual = True
+            elif child.type == ",":
+                access, virtual = None, False
+            elif child.is_named and child.type != "comment":
+                bases.append({"name": child.text.decode('utf8'), "access": access or default_access,
+                              "virtual": virtual})
+        return bases
+    
+    def _skeleton_function(self, node, declarator, start_node, end_node, entities: List[Dict[str, Any]],
+                           scope: Dict[str, Any], is_template: bool):
+        function_declarator = self._find_declarator(declarator, "function_declarator")
+        if function_declarator is None:
+            return
+        name_node = function_declarator.child_by_field_name("declarator")
+        if name_node is None or name_node.type in ("qualified_identifier", "template_function"):
+            # Out-of-line member definitions are documented with their class
+            return
+        name = name_node.text.decode('utf8')
+        if name_node.type == "operator_name":
+            operator = name[len("operator"):].strip()
+            name = "operator" + (operator if not operator[:1].isalpha() else " " + operator)
+        elif name_node.type == "destructor_name":
+            name = name.replace(" ", "")
+        class_name = scope["class"][0] if scope["class"] is not None else None
+        if is_template:
+            kind = "FUNCTION_TEMPLATE"
+        elif class_name is None:
+            kind = "FUNCTION_DECL"
+        elif name == class_name:
+            kind = "CONSTRUCTOR"
+        elif name.startswith("~"):
+            kind = "DESTRUCTOR"
+        else:
+            kind = "CXX_METHOD"
+        entity = self._skeleton_entity(kind, name, start_node, end_node, scope)
+        specifiers = [child.text.decode('utf8') for child in function_declarator.children
+                      if child.type == "virtual_specifier"]
+        default_value = node.child_by_field_name("default_value")
+        body = node.child_by_field_name("body")
+        entity.update({
+            "is_virtual": any(child.type in ("virtual", "virtual_function_specifier") for child in node.children),
+            "is_static": any(child.type == "storage_class_specifier" and child.text == b"static"
+                             for child in node.children),
+            "is_pure_virtual": default_value is not None and default_value.text == b"0",
+            "is_override": "override" in specifiers,
+            "is_final": "final" in specifiers,
+            "is_defaulted": body is not None and body.type == "default_method_clause",
+            "is_deleted": body is not None and body.type == "delete_method_clause",
+        })
+        entity["full_signature"] = " ".join(
+            node.text[:function_declarator.end_byte - node.start_byte].decode('utf8').split())
+        entities.append(entity)
+    
+    def _skeleton_entity(self, kind: str, name: str, start_node, end_node, scope: Dict[str, Any]) -> Dict[str, Any]:
+        entity = {
+            "kind": kind,
+            "name": name,
+            "namespace": "::".join(scope["namespace"]) or None,
+            "access": scope.get("access") if scope.get("class") is not None else None,
+            "line": start_node.start_point[0] + 1,
+            "column": start_node.start_point[1] + 1,
+            "end_line": end_node.end_point[0] + 1,
+            "end_column": end_node.end_point[1] + 1,
+            "doc_comment": self._preceding_comment(start_node),
+            "children": []
+        }
+        return entity
+    
+    def _preceding_comment(self, node) -> str:
+        """Raw text of the comments directly above a node, without blank lines in between"""
+        comments = []
+        expected_line = node.start_point[0]
+        sibling = node.prev_sibling
+        while sibling is not None and sibling.type == "comment" and sibling.end_point[0] >= expected_line - 1:
+            comments.insert(0, sibling.text.decode('utf8', errors='replace'))
+            expected_line = sibling.start_point[0]
+            sibling = sibling.prev_sibling
+        return "\n".join(comments)
+    
+    def _find_declarator(self, declarator, declarator_type: str):
+        """Find a declarator of a given type through pointer, reference and init declarators"""
+        while declarator is not None:
+            if declarator.type == declarator_type:
+                return declarator
+            if declarator.type not in ("pointer_declarator", "reference_declarator", "init_declarator",
+                                       "array_declarator", "attributed_declarator", "parenthesized_declarator"):
+                return None
+            inner = declarator.child_by_field_name("declarator")
+            if inner is None:
+                inner = next((child for child in declarator.named_children
+                              if child.type.endswith("declarator")), None)
+            declarator = inner
+        return None
+    
+    def _declarator_name(self, declarator):
+        """Identifier node declared by a (possibly nested) variable or field declarator"""
+        while declarator is not None:
+            if declarator.type in ("identifier", "field_identifier"):
+                return declarator
+            inner = declarator.child_by_field_name("declarator")
+            if inner is None:
+                inner = next((child for child in declarator.named_children
+                              if child.type in ("identifier", "field_identifier") or child.type.endswith("declarator")), None)
+            declarator = inner
+        return None
+
 
 def is_tree_sitter_available() -> bool:
     """Check if Tree-sitter is available
@@ -582,6 +640,22 @@ def is_tree_sitter_available() -> bool:
     return TREE_SITTER_AVAILABLE
 
 
+# Subparser of a skeleton worker process
+_SKELETON_SUBPARSER = None
+
+
+def extract_skeleton_file(filepath: str) -> Tuple[str, List[Dict[str, Any]]]:
+    """Extract the entity skeleton of a file, for use in worker processes
+    
+    Returns:
+        Tuple of (filepath, list of skeleton entity dictionaries)
+    """
+    global _SKELETON_SUBPARSER
+    if _SKELETON_SUBPARSER is None:
+        _SKELETON_SUBPARSER = TreeSitterSubparser()
+    return filepath, _SKELETON_SUBPARSER.extract_skeleton(filepath)
+
+
 if __name__ == "__main__":
     if TREE_SITTER_AVAILABLE:
         parser = TreeSitterSubparser()
@@ -0,0 +1,368 @@
+#!/usr/bin/env python3
+
+"""
+Watch mode: reparse what an edit affects and regenerate only its pages
+
+A watch session keeps one ClangParser (and its libclang index), the database
+connection and a MarkdownGenerator alive, and watches the directories of the
+translation units and of the project headers they were recorded to include
+(tu_includes). When files change:
+
+  - the translation units affected are the changed ones, and those including
+    a changed header according to the include sets of the last parse;
+  - the entities of changed headers are cleared, the affected translation
+    units are reparsed regardless of their own hash, and the resolution
+    passes run over the database;
+  - the classes declared in the changed files are compared, by a digest of
+    their stored data, before and after; pages are regenerated for those which
+    changed, and for every class deriving from them;
+  - index pages are only regenerated when classes appeared or disappeared.
+
+The database and pages are expected to come from a full foamcd-parse and
+foamcd-markdown run; watching starts from there. Changes are picked up with
+inotify on Linux, by polling modification times elsewhere.
+"""
+
+import os
+import sys
+import json
+import time
+import ctypes
+import ctypes.util
+import select
+import struct
+import hashlib
+import argparse
+from typing import Any, Dict, List, Optional, Set
+
+from .logs import setup_logging
+from .config import Config
+from .version import get_version
+from .db import EntityDatabase
+from .common import CPP_HEADER_EXTENSIONS, CPP_IMPLEM_EXTENSIONS
+
+logger = setup_logging()
+
+# Files whose changes are picked up; editors' swap and backup files are not
+SOURCE_EXTENSIONS = tuple(CPP_HEADER_EXTENSIONS + CPP_IMPLEM_EXTENSIONS)
+
+_IN_CLOSE_WRITE = 0x00000008
+_IN_MOVED_FROM = 0x00000040
+_IN_MOVED_TO = 0x00000080
+_IN_DELETE = 0x00000200
+_IN_Q_OVERFLOW = 0x00004000
+_IN_NONBLOCK = 0o4000
+_IN_CLOEXEC = 0o2000000
+# Saves, including editors writing a new file and renaming it over the old one, and deletions
+_WATCH_MASK = _IN_CLOSE_WRITE | _IN_MOVED_TO | _IN_MOVED_FROM | _IN_DELETE
+_EVENT_HEADER = struct.Struct('iIII')
+
+
+class InotifyWatcher:
+    """Files changed in a set of directories, through Linux inotify"""
+
+    def __init__(self):
+        libc = ctypes.CDLL(ctypes.util.find_library('c') or 'libc.so.6', use_errno=True)
+        self._add_watch = libc.inotify_add_watch
+        self._add_watch.argtypes = [ctypes.c_int, ctypes.c_char_p, ctypes.c_uint32]
+        self.fd = libc.inotify_init1(_IN_NONBLOCK | _IN_CLOEXEC)
+        if self.fd < 0:
+            raise OSError(ctypes.get_errno(), "inotify_init1 failed")
+        self.directories: Dict[int, str] = {}
+
+    def add(self, directory: str):
+        """Watch the files directly in a directory"""
+        if directory in self.directories.values():
+            return
+        wd = self._add_watch(self.fd, os.fsencode(directory), _WATCH_MASK)
+        if wd < 0:
+            logger.warning(f"Cannot watch {directory}: {os.strerror(ctypes.get_errno())}")
+            return
+        self.directories[wd] = directory
+
+    def read(self, timeout: Optional[float]) -> Set[str]:
+        """Paths changed, waiting up to timeout seconds for the first change"""
+        readable, _, _ = select.select([self.fd], [], [], timeout)
+        if not readable:
+            return set()
+        try:
+            data = os.read(self.fd, 64 * 1024)
+        except BlockingIOError:
+            return set()
+        changed = set()
+        offset = 0
+        while offset + _EVENT_HEADER.size <= len(data):
+            wd, mask, _, length = _EVENT_HEADER.unpack_from(data, offset)
+            name = data[offset + _EVENT_HEADER.size:offset + _EVENT_HEADER.size + length].rstrip(b'\0')
+            offset += _EVENT_HEADER.size + length
+            if mask & _IN_Q_OVERFLOW:
+                logger.warning("Too many changes at once, some were missed; run foamcd-parse to catch up")
+            elif wd in self.directories and name:
+                changed.add(os.path.join(self.directories[wd], os.fsdecode(name)))
+        return changed
+
+    def close(self):
+        os.close(self.fd)
+
+
+class PollingWatcher:
+    """Files changed in a set of directories, by comparing modification times"""
+
+    def __init__(self, interval: float = 1.0):
+        self.interval = interval
+        self.directories: List[str] = []
+        self._stamps: Dict[str, tuple] = {}
+
+    def add(self, directory: str):
+        """Watch the files directly in a directory"""
+        if directory not in self.directories:
+            self.directories.append(directory)
+            self._stamps.update(self._scan([directory]))
+
+    def _scan(self, directories: List[str]) -> Dict[str, tuple]:
+        stamps = {}
+        for directory in directories:
+            try:
+                with os.scandir(directory) as entries:
+                    for entry in entries:
+                        if entry.name.endswith(SOURCE_EXTENSIONS) and entry.is_file():
+                            stat = entry.stat()
+                            stamps[entry.path] = (stat.st_mtime_ns, stat.st_size)
+            except OSError:
+                pass
+        return stamps
+
+    def read(self, timeout: Optional[float]) -> Set[str]:
+        """Paths changed since the last call, after waiting up to timeout seconds"""
+        time.sleep(self.interval if timeout is None else min(timeout, self.interval))
+        stamps = self._scan(self.directories)
+        changed = {path for path in stamps.keys() | self._stamps.keys() if stamps.get(path) != self._stamps.get(path)}
+        self._stamps = stamps
+        return changed
+
+    def close(self):
+        pass
+
+
+def make_watcher(poll: bool = False, poll_interval: float = 1.0):
+    """inotify watcher where available, a polling one otherwise or if asked for"""
+    if not poll and sys.platform.startswith('linux'):
+        try:
+            return InotifyWatcher()
+        except (OSError, AttributeError) as e:
+            logger.warning(f"inotify is not available ({e}), polling for changes instead")
+    return PollingWatcher(poll_interval)
+
+
+def wait_for_changes(watcher, debounce: float) -> Set[str]:
+    """Block until source files change, then until no more change for debounce seconds
+
+    Returns:
+        Real paths of the changed source files
+    """
+    changed: Set[str] = set()
+    while not changed:
+        changed = {path for path in watcher.read(1.0) if path.endswith(SOURCE_EXTENSIONS)}
+    while True:
+        more = {path for path in watcher.read(debounce) if path.endswith(SOURCE_EXTENSIONS)}
+        if not more:
+            return {os.path.realpath(path) for path in changed}
+        changed |= more
+
+
+class WatchSession:
+    """Warm parser, database and generator, updating the docs of what changes"""
+
+    def __init__(self, config: Config, db_path: str, output_path: str, project_dir: Optional[str] = None,
+                 compile_commands_dir: Optional[str] = None):
+        """
+        Args:
+            config: Configuration, as for foamcd-parse and foamcd-markdown
+            db_path: Database of a previous full parse
+            output_path: Directory of the generated markdown pages
+            project_dir: Directory of the project's classes, as foamcd-markdown --project
+            compile_commands_dir: Directory of compile_commands.json
+        """
+        from .parse import ClangParser, get_source_files_from_compilation_database
+        from .markdown import MarkdownGenerator
+
+        self.config = config
+        self.db = EntityDatabase(db_path)
+        self.parser = ClangParser(compile_commands_dir, db=self.db, config=config)
+        self.generator = MarkdownGenerator(db_path, output_path, project_dir, config_object=config)
+        files = list(config.get('parser.target_files', []) or [])
+        if compile_commands_dir and not files:
+            files = get_source_files_from_compilation_database(compile_commands_dir)
+        # Real path -> path as given to the parser
+        self.translation_units = {os.path.realpath(path): path for path in files if os.path.exists(path)}
+
+    def watched_directories(self) -> List[str]:
+        """Directories of the translation units and of the project headers they include"""
+        directories = {os.path.dirname(path) for path in self.translation_units}
+        for path, record in self.db.get_tu_history().items():
+            if path in self.translation_units:
+                directories.update(os.path.dirname(include) for include in record['includes'])
+        return sorted(directory for directory in directories if os.path.isdir(directory))
+
+    def affected_translation_units(self, changed: Set[str]) -> List[str]:
+        """Real paths of the translation units which are, or include, one of the changed files"""
+        affected = {path for path in changed if path in self.translation_units}
+        for path, record in self.db.get_tu_history().items():
+            if path in self.translation_units and record['includes'] & changed:
+                affected.add(path)
+        return sorted(affected)
+
+    def _snapshot(self, files: Set[str]) -> Dict[str, Dict[str, Any]]:
+        """Digest of the stored data of the classes declared in the files
+
+        UUIDs depend on source locations, which edits shift, so classes are keyed by qualified
+        name, kind and file instead; declarations sharing a key are digested together.
+        """
+        from .markdown import PAGE_ENTITY_KINDS
+
+        snapshot: Dict[str, Dict[str, Any]] = {}
+        for uuid in self.db.get_entity_uuids_in_files(sorted(files), PAGE_ENTITY_KINDS):
+            entity = self.db.get_entity_by_uuid(uuid, include_children=True)
+            if not entity:
+                continue
+            namespace = self.db._get_namespace_path(entity['parent_uuid']) if entity.get('parent_uuid') else ''
+            key = f"{namespace}::{entity['name']} {entity['kind']} {entity.get('file')}"
+            record = snapshot.setdefault(key, {'uuids': [], 'entities': []})
+            record['uuids'].append(uuid)
+            record['entities'].append(json.dumps(entity, sort_keys=True, default=str))
+        for record in snapshot.values():
+            record['digest'] = hashlib.sha256("\n".join(sorted(record.pop('entities'))).encode()).hexdigest()
+        return snapshot
+
+    def update(self, changed: Set[str]) -> Optional[Dict[str, Any]]:
+        """Reparse what the changed files affect and regenerate the pages which changed
+
+        Args:
+            changed: Real paths of the changed files
+
+        Returns:
+            Counts of reparsed translation units, changed classes and regenerated pages and the
+            time taken, or None if no translation unit is affected
+        """
+        started = time.monotonic()
+        units = self.affected_translation_units(changed)
+        if not units:
+            logger.debug(f"No translation unit affected by {', '.join(sorted(changed))}")
+            return None
+        files = set(changed) | set(units) | {self.translation_units[path] for path in units}
+        before = self._snapshot(files)
+        # Derived classes are found before their links to removed or moved bases are gone
+        derived_before = {key: set(self.db.get_derived_class_uuids(value['uuids'])) for key, value in before.items()}
+
+        for path in changed - set(units):
+            self.db.clear_file_entities(path)
+        for path in units:
+            filepath = self.translation_units[path]
+            if not os.path.exists(filepath):
+                logger.info(f"{filepath} was removed")
+                self.db.clear_file_entities(filepath)
+                del self.translation_units[path]
+                continue
+            # Its own hash may be unchanged when only a header it includes changed
+            self.db.untrack_file(filepath)
+            self.parser.parse_file(filepath)
+        self.parser.entities.clear()
+        self.parser.resolve_scoped_template_functions()
+        self.parser.resolve_inheritance_relationships()
+        self.parser.resolve_enclosing_relationships()
+
+        after = self._snapshot(files)
+        changed_classes = {key for key in before.keys() | after.keys()
+                           if before.get(key, {}).get('digest') != after.get(key, {}).get('digest')}
+        pages = {uuid for key in changed_classes if key in after for uuid in after[key]['uuids']}
+        # Bases may be linked to another declaration of the same class, e.g. the one in its source file
+        changed_names = {key.split(' ')[0] for key in changed_classes}
+        same_names = {key for key in before.keys() | after.keys() if key.split(' ')[0] in changed_names}
+        declarations = {uuid for key in same_names for uuid in after.get(key, {}).get('uuids', [])}
+        pages.update(self.db.get_derived_class_uuids(sorted(pages | declarations)))
+        for key in same_names:
+            pages.update(derived_before.get(key, ()))
+
+        removed = before.keys() - after.keys()
+        if before.keys() != after.keys():
+            self.generator.generate_indexes()
+        regenerated = 0
+        if pages or removed:
+            self.generator.generate_entity_pages(only_uuids=pages, remove_stale=bool(removed))
+            regenerated = self.generator.page_counts['generated']
+        elapsed = time.monotonic() - started
+        logger.info(f"Reparsed {len(units)} translation units, {len(changed_classes)} classes changed, "
+                    f"regenerated {regenerated} pages in {elapsed:.2f}s")
+        return {'translation_units': len(units), 'changed_classes': len(changed_classes),
+                'pages': regenerated, 'seconds': elapsed}
+
+    def run(self, watcher, debounce: float = 0.2):
+        """Update the docs on every change until interrupted"""
+        for directory in self.watched_directories():
+            watcher.add(directory)
+        logger.info(f"Watching {len(watcher.directories)} directories for changes to "
+                    f"{len(self.translation_units)} translation units and their headers")
+        try:
+            while True:
+                changed = wait_for_changes(watcher, debounce)
+                logger.info(f"Changed: {', '.join(sorted(os.path.basename(path) for path in changed))}")
+                try:
+                    self.update(changed)
+                except Exception as e:
+                    import traceback
+                    logger.error(f"Error updating docs after changes: {e}\nTraceback: {traceback.format_exc()}")
+                # Headers included for the first time
+                for directory in self.watched_directories():
+                    watcher.add(directory)
+        except KeyboardInterrupt:
+            logger.info("Stopped watching")
+        finally:
+            watcher.close()
+            self.close()
+
+    def close(self):
+        if not self.parser.disable_plugins:
+            self.parser.plugin_manager.shutdown()
+        self.generator.db.close()
+        self.db.close()
+
+
+def main():
+    """Main entry point for watching a parsed project"""
+    parser = argparse.ArgumentParser(description="Keep foamCD docs up to date while editing sources")
+    parser.add_argument("--config", "-c", type=str, help="Path to YAML configuration file")
+    parser.add_argument("--db", dest="db_path", type=str,
+                        help="Database of a full foamcd-parse run, database.path of the config by default")
+    parser.add_argument("--output", dest="output_path", type=str,
+                        help="Markdown output of foamcd-markdown, markdown.output_path of the config by default")
+    parser.add_argument("--project", dest="project_dir", type=str, help="Project directory to filter entities by")
+    parser.add_argument("--compile-commands-dir", type=str, help="Directory containing compile_commands.json")
+    parser.add_argument("--poll", action="store_true", help="Poll modification times instead of using inotify")
+    parser.add_argument("--verbose", "-v", action="store_true", help="Enable verbose output")
+    parser.add_argument("--version", action="store_true", help="Show version information and exit")
+    args = parser.parse_args()
+
+    if args.version:
+        print(f"foamCD {get_version()}")
+        return 0
+
+    setup_logging(args.verbose)
+    config = Config(args.config)
+    db_path = args.db_path or config.get('database.path', 'docs.db')
+    if not os.path.exists(db_path):
+        logger.error(f"No database at {db_path}; run foamcd-parse and foamcd-markdown once before watching")
+        return 1
+    session = WatchSession(config, db_path, args.output_path or config.get('markdown.output_path'),
+                           args.project_dir, args.compile_commands_dir or config.get('parser.compile_commands_dir'))
+    if not session.translation_units:
+        logger.error("No translation units to watch; set parser.compile_commands_dir or parser.target_files")
+        session.close()
+        return 1
+    watcher = make_watcher(args.poll or not config.get('watch.inotify', True),
+                           float(config.get('watch.poll_interval', 1.0)))
+    session.run(watcher, int(config.get('watch.debounce_ms', 200)) / 1000)
+    return 0
+
+
+if __name__ == '__main__':
+    sys.exit(main() or 0)
@@ -0,0 +1,87 @@
+#!/usr/bin/env python3
+
+import unittest
+import sys
+import os
+import json
+import shutil
+import tempfile
+from pathlib import Path
+sys.path.append(str(Path(__file__).parent.parent.parent / "src"))
+sys.path.append(str(Path(__file__).parent.parent.parent))
+from foamcd.logs import setup_logging
+
+logger = setup_logging(verbose=True).getChild('test.benchmarks')
+
+from foamcd.parse import LIBCLANG_CONFIGURED
+from benchmarks.corpus import CorpusSpec, generate_corpus
+from benchmarks.harness import run_scale
+
+
+class TestCorpusGenerator(unittest.TestCase):
+    """Test cases for synthetic corpus generation"""
+
+    def setUp(self):
+        self.temp_dir = tempfile.mkdtemp()
+
+    def tearDown(self):
+        shutil.rmtree(self.temp_dir)
+
+    def _read_all(self, root):
+        contents = {}
+        for directory, _, names in os.walk(root):
+            for name in names:
+                path = os.path.join(directory, name)
+                with open(path) as f:
+                    contents[os.path.relpath(path, root)] = f.read()
+        return contents
+
+    def test_shape(self):
+        """Hierarchies follow depth and fan-out, with one compile command per class"""
+        spec = CorpusSpec(files=20, depth=3, fan_out=2, rts_ratio=1.0, template_ratio=0.0)
+        corpus = generate_corpus(spec, os.path.join(self.temp_dir, "corpus"))
+        # Trees of 1 + 2 + 4 classes
+        self.assertEqual((corpus['classes'], corpus['hierarchies'], corpus['derived']), (20, 3, 17))
+        with open(os.path.join(corpus['root'], "compile_commands.json")) as f:
+            commands = json.load(f)
+        self.assertEqual(sorted(command['file'] for command in commands), sorted(corpus['sources']))
+        self.assertTrue(all(os.path.exists(path) for path in corpus['sources']))
+        with open(os.path.join(corpus['root'], "include", "model1.H")) as f:
+            header = f.read()
+        self.assertIn("class model1 : public base0Model", header)
+        self.assertIn('TypeName("model1")', header)
+
+    def test_deterministic(self):
+        """The same spec gives the same files"""
+        spec = CorpusSpec(files=15, template_ratio=0.3, seed=4)
+        first = generate_corpus(spec, os.path.join(self.temp_dir, "first"))
+        second = generate_corpus(spec, os.path.join(self.temp_dir, "second"))
+        first_files = self._read_all(first['root'])
+        second_files = self._read_all(second['root'])
+        first_files.pop("compile_commands.json")
+        second_files.pop("compile_commands.json")
+        self.assertEqual(first_files, second_files)
+
+
+@unittest.skipIf(not LIBCLANG_CONFIGURED, "libclang is not configured")
+class TestHarness(unittest.TestCase):
+    """Test cases for the benchmark harness"""
+
+    def setUp(self):
+        self.temp_dir = tempfile.mkdtemp()
+
+    def tearDown(self):
+        shutil.rmtree(self.temp_dir)
+
+    def test_run_scale(self):
+        """A scale is parsed without errors and its measurements reported"""
+        spec = CorpusSpec(files=6, depth=2, fan_out=2, template_ratio=0.5, seed=1)
+        result = run_scale('test', spec, self.temp_dir, plugins=False, markdown=False)
+        self.assertEqual((result['parse']['parsed'], result['parse']['errors']), (6, 0))
+        self.assertEqual(result['database']['inheritance'], result['corpus']['derived'])
+        self.assertGreater(result['database']['bytes'], 0)
+        json.dumps(result)
+
+
+if __name__ == '__main__':
+    unittest.main()
@@ -0,0 +1,83 @@
+#!/usr/bin/env python3
+
+import unittest
+import sys
+import os
+import json
+import shutil
+import tempfile
+from pathlib import Path
+sys.path.append(str(Path(__file__).parent.parent.parent / "src"))
+from foamcd.logs import setup_logging
+
+logger = setup_logging(verbose=True).getChild('test.compile_commands')
+
+from omegaconf import OmegaConf
+from foamcd.config import Config
+from foamcd.parse import ClangParser, get_source_files_from_compilation_database, LIBCLANG_CONFIGURED
+
+
+@unittest.skipIf(not LIBCLANG_CONFIGURED, "libclang is not configured")
+class TestCompileCommandSelection(unittest.TestCase):
+    """Test cases for files with several compile commands"""
+
+    def setUp(self):
+        self.temp_dir = os.path.realpath(tempfile.mkdtemp())
+        self.source = os.path.join(self.temp_dir, "field.C")
+        with open(self.source, 'w') as f:
+            f.write("int f();\n")
+        variants = [
+            ['-DWM_SP', '-DWM_LABEL_SIZE=32', '-c', '-o', 'sp/field.o'],
+            ['-DWM_DP', '-DWM_LABEL_SIZE=32', '-c', '-o', 'dp/field.o'],
+            # Same configuration as the first one, from another library
+            ['-DWM_SP', '-DWM_LABEL_SIZE=32', '-c', '-o', 'lib2/field.o', '-MMD', '-MF', 'lib2/field.d'],
+            ['-DWM_DP', '-DWM_LABEL_SIZE=64', '-DFULLDEBUG', '-c', '-o', 'dp64/field.o'],
+        ]
+        commands = [{'directory': self.temp_dir, 'file': path,
+                     'arguments': ['g++', '-std=c++17', *variant, path]}
+                    for variant, path in zip(variants, [self.source, "field.C", "./field.C", self.source])]
+        with open(os.path.join(self.temp_dir, "compile_commands.json"), 'w') as f:
+            json.dump(commands, f)
+
+    def tearDown(self):
+        shutil.rmtree(self.temp_dir)
+
+    def _args(self, select='first', prefer=()):
+        config = Config()
+        OmegaConf.update(config.config, "parser.include_paths", [])
+        OmegaConf.update(config.config, "parser.compile_commands.select", select)
+        OmegaConf.update(config.config, "parser.compile_commands.prefer", list(prefer))
+        parser = ClangParser(self.temp_dir, config=config, disable_plugins=True, use_tree_sitter_fallback=False)
+        return parser, parser.get_compile_commands(self.source)
+
+    def _defines(self, args):
+        return [arg for arg in args if arg.startswith('-D')]
+
+    def test_one_configuration(self):
+        """Arguments of one command are used, never those of several merged"""
+        _, args = self._args()
+        self.assertEqual(self._defines(args), ['-DWM_SP', '-DWM_LABEL_SIZE=32'])
+        self.assertEqual(args.count('-std=c++17'), 1)
+
+    def test_policies(self):
+        """select and prefer pick the configuration"""
+        self.assertEqual(self._defines(self._args('last')[1]), ['-DWM_DP', '-DWM_LABEL_SIZE=64', '-DFULLDEBUG'])
+        self.assertEqual(self._defines(self._args('most_flags')[1]), ['-DWM_DP', '-DWM_LABEL_SIZE=64', '-DFULLDEBUG'])
+        self.assertEqual(self._defines(self._args('first', ['-DWM_DP'])[1]), ['-DWM_DP', '-DWM_LABEL_SIZE=32'])
+        self.assertEqual(self._defines(self._args('first', ['-DWM_DP', '-DFULLDEBUG'])[1]),
+                         ['-DWM_DP', '-DWM_LABEL_SIZE=64', '-DFULLDEBUG'])
+
+    def test_cached_copies(self):
+        """Arguments are worked out once per file, callers get their own copy"""
+        parser, args = self._args()
+        args.append('-DMODIFIED')
+        self.assertNotIn('-DMODIFIED', parser.get_compile_commands(self.source))
+        self.assertEqual(list(parser._compile_args_cache), [self.source])
+
+    def test_one_translation_unit_per_file(self):
+        """Files spelled differently across commands are parsed once"""
+        self.assertEqual(get_source_files_from_compilation_database(self.temp_dir), [self.source])
+
+
+if __name__ == '__main__':
+    unittest.main()
@@ -0,0 +1,97 @@
+#!/usr/bin/env python3
+
+import unittest
+import sys
+import os
+import shutil
+import tempfile
+from pathlib import Path
+sys.path.append(str(Path(__file__).parent.parent.parent / "src"))
+from foamcd.logs import setup_logging
+
+logger = setup_logging(verbose=True).getChild('test.dependency_dbs')
+
+from omegaconf import OmegaConf
+from foamcd.config import Config
+from foamcd.db import EntityDatabase
+from foamcd.parse import ClangParser, LIBCLANG_CONFIGURED
+
+
+@unittest.skipIf(not LIBCLANG_CONFIGURED, "libclang is not configured")
+class TestDependencyDatabases(unittest.TestCase):
+    """Test cases for resolving references against prebuilt dependency databases"""
+
+    def setUp(self):
+        self.temp_dir = tempfile.mkdtemp()
+        self.core_dir = os.path.realpath(os.path.join(self.temp_dir, "core"))
+        os.makedirs(self.core_dir)
+        self.core_header = os.path.join(self.core_dir, "regIOobject.H")
+        with open(self.core_header, 'w') as f:
+            f.write("namespace Foam {\n"
+                    "class regIOobject;\n"
+                    "/** Registered object */\n"
+                    "class regIOobject { public: virtual ~regIOobject(); };\n"
+                    "template<class Type> class fvPatchField { public: virtual ~fvPatchField(); };\n"
+                    "}\n")
+        self.source = os.path.join(self.temp_dir, "lib.C")
+        with open(self.source, 'w') as f:
+            f.write('#include "core/regIOobject.H"\n'
+                    'namespace Foam {\n'
+                    'class myObject : public regIOobject {};\n'
+                    'template<class Type> class myPatchField : public fvPatchField<Type> {};\n'
+                    '}\n')
+
+        self.core_db_path = os.path.join(self.temp_dir, "core.db")
+        core_db = EntityDatabase(self.core_db_path)
+        ClangParser(db=core_db, disable_plugins=True, use_tree_sitter_fallback=False).parse_file(self.core_header)
+        core_db.cursor.execute("SELECT uuid, name FROM entities WHERE kind IN ('CLASS_DECL', 'CLASS_TEMPLATE') "
+                               "ORDER BY end_line - line DESC")
+        self.core_classes = {}
+        for uuid, name in core_db.cursor.fetchall():
+            self.core_classes.setdefault(name, uuid)
+        core_db.close()
+
+        self.config = Config()
+        OmegaConf.update(self.config.config, "parser.dependency_dbs",
+                         [{'path': self.core_db_path, 'prefixes': [self.core_dir]}])
+
+    def tearDown(self):
+        shutil.rmtree(self.temp_dir)
+
+    def test_bases_resolve_into_dependency(self):
+        """Dependency headers are not traversed, their classes are referenced by their dependency UUIDs"""
+        db = EntityDatabase(os.path.join(self.temp_dir, "docs.db"))
+        parser = ClangParser(db=db, config=self.config, disable_plugins=True, use_tree_sitter_fallback=False)
+        parser.parse_file(self.source)
+        parser.resolve_inheritance_relationships()
+
+        db.cursor.execute("SELECT class_name, base_uuid FROM inheritance ORDER BY class_name")
+        self.assertEqual([tuple(row) for row in db.cursor.fetchall()],
+                         [('myObject', self.core_classes['regIOobject']),
+                          ('myPatchField', self.core_classes['fvPatchField'])])
+
+        # Only the referenced classes and their namespace were copied, as external references
+        db.cursor.execute("SELECT name, is_external_reference FROM entities WHERE file = ? ORDER BY name",
+                          (os.path.realpath(self.core_header),))
+        self.assertEqual([tuple(row) for row in db.cursor.fetchall()],
+                         [('Foam', 1), ('fvPatchField', 1), ('regIOobject', 1)])
+        db.cursor.execute("SELECT doc_comment FROM entities WHERE uuid = ?", (self.core_classes['regIOobject'],))
+        self.assertIn("Registered object", db.cursor.fetchone()[0])
+        db.close()
+
+    def test_resolution_pass(self):
+        """Inheritance left unresolved at parse time resolves by qualified name"""
+        db = EntityDatabase(os.path.join(self.temp_dir, "docs.db"))
+        db.attach_dependencies([self.core_db_path])
+        db.store_entity({'uuid': 'derived', 'name': 'derived', 'kind': 'CLASS_DECL', 'file': self.source,
+                         'line': 1, 'end_line': 1, 'column': 1, 'end_column': 1,
+                         'base_classes': [{'name': 'Foam::regIOobject', 'access': 'PUBLIC'}]})
+        parser = ClangParser(db=db, disable_plugins=True, use_tree_sitter_fallback=False)
+        parser.resolve_inheritance_relationships()
+        db.cursor.execute("SELECT base_uuid FROM inheritance WHERE class_uuid = 'derived'")
+        self.assertEqual(db.cursor.fetchone()[0], self.core_classes['regIOobject'])
+        db.close()
+
+
+if __name__ == '__main__':
+    unittest.main()
@@ -0,0 +1,94 @@
+#!/usr/bin/env python3
+
+import unittest
+import sys
+import os
+import json
+import shutil
+import tempfile
+from pathlib import Path
+sys.path.append(str(Path(__file__).parent.parent.parent / "src"))
+from foamcd.logs import setup_logging
+
+logger = setup_logging(verbose=True).getChild('test.detector_bench')
+
+from foamcd.plugin_system import PluginManager
+from foamcd.parse import LIBCLANG_CONFIGURED
+
+PLUGIN = str(Path(__file__).parent.parent.parent / "plugins" / "openfoam_detector.py")
+
+SOURCE = """#define TypeName(name) static const char* typeName_() { return name; }
+#define declareRunTimeSelectionTable(ptr, base, argNames, argList, parList) typedef ptr (*argNames##Ptr)argList;
+namespace Foam { namespace models {
+class model
+{
+public:
+    TypeName("model");
+    declareRunTimeSelectionTable(model*, model, dictionary, (int a), (a))
+    virtual ~model() {}
+    int value() const { auto x = 1; return x; }
+};
+}}
+"""
+
+
+@unittest.skipIf(not LIBCLANG_CONFIGURED, "libclang is not configured")
+class TestDetectorBenchmark(unittest.TestCase):
+    """Test cases for the detector cost table"""
+
+    def setUp(self):
+        self.temp_dir = tempfile.mkdtemp()
+        self.source = os.path.join(self.temp_dir, "model.C")
+        with open(self.source, 'w') as f:
+            f.write(SOURCE)
+
+    def tearDown(self):
+        shutil.rmtree(self.temp_dir)
+
+    def test_cost_table(self):
+        """Every detector is timed on every detection cursor, plugins behind their filters"""
+        from foamcd.detector_bench import benchmark_detectors, format_cost_table
+        table = benchmark_detectors([self.source], plugin_files=[PLUGIN])
+        self.assertGreater(table['cursors'], 0)
+        detectors = table['detectors']
+        self.assertEqual(detectors['classes']['kind'], 'builtin')
+        self.assertEqual(detectors['classes']['calls'], table['cursors'])
+        self.assertGreater(detectors['auto_type']['hit_rate'], 0)
+        plugin = detectors['openfoam']
+        self.assertEqual(plugin['kind'], 'plugin')
+        self.assertEqual(plugin['calls'] + plugin['filtered'], table['cursors'])
+        self.assertGreater(plugin['hit_rate'], 0)
+        self.assertAlmostEqual(sum(cost['share'] for cost in detectors.values()), 1.0, places=2)
+        self.assertTrue(all(cost['p99_us'] >= 0 and cost['mean_us'] >= 0 for cost in detectors.values()))
+        self.assertIn('openfoam', format_cost_table(table))
+
+    def test_cost_ceiling(self):
+        """Plugins benchmarked over their ceiling are not loaded"""
+        from foamcd.detector_bench import benchmark_detectors
+        table = benchmark_detectors([self.source], plugin_files=[PLUGIN], builtins=False)
+        table_path = os.path.join(self.temp_dir, "costs.json")
+        with open(table_path, 'w') as f:
+            json.dump(table, f)
+        p99 = table['detectors']['openfoam']['p99_us']
+
+        def load(ceiling):
+            manager = PluginManager([], {'cost_ceiling': {'table': table_path, 'p99_us': 1e9,
+                                                          'per_detector': {'openfoam': ceiling}}})
+            manager.load_plugin(PLUGIN)
+            return manager
+
+        manager = load(p99 / 2)
+        self.assertNotIn('openfoam', manager.detectors)
+        self.assertIn('openfoam', manager.disabled_plugins)
+        self.assertIn('openfoam', load(p99 * 2).detectors)
+        self.assertIn('openfoam', load(0).detectors)
+
+        # Costs of another plugin version do not apply
+        table['detectors']['openfoam']['version'] = 'old'
+        with open(table_path, 'w') as f:
+            json.dump(table, f)
+        self.assertIn('openfoam', load(p99 / 2).detectors)
+
+
+if __name__ == '__main__':
+    unittest.main()
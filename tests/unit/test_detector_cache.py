@@ -0,0 +1,194 @@
+#!/usr/bin/env python3
+
+import unittest
+import sys
+import os
+import shutil
+import tempfile
+from pathlib import Path
+sys.path.append(str(Path(__file__).parent.parent.parent / "src"))
+from foamcd.logs import setup_logging
+
+logger = setup_logging(verbose=True).getChild('test.detector_cache')
+
+from clang.cindex import CursorKind
+from foamcd.db import EntityDatabase
+from foamcd.detector_cache import DetectorCache
+from foamcd.feature_detectors import (
+    FeatureDetector, FeatureDetectorRegistry, DeprecatedAttributeDetector, FunctionOverloadingDetector
+)
+from foamcd.plugin_system import PluginManager
+from foamcd.parse import ClangParser, LIBCLANG_CONFIGURED
+
+
+class MockCursor:
+    def __init__(self, kind=CursorKind.CLASS_DECL, spelling="test"):
+        self.kind = kind
+        self.spelling = spelling
+        self.location = None
+        self.type = None
+        self.semantic_parent = None
+        self.children = []
+
+    def get_children(self):
+        return self.children
+
+
+class CountingDetector(FeatureDetector):
+    def __init__(self, name="counting"):
+        super().__init__(name, "TEST", "Counts detect() calls")
+        self.calls = 0
+
+    def detect(self, cursor, token_spellings, token_str, available_cursor_kinds):
+        self.calls += 1
+        return "match" in token_spellings
+
+
+class CountingFieldDetector(CountingDetector):
+    entity_fields = {
+        "counted": {"type": "INTEGER", "description": "Number of matching tokens"}
+    }
+
+    def detect(self, cursor, token_spellings, token_str, available_cursor_kinds):
+        self.calls += 1
+        return {'detected': True, 'fields': {'counted': token_spellings.count("match")}}
+
+
+class DeferringDetector(FeatureDetector):
+    def __init__(self):
+        super().__init__("deferring_feature", "TEST", "Resolved at the end of the translation unit")
+        self.batches = []
+
+    def detect(self, cursor, token_spellings, token_str, available_cursor_kinds):
+        return {'detected': False, 'fields': {}, 'deferred': cursor.spelling}
+
+    def resolve_deferred(self, keys):
+        self.batches.append(list(keys))
+        return {key: {'detected': key == "A", 'fields': {}} for key in keys}
+
+
+class TestDetectorCache(unittest.TestCase):
+    """Test cases for the persistent detector result cache"""
+
+    def setUp(self):
+        self.temp_db_fd, self.temp_db_path = tempfile.mkstemp(suffix='.db')
+        self.db = EntityDatabase(self.temp_db_path)
+
+    def tearDown(self):
+        self.db.close()
+        os.close(self.temp_db_fd)
+        os.unlink(self.temp_db_path)
+
+    def _detect(self, registry, cursor, tokens):
+        """Run the registry through the cache like the parser does"""
+        cache = DetectorCache(self.db)
+        token_str = " ".join(tokens)
+        fingerprint = DetectorCache.fingerprint(cursor, token_str)
+        fresh = {}
+        features = registry.detect_features(cursor, tokens, token_str, [], cache.lookup(fingerprint), fresh)
+        cache.record(fingerprint, fresh)
+        cache.flush()
+        return features
+
+    def test_fingerprint(self):
+        """Fingerprints depend on the cursor kind, spelling and tokens"""
+        base = DetectorCache.fingerprint(MockCursor(), "class A { }")
+        self.assertEqual(base, DetectorCache.fingerprint(MockCursor(), "class A { }"))
+        self.assertNotEqual(base, DetectorCache.fingerprint(MockCursor(), "class A { int x ; }"))
+        self.assertNotEqual(base, DetectorCache.fingerprint(MockCursor(CursorKind.STRUCT_DECL), "class A { }"))
+        self.assertNotEqual(base, DetectorCache.fingerprint(MockCursor(spelling="B"), "class A { }"))
+
+    def test_registry_skips_cached_detectors(self):
+        """Unchanged entities are not run through detectors again"""
+        registry = FeatureDetectorRegistry()
+        detector = CountingDetector()
+        registry.register(detector)
+        self.assertEqual(self._detect(registry, MockCursor(), ["match"]), {"counting"})
+        self.assertEqual(self._detect(registry, MockCursor(), ["match"]), {"counting"})
+        self.assertEqual(detector.calls, 1)
+
+        self.assertEqual(self._detect(registry, MockCursor(), ["other"]), set())
+        self.assertEqual(detector.calls, 2)
+
+        # A new detector version invalidates cached results
+        detector.version = "2"
+        self.assertEqual(self._detect(registry, MockCursor(), ["match"]), {"counting"})
+        self.assertEqual(detector.calls, 3)
+
+    def test_deprecation_message_is_cached(self):
+        """The deprecation message survives a cache round trip"""
+        registry = FeatureDetectorRegistry()
+        detector = DeprecatedAttributeDetector()
+        registry.register(detector)
+        tokens = ["[[", "deprecated", "(", '"use B"', ")", "]]", "class", "A"]
+        self.assertIn("deprecated_attribute", self._detect(registry, MockCursor(), tokens))
+        detector.deprecation_message = None
+        self.assertIn("deprecated_attribute", self._detect(registry, MockCursor(), tokens))
+        self.assertEqual(detector.deprecation_message, "use B")
+
+    def test_context_dependent_results_are_not_cached(self):
+        """Detectors looking beyond the entity's tokens run again on unchanged tokens"""
+        registry = FeatureDetectorRegistry()
+        registry.register(FunctionOverloadingDetector())
+        scope = MockCursor(CursorKind.NAMESPACE, "scope")
+        function = MockCursor(CursorKind.FUNCTION_DECL, "f")
+        function.semantic_parent = scope
+        scope.children = [function]
+        tokens = ["void", "f", "(", "int", ")"]
+        self.assertNotIn("function_overloading", self._detect(registry, function, tokens))
+
+        # An overload declared elsewhere changes the result of the same tokens
+        scope.children.append(MockCursor(CursorKind.FUNCTION_DECL, "f"))
+        self.assertIn("function_overloading", self._detect(registry, function, tokens))
+
+    def test_plugin_results_are_cached(self):
+        """Plugin results, including custom fields, are served from the cache"""
+        manager = PluginManager([], {})
+        detector = CountingFieldDetector("counting_plugin")
+        manager.register_detector(detector)
+        cursor = MockCursor()
+        tokens = ["match", "match"]
+        for _ in range(2):
+            cache = DetectorCache(self.db)
+            fingerprint = DetectorCache.fingerprint(cursor, " ".join(tokens))
+            fresh = {}
+            result = manager.detect_features(cursor, tokens, " ".join(tokens), [], cache.lookup(fingerprint), fresh)
+            cache.record(fingerprint, fresh)
+            cache.flush()
+            self.assertEqual(result["features"], {"counting_plugin"})
+            self.assertEqual(result["custom_fields"], {"counted": 2})
+        self.assertEqual(detector.calls, 1)
+
+
+@unittest.skipIf(not LIBCLANG_CONFIGURED, "libclang is not configured")
+class TestDeferredPluginResults(unittest.TestCase):
+    """Test cases for plugin results deferred to the end of a parsed translation unit"""
+
+    def setUp(self):
+        self.temp_dir = tempfile.mkdtemp()
+        self.source = os.path.join(self.temp_dir, "deferred.C")
+        with open(self.source, 'w') as f:
+            f.write("class A { public: int f() const { return 0; } };\nclass B {};\n")
+        self.db = EntityDatabase(os.path.join(self.temp_dir, "docs.db"))
+
+    def tearDown(self):
+        self.db.close()
+        shutil.rmtree(self.temp_dir)
+
+    def test_parse_file_resolves_deferred_results(self):
+        """Deferring plugins do not drop the translation unit and their results reach the entities"""
+        parser = ClangParser(db=self.db, use_tree_sitter_fallback=False)
+        self.addCleanup(parser.plugin_manager.shutdown)
+        detector = DeferringDetector()
+        parser.plugin_manager.register_detector(detector)
+
+        entities = parser.parse_file(self.source)
+        classes = {entity.name: entity for entity in entities if entity.name in ("A", "B")}
+        self.assertEqual(sorted(classes), ["A", "B"])
+        self.assertIn("deferring_feature", classes["A"].cpp_features)
+        self.assertNotIn("deferring_feature", classes["B"].cpp_features)
+        self.assertEqual(len(detector.batches), 1)
+
+
+if __name__ == '__main__':
+    unittest.main()
@@ -0,0 +1,120 @@
+#!/usr/bin/env python3
+
+import unittest
+import sys
+import os
+import tempfile
+import importlib.util
+from pathlib import Path
+sys.path.append(str(Path(__file__).parent.parent.parent / "src"))
+from foamcd.logs import setup_logging
+
+logger = setup_logging(verbose=True).getChild('test.macro_index')
+
+from clang.cindex import CursorKind, TranslationUnit
+import clang.cindex
+from foamcd.parse import LIBCLANG_CONFIGURED
+from foamcd.macro_index import MacroIndex, split_macro_arguments, find_macro_calls
+
+PLUGIN_FILE = Path(__file__).parent.parent.parent / "plugins" / "openfoam_detector.py"
+
+RTS_SOURCE = """
+#define declareRunTimeSelectionTable(ptr, base, name, argList, parList) struct add##name##ConstructorToTable {};
+#define TypeName(n) static const char* typeName_() { return n; }
+
+template<class A, class B> struct pair {};
+struct dictionary {};
+
+class baseModel {
+public:
+    TypeName("baseModel");
+
+    declareRunTimeSelectionTable
+    (
+        autoPtr,
+        baseModel,
+        dictionary,
+        (const dictionary& dict, const pair<int, int>& p),
+        (dict, p)
+    )
+};
+
+class otherModel {};
+"""
+
+
+def load_openfoam_detector():
+    spec = importlib.util.spec_from_file_location("openfoam_detector", PLUGIN_FILE)
+    module = importlib.util.module_from_spec(spec)
+    spec.loader.exec_module(module)
+    return module.OpenFOAMDetector()
+
+
+class TestMacroIndex(unittest.TestCase):
+    """Test cases for the macro invocation index"""
+
+    def test_split_macro_arguments(self):
+        """Arguments split at top-level commas only"""
+        tokens = ["M", "(", "a", ",", "pair", "<", "int", ",", "int", ">", ",",
+                  "(", "x", ",", "y", ")", ")", ";"]
+        args, end = split_macro_arguments(tokens, 1)
+        self.assertEqual(args, ["a", "pair < int", "int >", "( x , y )"])
+        self.assertEqual(end, 16)
+        self.assertEqual(split_macro_arguments(["M", "(", ")"], 1)[0], [])
+        self.assertEqual(split_macro_arguments(["M", "(", "a"], 1), (None, 1))
+        self.assertEqual(split_macro_arguments(["M", ";"], 1), (None, 1))
+
+    def test_find_macro_calls(self):
+        """Token-stream fallback finds calls with their arguments"""
+        tokens = ["TypeName", "(", '"a"', ")", ";", "Other", "(", "b", ")",
+                  "TypeName", ";"]
+        calls = find_macro_calls(tokens, ["TypeName"])
+        self.assertEqual(len(calls), 1)
+        self.assertEqual(calls[0].name, "TypeName")
+        self.assertEqual(calls[0].args, ['"a"'])
+
+    @unittest.skipIf(not LIBCLANG_CONFIGURED, "libclang is not configured")
+    def test_index_from_translation_unit(self):
+        """Invocations are indexed from the preprocessing record and found by cursor extent"""
+        fd, path = tempfile.mkstemp(suffix='.H')
+        try:
+            with os.fdopen(fd, 'w') as f:
+                f.write(RTS_SOURCE)
+            tu = clang.cindex.Index.create().parse(
+                path, ["-x", "c++", "-std=c++17"],
+                options=TranslationUnit.PARSE_DETAILED_PROCESSING_RECORD)
+            index = MacroIndex.build(tu, ["declareRunTimeSelectionTable", "TypeName"])
+            self.assertEqual(len(index), 2)
+            classes = {c.spelling: c for c in tu.cursor.get_children()
+                       if c.kind == CursorKind.CLASS_DECL}
+            calls = index.within_cursor(classes["baseModel"])
+            self.assertEqual([call.name for call in calls], ["TypeName", "declareRunTimeSelectionTable"])
+            self.assertEqual(calls[1].args, [
+                "autoPtr", "baseModel", "dictionary",
+                "( const dictionary & dict , const pair < int , int > & p )",
+                "( dict , p )"
+            ])
+            self.assertEqual(index.within_cursor(classes["otherModel"]), [])
+            self.assertEqual(index.within_cursor(classes["baseModel"], ["TypeName"])[0].args, ['"baseModel"'])
+
+            # The OpenFOAM plugin reads the same calls from the index and from raw tokens
+            detector = load_openfoam_detector()
+            cursor = classes["baseModel"]
+            tokens = [t.spelling for t in cursor.get_tokens()]
+            without_index = detector.detect(cursor, tokens, " ".join(tokens), [])
+            detector.macro_index = index
+            with_index = detector.detect(cursor, tokens, " ".join(tokens), [])
+            self.assertEqual(with_index, without_index)
+            fields = with_index['fields']
+            self.assertEqual(fields['openfoam_rts_status'], 'complete')
+            self.assertEqual(fields['openfoam_type_name'], 'baseModel')
+            self.assertEqual(fields['openfoam_rts_names'], 'dictionary')
+            self.assertEqual(fields['openfoam_rts_constructor_params'],
+                             'const dictionary & dict , const pair < int , int > & p')
+            self.assertEqual(fields['openfoam_rts_selector_params'], 'dict , p')
+        finally:
+            os.unlink(path)
+
+
+if __name__ == '__main__':
+    unittest.main()
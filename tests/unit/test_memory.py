@@ -0,0 +1,147 @@
+#!/usr/bin/env python3
+
+import unittest
+import sys
+import os
+import shutil
+import tempfile
+from pathlib import Path
+sys.path.append(str(Path(__file__).parent.parent.parent / "src"))
+from foamcd.logs import setup_logging
+
+logger = setup_logging(verbose=True).getChild('test.memory')
+
+from foamcd.memory import MemoryAccounting, memory
+from foamcd.db import EntityDatabase
+from foamcd.parse import ClangParser, LIBCLANG_CONFIGURED
+
+# Kept alive by the test, so that it shows up as a retaining call site
+_retained = []
+
+
+class TestMemoryAccounting(unittest.TestCase):
+    """Test cases for per-phase memory records"""
+
+    def setUp(self):
+        self.temp_dir = tempfile.mkdtemp()
+        self.accounting = MemoryAccounting()
+
+    def tearDown(self):
+        self.accounting.disable()
+        _retained.clear()
+        shutil.rmtree(self.temp_dir)
+
+    def test_disabled(self):
+        """Disabled accounting records nothing"""
+        with self.accounting.phase('traverse', 'a.C'):
+            _retained.append(bytearray(1 << 20))
+        self.assertEqual(self.accounting.records, [])
+
+    def test_phases(self):
+        """Phases record what they keep and their peak, nested phases included"""
+        self.accounting.enable()
+        with self.accounting.phase('translation unit', 'a.C'):
+            with self.accounting.phase('traverse', 'a.C'):
+                _retained.append(bytearray(2 << 20))
+                transient = bytearray(4 << 20)
+                del transient
+            with self.accounting.phase('db write', 'a.C'):
+                pass
+        records = {record['phase']: record for record in self.accounting.records}
+        self.assertEqual(set(records), {'translation unit', 'traverse', 'db write'})
+        traverse = records['traverse']
+        self.assertGreaterEqual(traverse['py_delta_kb'], 2 << 10)
+        self.assertLess(traverse['py_delta_kb'], 4 << 10)
+        self.assertGreaterEqual(traverse['py_peak_kb'], 6 << 10)
+        self.assertLess(records['db write']['py_peak_kb'], 1 << 10)
+        # The enclosing phase keeps the peak of the phases within it
+        self.assertGreaterEqual(records['translation unit']['py_peak_kb'], traverse['py_peak_kb'])
+        if traverse['peak_rss_kb'] is not None:
+            self.assertGreater(traverse['peak_rss_kb'], 0)
+
+        summary = self.accounting.summary(top=3)
+        self.assertEqual(summary['phases']['traverse']['count'], 1)
+        self.assertEqual(summary['subjects'][0]['subject'], 'a.C')
+        self.assertTrue(any('test_memory.py' in site['site'] and site['size_kb'] >= 2 << 10
+                            for site in summary['sites']))
+
+    def test_worker_reports(self):
+        """Records and retaining sites of workers are merged into the parent's"""
+        self.accounting.enable()
+        worker = {'records': [{'phase': 'traverse', 'subject': 'b.C', 'pid': 1, 'seconds': 0.1, 'rss_kb': 100,
+                               'rss_delta_kb': 10, 'peak_rss_kb': 200, 'peak_rss_growth_kb': 20,
+                               'py_delta_kb': 5, 'py_peak_kb': 7}],
+                  'sites': [['parse.py:100', 64 << 20, 10]]}
+        self.accounting.extend(worker)
+        self.accounting.extend(worker)
+        self.assertEqual(len(self.accounting.records), 2)
+        sites = self.accounting.retained_sites(top=1)
+        self.assertEqual(sites, [{'site': 'parse.py:100', 'size_kb': 128 << 10, 'count': 20}])
+
+    def test_heaviest_subjects(self):
+        """Subjects are ranked by what they added to the RSS high-water mark, not by the mark itself"""
+        self.accounting.enable()
+        record = {'phase': 'traverse', 'pid': 1, 'seconds': 0.1, 'rss_kb': 100, 'rss_delta_kb': 0,
+                  'py_delta_kb': 0, 'py_peak_kb': 0}
+        # The light file parsed after the heavy one sees the mark the heavy one left behind
+        self.accounting.extend({'records': [
+            dict(record, subject='heavy.C', peak_rss_kb=500 << 10, peak_rss_growth_kb=400 << 10),
+            dict(record, subject='light.C', peak_rss_kb=510 << 10, peak_rss_growth_kb=10 << 10),
+        ]})
+        subjects = self.accounting.summary(top=2)['subjects']
+        self.assertEqual([subject['subject'] for subject in subjects], ['heavy.C', 'light.C'])
+        self.assertEqual(subjects[0]['peak_rss_growth_kb'], 400 << 10)
+
+    def test_store(self):
+        """Records and sites of a run are stored in run_metrics, replacing those stored before"""
+        self.accounting.enable()
+        with self.accounting.phase('libclang parse', 'a.C'):
+            pass
+        db = EntityDatabase(os.path.join(self.temp_dir, "docs.db"))
+        sites = [{'site': 'parse.py:100', 'size_kb': 10, 'count': 1}]
+        for _ in range(2):
+            db.store_run_metrics('2026-01-01T00:00:00', 'parse', self.accounting.records, sites)
+        rows = db.get_run_metrics()
+        self.assertEqual(sorted(row['phase'] for row in rows), ['libclang parse', 'retained'])
+        retained = next(row for row in rows if row['phase'] == 'retained')
+        self.assertEqual((retained['subject'], retained['py_delta_kb']), ('parse.py:100', 10))
+        self.assertEqual(db.get_run_metrics(command='markdown'), [])
+        db.close()
+
+
+@unittest.skipIf(not LIBCLANG_CONFIGURED, "libclang is not configured")
+class TestParseMemory(unittest.TestCase):
+    """Test cases for memory records of parse runs"""
+
+    def setUp(self):
+        self.temp_dir = tempfile.mkdtemp()
+        self.files = []
+        for name in ['a', 'b']:
+            path = os.path.join(self.temp_dir, f"{name}.C")
+            with open(path, 'w') as f:
+                f.write(f"class {name.upper()} {{ public: int f() const {{ return 0; }} }};\n")
+            self.files.append(path)
+        memory.enable()
+
+    def tearDown(self):
+        memory.disable()
+        shutil.rmtree(self.temp_dir)
+
+    def test_lanes(self):
+        """Parse lanes report the phases of each of their translation units"""
+        db = EntityDatabase(os.path.join(self.temp_dir, "docs.db"))
+        parser = ClangParser(db=db, disable_plugins=True, use_tree_sitter_fallback=False)
+        parser.parse_lanes([[self.files[0]], [self.files[1]]])
+        db.close()
+
+        phases = {}
+        for record in memory.records:
+            phases.setdefault(record['phase'], set()).add(record['subject'])
+        for phase in ['translation unit', 'libclang parse', 'traverse', 'db write']:
+            self.assertEqual(phases.get(phase), set(self.files), phase)
+        self.assertNotIn(os.getpid(), {record['pid'] for record in memory.records})
+        self.assertTrue(memory.summary()['sites'])
+
+
+if __name__ == '__main__':
+    unittest.main()
@@ -0,0 +1,107 @@
+#!/usr/bin/env python3
+
+import unittest
+import sys
+import os
+import json
+import shutil
+import tempfile
+from pathlib import Path
+sys.path.append(str(Path(__file__).parent.parent.parent / "src"))
+from foamcd.logs import setup_logging
+
+logger = setup_logging(verbose=True).getChild('test.metrics_export')
+
+from foamcd.metrics_export import RunMetrics
+from foamcd.db import EntityDatabase
+from foamcd.parse import ClangParser, LIBCLANG_CONFIGURED, record_parse_metrics
+
+
+class TestRunMetrics(unittest.TestCase):
+    """Test cases for writing run metrics as OpenMetrics and JSON"""
+
+    def setUp(self):
+        self.temp_dir = tempfile.mkdtemp()
+
+    def tearDown(self):
+        shutil.rmtree(self.temp_dir)
+
+    def test_openmetrics(self):
+        """Families are gauges with their unit and help, samples are labeled and escaped"""
+        metrics = RunMetrics('parse')
+        metrics.set('translation_units', 3, "Files of the run, by outcome", status='parsed')
+        metrics.set('translation_units', 1, "Files of the run, by outcome", status='failed')
+        metrics.set('translation_units', 4, "Files of the run, by outcome", status='parsed')
+        metrics.set('fallbacks', None, "Not recorded")
+        metrics.set_phase('parse', 1.5)
+        metrics.set_cache('parse', 3, 1)
+        metrics.set('run_info', 1, "Labels with \"quotes\"", version='1.0 "dev"\\x')
+
+        text = metrics.to_openmetrics()
+        lines = text.splitlines()
+        self.assertEqual(lines[-1], "# EOF")
+        self.assertIn('foamcd_translation_units{status="parsed"} 4', lines)
+        self.assertIn('foamcd_translation_units{status="failed"} 1', lines)
+        self.assertEqual(text.count('# TYPE foamcd_translation_units gauge'), 1)
+        self.assertIn('# UNIT foamcd_phase_duration_seconds seconds', lines)
+        self.assertIn('foamcd_phase_duration_seconds{phase="parse"} 1.5', lines)
+        self.assertIn('foamcd_cache_hit_ratio{cache="parse"} 0.75', lines)
+        self.assertIn('foamcd_run_info{version="1.0 \\"dev\\"\\\\x"} 1', lines)
+        self.assertNotIn('foamcd_fallbacks', text)
+        self.assertEqual(metrics.get('translation_units', status='parsed'), 4)
+
+    def test_write(self):
+        """Both files are written to the directory, with the outcome of the run and database size"""
+        db_path = os.path.join(self.temp_dir, "docs.db")
+        EntityDatabase(db_path).close()
+        metrics = RunMetrics('markdown')
+        metrics.set('pages', 2, "Markdown pages of the run, by outcome", status='generated')
+        metrics.finish(True, db_path)
+        output_dir = os.path.join(self.temp_dir, "textfile")
+        self.assertTrue(metrics.write(output_dir))
+        self.assertEqual(sorted(os.listdir(output_dir)), ['foamcd_markdown.json', 'foamcd_markdown.prom'])
+
+        with open(os.path.join(output_dir, 'foamcd_markdown.json')) as f:
+            written = json.load(f)
+        self.assertEqual(written['command'], 'markdown')
+        samples = {name: family['samples'] for name, family in written['metrics'].items()}
+        self.assertEqual(samples['foamcd_run_success'][0]['value'], True)
+        self.assertGreater(samples['foamcd_database_size_bytes'][0]['value'], 0)
+        self.assertEqual(samples['foamcd_pages'], [{'labels': {'status': 'generated'}, 'value': 2}])
+        with open(os.path.join(output_dir, 'foamcd_markdown.prom')) as f:
+            self.assertIn('foamcd_run_success 1\n', f.read())
+
+
+@unittest.skipIf(not LIBCLANG_CONFIGURED, "libclang is not configured")
+class TestParseMetrics(unittest.TestCase):
+    """Test cases for the metrics of parse runs"""
+
+    def setUp(self):
+        self.temp_dir = tempfile.mkdtemp()
+        self.files = []
+        for name in ['a', 'b']:
+            path = os.path.join(self.temp_dir, f"{name}.C")
+            with open(path, 'w') as f:
+                f.write(f"class {name.upper()} {{ public: int f() const {{ return 0; }} }};\n")
+            self.files.append(path)
+
+    def tearDown(self):
+        shutil.rmtree(self.temp_dir)
+
+    def test_lanes(self):
+        """Entities and detector cache lookups of all lanes are reported"""
+        db = EntityDatabase(os.path.join(self.temp_dir, "docs.db"))
+        parser = ClangParser(db=db, disable_plugins=True, use_tree_sitter_fallback=False)
+        parser.parse_lanes([[self.files[0]], [self.files[1]]])
+        metrics = RunMetrics('parse')
+        record_parse_metrics(metrics, parser, db)
+        db.close()
+
+        self.assertGreaterEqual(metrics.get('entities'), 4)
+        self.assertEqual(metrics.get('fallbacks'), 0)
+        lookups = metrics.get('cache_hits', cache='detector') + metrics.get('cache_misses', cache='detector')
+        self.assertGreater(lookups, 0)
+
+
+if __name__ == '__main__':
+    unittest.main()
@@ -0,0 +1,139 @@
+#!/usr/bin/env python3
+
+import unittest
+import sys
+import os
+import stat
+import shutil
+import tempfile
+from pathlib import Path
+from unittest.mock import patch
+sys.path.append(str(Path(__file__).parent.parent.parent / "src"))
+from foamcd.logs import setup_logging
+
+logger = setup_logging(verbose=True).getChild('test.modules')
+
+from foamcd.modules import ModuleCache, scan_module_unit
+from foamcd.db import EntityDatabase
+from foamcd.parse import ClangParser, LIBCLANG_CONFIGURED
+
+# Stand-in for clang++ --precompile, writing its arguments to the -o target
+FAKE_COMPILER = """#!/bin/sh
+out=""
+while [ $# -gt 0 ]; do
+  if [ "$1" = "-o" ]; then out="$2"; fi
+  shift
+done
+echo built > "$out"
+"""
+
+
+class TestModuleCache(unittest.TestCase):
+    """Test cases for finding and prebuilding C++20 module interfaces"""
+
+    def setUp(self):
+        self.temp_dir = os.path.realpath(tempfile.mkdtemp())
+        sources = {
+            'geometry.cppm': '// module interface\nexport module geometry;\nimport math;\nexport import :shapes;\n',
+            'shapes.cppm': 'module;\n#include <vector>\nexport module geometry:shapes;\n',
+            'math.ixx': '/* import nothing; */\nexport module math;\n',
+            'geometry.cpp': 'module geometry;\nint area() { return 0; }\n',
+            'main.C': '#include <vector>\nimport geometry;\nint main() {}\n',
+        }
+        self.files = {}
+        for name, content in sources.items():
+            path = os.path.join(self.temp_dir, name)
+            with open(path, 'w') as f:
+                f.write(content)
+            self.files[name] = path
+        self.compiler = os.path.join(self.temp_dir, "clang++")
+        with open(self.compiler, 'w') as f:
+            f.write(FAKE_COMPILER)
+        os.chmod(self.compiler, os.stat(self.compiler).st_mode | stat.S_IEXEC)
+        self.cache_dir = os.path.join(self.temp_dir, "cache")
+
+    def tearDown(self):
+        shutil.rmtree(self.temp_dir)
+
+    def _args(self, path):
+        return ['-std=c++20', '-c', '-o', 'out.o', '-I', self.temp_dir]
+
+    def test_scan(self):
+        """Interfaces, partitions and implementation units are told apart, comments ignored"""
+        self.assertEqual(scan_module_unit(self.files['geometry.cppm']),
+                         ('geometry', True, ['math', 'geometry:shapes']))
+        self.assertEqual(scan_module_unit(self.files['shapes.cppm']), ('geometry:shapes', True, []))
+        self.assertEqual(scan_module_unit(self.files['math.ixx']), ('math', True, []))
+        self.assertEqual(scan_module_unit(self.files['geometry.cpp']), ('geometry', False, ['geometry']))
+        self.assertEqual(scan_module_unit(self.files['main.C']), (None, False, ['geometry']))
+
+    def test_reachable(self):
+        """Importers reach modules through other modules, dependencies first"""
+        cache = ModuleCache(self.cache_dir, self.compiler)
+        self.assertEqual(cache.scan(list(self.files.values())), 3)
+        self.assertEqual(cache.reachable(self.files['main.C']), ['math', 'geometry:shapes', 'geometry'])
+
+    def test_built_once(self):
+        """Interfaces are built once, reused by later runs and rebuilt when they change"""
+        cache = ModuleCache(self.cache_dir, self.compiler)
+        cache.scan(list(self.files.values()))
+        self.assertEqual(cache.build_all(self._args), 3)
+        self.assertEqual((cache.builds, cache.reused), (3, 0))
+        args = cache.importer_args(self.files['main.C'])
+        self.assertEqual([arg.split('=')[1] for arg in args], ['math', 'geometry:shapes', 'geometry'])
+        self.assertTrue(all(os.path.exists(arg.split('=', 2)[2]) for arg in args))
+
+        cache = ModuleCache(self.cache_dir, self.compiler)
+        cache.scan(list(self.files.values()))
+        cache.build_all(self._args)
+        self.assertEqual((cache.builds, cache.reused), (0, 3))
+        self.assertEqual(cache.importer_args(self.files['main.C']), args)
+
+        # A changed interface gets a new BMI, and so do the modules importing it
+        with open(self.files['math.ixx'], 'a') as f:
+            f.write('export int square(int x) { return x * x; }\n')
+        cache = ModuleCache(self.cache_dir, self.compiler)
+        cache.scan(list(self.files.values()))
+        cache.build_all(self._args)
+        self.assertEqual((cache.builds, cache.reused), (2, 1))
+
+    def test_scan_reused(self):
+        """Later runs only read the files which changed since their scan was stored"""
+        db = EntityDatabase(os.path.join(self.temp_dir, "docs.db"))
+        cache = ModuleCache(self.cache_dir, self.compiler)
+        cache.scan(list(self.files.values()), db.get_module_scans())
+        self.assertEqual(len(cache.rescanned), 5)
+        db.store_module_scans(cache.rescanned)
+
+        with open(self.files['main.C'], 'a') as f:
+            f.write('import math;\n')
+        cache = ModuleCache(self.cache_dir, self.compiler)
+        with patch('foamcd.modules.scan_module_unit', wraps=scan_module_unit) as scan:
+            self.assertEqual(cache.scan(list(self.files.values()), db.get_module_scans()), 3)
+        self.assertEqual([call.args[0] for call in scan.call_args_list], [self.files['main.C']])
+        self.assertEqual(cache.reachable(self.files['main.C']), ['math', 'geometry:shapes', 'geometry'])
+        db.close()
+
+    @unittest.skipIf(not LIBCLANG_CONFIGURED, "libclang is not configured")
+    def test_single_file_without_imports(self):
+        """Parsing a single file importing no module scans nothing else"""
+        other = os.path.join(self.temp_dir, "other.C")
+        with open(other, 'w') as f:
+            f.write('int main() {}\n')
+        db = EntityDatabase(os.path.join(self.temp_dir, "docs.db"))
+        parser = ClangParser(db=db, disable_plugins=True, use_tree_sitter_fallback=False)
+        with patch.object(ModuleCache, 'scan') as scan:
+            self.assertEqual(parser.prepare_modules(list(self.files.values()) + [other], importers=[other]), 0)
+        scan.assert_not_called()
+        db.close()
+
+    def test_no_compiler(self):
+        """Without a compiler, nothing is built and importers get no module arguments"""
+        cache = ModuleCache(self.cache_dir, None)
+        cache.scan(list(self.files.values()))
+        self.assertEqual(cache.build_all(self._args), 0)
+        self.assertEqual(cache.importer_args(self.files['main.C']), [])
+
+
+if __name__ == '__main__':
+    unittest.main()
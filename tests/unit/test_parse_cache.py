@@ -0,0 +1,101 @@
+#!/usr/bin/env python3
+
+import unittest
+import sys
+import os
+import shutil
+import tempfile
+from pathlib import Path
+from unittest.mock import patch
+sys.path.append(str(Path(__file__).parent.parent.parent / "src"))
+from foamcd.logs import setup_logging
+
+logger = setup_logging(verbose=True).getChild('test.parse_cache')
+
+from omegaconf import OmegaConf
+from foamcd.config import Config
+from foamcd.db import EntityDatabase
+from foamcd.parse import ClangParser, LIBCLANG_CONFIGURED
+from foamcd.parse_cache import ParseCache
+
+SOURCE = """#include "base.H"
+namespace ns {
+/** Derived class */
+class Derived : public Base {
+public:
+    typedef int label;
+    void f() override;
+};
+void Derived::f() {}
+}
+"""
+
+
+class TestParseCache(unittest.TestCase):
+    """Test cases for the content-addressed parse cache"""
+
+    def setUp(self):
+        self.temp_dir = tempfile.mkdtemp()
+        self.header = os.path.join(self.temp_dir, "base.H")
+        with open(self.header, 'w') as f:
+            f.write("namespace ns { class Base { public: virtual void f(); }; }\n")
+
+    def tearDown(self):
+        shutil.rmtree(self.temp_dir)
+
+    def test_lookup_checks_headers(self):
+        """Entries are found again until one of the headers changes"""
+        cache = ParseCache(os.path.join(self.temp_dir, "cache"))
+        key = ParseCache.digest("a.C")
+        self.assertIsNone(cache.lookup(key))
+        cache.store(key, [self.header], {'entities': [{'name': 'x'}]})
+        self.assertEqual(ParseCache(cache.cache_dir).lookup(key), {'entities': [{'name': 'x'}]})
+        with open(self.header, 'a') as f:
+            f.write("// changed\n")
+        self.assertIsNone(ParseCache(cache.cache_dir).lookup(key))
+        self.assertEqual((cache.hits, cache.misses), (0, 1))
+
+    @unittest.skipIf(not LIBCLANG_CONFIGURED, "libclang is not configured")
+    def test_hit_skips_libclang(self):
+        """A cache hit stores the same rows as a full parse, without invoking libclang"""
+        source = os.path.join(self.temp_dir, "derived.C")
+        with open(source, 'w') as f:
+            f.write(SOURCE)
+        config = Config()
+        OmegaConf.update(config.config, "parser.parse_cache.dir", os.path.join(self.temp_dir, "cache"))
+
+        def parse_into(db_name):
+            db = EntityDatabase(os.path.join(self.temp_dir, db_name))
+            parser = ClangParser(db=db, config=config, disable_plugins=True, use_tree_sitter_fallback=False)
+            entities = parser.parse_file(source)
+            rows = {}
+            for table in ('entities', 'inheritance', 'class_member_types', 'entity_features', 'parsed_docs',
+                          'tu_includes'):
+                db.cursor.execute(f"SELECT * FROM {table}")
+                rows[table] = sorted(tuple(row) for row in db.cursor.fetchall())
+            # Durations differ between runs, the rest of the parse cost record does not
+            db.cursor.execute("SELECT path, hash, peak_rss_kb, status, route FROM tu_stats")
+            rows['tu_stats'] = sorted(tuple(row) for row in db.cursor.fetchall())
+            db.close()
+            return parser, entities, rows
+
+        parser, entities, parsed_rows = parse_into("parsed.db")
+        self.assertEqual((parser.parse_cache.hits, parser.parse_cache.misses), (0, 1))
+        self.assertTrue(parsed_rows['class_member_types'])
+        self.assertTrue(parsed_rows['tu_includes'])
+        self.assertTrue(parsed_rows['tu_stats'])
+
+        with patch('clang.cindex.Index.parse', side_effect=AssertionError("libclang invoked")):
+            parser, cached_entities, cached_rows = parse_into("cached.db")
+        self.assertEqual(parser.parse_cache.hits, 1)
+        self.assertEqual([e['name'] for e in cached_entities], [e.name for e in entities])
+        self.assertEqual(cached_rows, parsed_rows)
+
+        with open(self.header, 'a') as f:
+            f.write("// changed\n")
+        parser, _, _ = parse_into("changed.db")
+        self.assertEqual((parser.parse_cache.hits, parser.parse_cache.misses), (0, 1))
+
+
+if __name__ == '__main__':
+    unittest.main()
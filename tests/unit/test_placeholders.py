@@ -0,0 +1,71 @@
+#!/usr/bin/env python3
+
+import unittest
+import sys
+import os
+import shutil
+import tempfile
+from pathlib import Path
+sys.path.append(str(Path(__file__).parent.parent.parent / "src"))
+from foamcd.logs import setup_logging
+
+logger = setup_logging(verbose=True).getChild('test.placeholders')
+
+from omegaconf import OmegaConf
+from foamcd.config import Config
+from foamcd.db import EntityDatabase
+from foamcd.entity import PlaceholderEntity
+from foamcd.parse import ClangParser, LIBCLANG_CONFIGURED
+
+SYSTEM_HEADER = """namespace sys { int f(); }
+namespace sys { int g(); }
+class Base { public: virtual ~Base(); };
+"""
+
+
+@unittest.skipIf(not LIBCLANG_CONFIGURED, "libclang is not configured")
+class TestPlaceholderInterning(unittest.TestCase):
+    """Test cases for run-wide interning of external reference placeholders"""
+
+    def setUp(self):
+        self.temp_dir = tempfile.mkdtemp()
+        self.system_dir = os.path.realpath(os.path.join(self.temp_dir, "system"))
+        os.makedirs(self.system_dir)
+        with open(os.path.join(self.system_dir, "sys.H"), 'w') as f:
+            f.write(SYSTEM_HEADER)
+        self.files = []
+        for name in ['a', 'b']:
+            path = os.path.join(self.temp_dir, f"{name}.C")
+            with open(path, 'w') as f:
+                f.write(f'#include "system/sys.H"\nclass {name.upper()} : public Base {{}};\n')
+            self.files.append(path)
+        config = Config()
+        OmegaConf.update(config.config, "parser.prefixes_to_skip", [self.system_dir])
+        self.db = EntityDatabase(os.path.join(self.temp_dir, "docs.db"))
+        self.parser = ClangParser(db=self.db, config=config, disable_plugins=True, use_tree_sitter_fallback=False)
+
+    def tearDown(self):
+        self.db.close()
+        shutil.rmtree(self.temp_dir)
+
+    def test_stored_once(self):
+        """Reopened namespaces share one placeholder, stored by the first file only"""
+        entities = self.parser.parse_file(self.files[0])
+        placeholders = [e for e in entities if isinstance(e, PlaceholderEntity)]
+        self.assertEqual(sorted(e.name for e in placeholders), ['Base', 'sys'])
+        self.parser.resolve_inheritance_relationships()
+        entities = self.parser.parse_file(self.files[1])
+        self.assertEqual([e.name for e in entities], ['B'])
+
+        self.db.cursor.execute("SELECT name, is_external_reference FROM entities WHERE file LIKE ? ORDER BY name",
+                               (self.system_dir + '%',))
+        self.assertEqual([tuple(row) for row in self.db.cursor.fetchall()], [('Base', 1), ('sys', 1)])
+
+        # Both classes still reference the same, never replaced, placeholder
+        base_uuid = next(e.uuid for e in placeholders if e.name == 'Base')
+        self.db.cursor.execute("SELECT class_name, base_uuid FROM inheritance ORDER BY class_name")
+        self.assertEqual([tuple(row) for row in self.db.cursor.fetchall()], [('A', base_uuid), ('B', base_uuid)])
+
+
+if __name__ == '__main__':
+    unittest.main()
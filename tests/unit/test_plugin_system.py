@@ -322,6 +322,216 @@ class ErrorDetector(FeatureDetector):
         )
         # Should not crash, but not detect any features
         self.assertEqual(len(result["features"]), 0)
+
+    def test_interest_filters(self):
+        """Test that declared interest filters keep detect() from being called"""
+        from clang.cindex import CursorKind
+        calls = []
+
+        class FilteredDetector(FeatureDetector):
+            cursor_kinds = [CursorKind.CLASS_DECL, "STRUCT_DECL"]
+            required_tokens = ["myMacro"]
+            path_globs = ["*/src/*.H"]
+
+            def __init__(self):
+                super().__init__("filtered_feature", "TEST", "Filtered feature")
+
+            def detect(self, cursor, token_spellings, token_str, available_cursor_kinds):
+                calls.append(cursor.spelling)
+                return True
+
+        class UnfilteredDetector(FeatureDetector):
+            def __init__(self):
+                super().__init__("unfiltered_feature", "TEST", "Unfiltered feature")
+
+            def detect(self, cursor, token_spellings, token_str, available_cursor_kinds):
+                return True
+
+        self.plugin_manager.register_detector(FilteredDetector())
+        self.plugin_manager.register_detector(UnfilteredDetector())
+
+        location = MagicMock()
+        location.file.name = "/project/src/model.H"
+        other_location = MagicMock()
+        other_location.file.name = "/project/tests/model.H"
+
+        result = self.plugin_manager.detect_features(
+            MockCursor(CursorKind.CLASS_DECL, "match", location), ["myMacro"], "myMacro ( )", [])
+        self.assertEqual(result["features"], {"filtered_feature", "unfiltered_feature"})
+        result = self.plugin_manager.detect_features(
+            MockCursor(CursorKind.STRUCT_DECL, "match_struct", location), ["myMacro"], "myMacro ( )", [])
+        self.assertIn("filtered_feature", result["features"])
+
+        result = self.plugin_manager.detect_features(
+            MockCursor(CursorKind.FUNCTION_DECL, "wrong_kind", location), ["myMacro"], "myMacro ( )", [])
+        self.assertEqual(result["features"], {"unfiltered_feature"})
+        result = self.plugin_manager.detect_features(
+            MockCursor(CursorKind.CLASS_DECL, "no_token", location), ["other"], "other", [])
+        self.assertEqual(result["features"], {"unfiltered_feature"})
+        result = self.plugin_manager.detect_features(
+            MockCursor(CursorKind.CLASS_DECL, "wrong_path", other_location), ["myMacro"], "myMacro ( )", [])
+        self.assertEqual(result["features"], {"unfiltered_feature"})
+        self.assertEqual(calls, ["match", "match_struct"])
+
+    def test_deferred_results(self):
+        """Test that deferred detector results are resolved in one batch"""
+        batches = []
+
+        class DeferringDetector(FeatureDetector):
+            entity_fields = {
+                "batched_value": {"type": "TEXT", "description": "Value resolved in a batch"}
+            }
+
+            def __init__(self):
+                super().__init__("deferring_feature", "TEST", "Deferring feature")
+
+            def detect(self, cursor, token_spellings, token_str, available_cursor_kinds):
+                return {'detected': False, 'fields': {'batched_value': ''}, 'deferred': cursor.spelling}
+
+            def resolve_deferred(self, keys):
+                batches.append(list(keys))
+                return {key: {'detected': key != "skip", 'fields': {'batched_value': key.upper()}}
+                        for key in keys}
+
+        self.plugin_manager.register_detector(DeferringDetector())
+        pending = []
+        for spelling in ["first", "skip", "first"]:
+            result = self.plugin_manager.detect_features(MockCursor(spelling=spelling), [], "", [])
+            self.assertEqual(result["features"], set())
+            self.assertEqual(result["custom_fields"], {"batched_value": ""})
+            pending.extend(result["deferred"])
+
+        resolved = self.plugin_manager.resolve_deferred(pending)
+        self.assertEqual(batches, [["first", "skip"]])
+        self.assertEqual(resolved[("deferring_feature", "first")]["features"], {"deferring_feature"})
+        self.assertEqual(resolved[("deferring_feature", "first")]["custom_fields"], {"batched_value": "FIRST"})
+        self.assertEqual(resolved[("deferring_feature", "skip")]["features"], set())
+        
+    def test_out_of_process_plugin(self):
+        """Test running a plugin in the helper process pool on cursor snapshots"""
+        plugin_path = os.path.join(self.plugin_dir.name, "remote_plugin.py")
+        with open(plugin_path, "w") as f:
+            f.write("""
+import os
+from foamcd.feature_detectors import FeatureDetector
+
+class RemoteDetector(FeatureDetector):
+    entity_fields = {
+        "remote_pid": {"type": "INTEGER", "description": "Process that ran the detector"},
+        "remote_name": {"type": "TEXT", "description": "Snapshot spelling"}
+    }
+
+    def __init__(self):
+        super().__init__("remote_feature", "TEST", "Remote feature")
+
+    def detect(self, cursor, token_spellings, token_str, available_cursor_kinds):
+        return {'detected': 'remote' in token_spellings,
+                'fields': {'remote_pid': os.getpid(), 'remote_name': cursor.spelling}}
+""")
+        manager = PluginManager([self.plugin_dir.name], {"out_of_process": ["remote_feature"], "host_processes": 1})
+        manager.discover_plugins()
+        self.addCleanup(manager.shutdown)
+        self.assertIn("remote_feature", manager.detectors)
+
+        pending = []
+        for spelling, tokens in [("first", ["remote"]), ("second", ["local"])]:
+            result = manager.detect_features(MockCursor(spelling=spelling), tokens, " ".join(tokens), [])
+            self.assertEqual(result["features"], set())
+            pending.extend(result["deferred"])
+        self.assertEqual(len(pending), 2)
+
+        resolved = manager.resolve_deferred(pending)
+        first, second = (resolved[item] for item in pending)
+        self.assertEqual(first["features"], {"remote_feature"})
+        self.assertEqual(second["features"], set())
+        self.assertEqual(first["custom_fields"]["remote_name"], "first")
+        self.assertNotEqual(first["custom_fields"]["remote_pid"], os.getpid())
+        
+    def test_per_call_budget_interrupts_and_disables(self):
+        """Test that a pathological detector is interrupted and then skipped"""
+        import re
+
+        class BacktrackingDetector(FeatureDetector):
+            def __init__(self):
+                super().__init__("backtracking_feature", "TEST", "Catastrophic backtracking")
+
+            def detect(self, cursor, token_spellings, token_str, available_cursor_kinds):
+                return re.search(r'(a+)+b', token_str) is not None
+
+        manager = PluginManager([], {"budgets": {"per_call_ms": 50}})
+        manager.register_detector(BacktrackingDetector())
+        result = manager.detect_features(MockCursor(), [], "a" * 40, [])
+        self.assertEqual(result["features"], set())
+        stats = manager.get_run_stats()["backtracking_feature"]
+        self.assertEqual(stats["state"], "disabled")
+        self.assertEqual(stats["timeouts"], 1)
+        self.assertLess(stats["total_time"], 5)
+
+        manager.detect_features(MockCursor(), [], "ab", [])
+        self.assertEqual(manager.get_run_stats()["backtracking_feature"]["skipped"], 1)
+
+    def test_per_call_budget_not_swallowed(self):
+        """Test that a detector catching every Exception is still interrupted"""
+        import time
+
+        class GuardedDetector(FeatureDetector):
+            def __init__(self):
+                super().__init__("guarded_feature", "TEST", "Guarded feature")
+
+            def detect(self, cursor, token_spellings, token_str, available_cursor_kinds):
+                give_up = time.monotonic() + 2
+                while time.monotonic() < give_up:
+                    try:
+                        time.sleep(0.01)
+                    except Exception:
+                        pass
+                return True
+
+        manager = PluginManager([], {"budgets": {"per_call_ms": 50}})
+        manager.register_detector(GuardedDetector())
+        result = manager.detect_features(MockCursor(), [], "guarded", [])
+        self.assertEqual(result["features"], set())
+        stats = manager.get_run_stats()["guarded_feature"]
+        self.assertEqual((stats["state"], stats["timeouts"], stats["errors"]), ("disabled", 1, 0))
+        self.assertLess(stats["total_time"], 1)
+
+    def test_budget_sampling(self):
+        """Test sampling of an overrunning detector and the run budget"""
+        import time
+        calls = []
+
+        class SlowDetector(FeatureDetector):
+            def __init__(self):
+                super().__init__("slow_feature", "TEST", "Slow feature")
+
+            def detect(self, cursor, token_spellings, token_str, available_cursor_kinds):
+                calls.append(token_str)
+                time.sleep(0.02)
+                return True
+
+        manager = PluginManager([], {"budgets": {"per_call_ms": 10, "action": "sample", "sample_every": 3}})
+        manager.register_detector(SlowDetector())
+        with patch("foamcd.plugin_system._call_deadline") as deadline:
+            deadline.return_value.__enter__.return_value = None
+            deadline.return_value.__exit__.return_value = False
+            manager.detect_features(MockCursor(), [], "first", [])
+            self.assertEqual(manager.get_run_stats()["slow_feature"]["state"], "sampled")
+            for i in range(3):
+                manager.detect_features(MockCursor(), [], f"sampled{i}", [])
+        # Only every third cursor is run; overrunning again while sampled disables it
+        self.assertEqual(calls, ["first", "sampled2"])
+        stats = manager.get_run_stats()["slow_feature"]
+        self.assertEqual(stats["state"], "disabled")
+        self.assertEqual(stats["skipped"], 2)
+
+        manager = PluginManager([], {"budgets": {"per_run_s": 0.03}})
+        manager.register_detector(SlowDetector())
+        for _ in range(4):
+            manager.detect_features(MockCursor(), [], "run", [])
+        stats = manager.get_run_stats()["slow_feature"]
+        self.assertEqual(stats["state"], "disabled")
+        self.assertEqual(stats["calls"], 2)
+        self.assertEqual(stats["skipped"], 2)
         
     def test_integration_with_database(self):
         """Test integration with the entity database (needs to be mocked)"""
@@ -0,0 +1,135 @@
+#!/usr/bin/env python3
+
+import unittest
+import sys
+import os
+import shutil
+import sqlite3
+import tempfile
+from pathlib import Path
+from unittest.mock import patch
+sys.path.append(str(Path(__file__).parent.parent.parent / "src"))
+from foamcd.logs import setup_logging
+
+logger = setup_logging(verbose=True).getChild('test.run_journal')
+
+from foamcd.db import EntityDatabase
+from foamcd.parse import ClangParser, LIBCLANG_CONFIGURED
+
+
+class TestAtomicWrites(unittest.TestCase):
+    """Test cases for atomic blocks of database writes"""
+
+    def setUp(self):
+        self.temp_dir = tempfile.mkdtemp()
+        self.db_path = os.path.join(self.temp_dir, "docs.db")
+        self.db = EntityDatabase(self.db_path)
+
+    def tearDown(self):
+        self.db.close()
+        shutil.rmtree(self.temp_dir)
+
+    def _tracked(self):
+        # Read through a separate connection, which only sees committed writes
+        conn = sqlite3.connect(self.db_path)
+        try:
+            return sorted(row[0] for row in conn.execute("SELECT path FROM files"))
+        finally:
+            conn.close()
+
+    def test_commit_at_end(self):
+        """Writes of an atomic block are committed together when it ends"""
+        with self.db.atomic():
+            self.db.track_file("/src/a.C", 1, "x")
+            with self.db.atomic():
+                self.db.track_file("/src/b.C", 1, "y")
+            self.assertEqual(self._tracked(), [])
+        self.assertEqual(self._tracked(), ["/src/a.C", "/src/b.C"])
+
+    def test_failed_write_voids_block(self):
+        """A write rolled back inside the block discards the block's other writes"""
+        with self.assertRaises(sqlite3.Error):
+            with self.db.atomic():
+                self.db.track_file("/src/a.C", 1, "x")
+                self.db.conn.rollback()
+                self.db.track_file("/src/b.C", 1, "y")
+        self.assertEqual(self._tracked(), [])
+        with self.assertRaises(ValueError):
+            with self.db.atomic():
+                self.db.track_file("/src/a.C", 1, "x")
+                raise ValueError()
+        self.assertEqual(self._tracked(), [])
+        self.db.track_file("/src/c.C", 1, "z")
+        self.assertEqual(self._tracked(), ["/src/c.C"])
+
+    def test_interrupted_run(self):
+        """Runs which did not complete list their files left to parse, in order"""
+        run_id = self.db.begin_run("2026-01-01T00:00:00", ["/src/b.C", "/src/a.C", "/src/c.C"])
+        self.db.journal_tu(run_id, "/src/b.C", "done")
+        self.db.journal_tu(run_id, "/src/c.C", "failed")
+        run = self.db.get_interrupted_run()
+        self.assertEqual((run['run_id'], run['status'], run['pending']), (run_id, 'parsing', ["/src/a.C"]))
+        self.db.set_run_status(run_id, 'resolving')
+        self.assertEqual(self.db.get_interrupted_run()['pending'], ["/src/a.C"])
+        self.db.set_run_status(run_id, 'complete')
+        self.assertIsNone(self.db.get_interrupted_run())
+
+
+@unittest.skipIf(not LIBCLANG_CONFIGURED, "libclang is not configured")
+class TestJournaledParse(unittest.TestCase):
+    """Test cases for parse runs committing each file with its journal record"""
+
+    def setUp(self):
+        self.temp_dir = tempfile.mkdtemp()
+        self.files = []
+        for name in ['a', 'b']:
+            path = os.path.join(self.temp_dir, f"{name}.C")
+            with open(path, 'w') as f:
+                f.write(f"namespace {name} {{ class X {{}}; }}\n")
+            self.files.append(path)
+        self.db = EntityDatabase(os.path.join(self.temp_dir, "docs.db"))
+        self.parser = ClangParser(db=self.db, disable_plugins=True, use_tree_sitter_fallback=False)
+        self.parser.run_id = self.db.begin_run("2026-01-01T00:00:00", self.files)
+
+    def tearDown(self):
+        self.db.close()
+        shutil.rmtree(self.temp_dir)
+
+    def test_crash_while_storing(self):
+        """A file whose entities could not all be stored stays pending, with none of them kept"""
+        self.parser.parse_lanes([[self.files[0]]])
+        original_store = self.db.store_entity
+
+        def crashing_store(entity):
+            original_store(entity)
+            if entity['name'] == 'X':
+                raise sqlite3.OperationalError("disk I/O error")
+
+        with patch.object(self.db, 'store_entity', side_effect=crashing_store):
+            self.parser.parse_lanes([[self.files[1]]])
+        self.assertEqual(self.db.get_interrupted_run()['pending'], [self.files[1]])
+        self.assertEqual(self.db.get_entities_by_file(os.path.realpath(self.files[1])), [])
+
+        # Resuming parses it again, although its content did not change
+        self.parser.parse_lanes([self.db.get_interrupted_run()['pending']])
+        self.assertEqual(self.db.get_interrupted_run()['pending'], [])
+        names = [e['name'] for e in self.db.get_entities_by_file(os.path.realpath(self.files[1]))]
+        self.assertEqual(names, ['b'])
+
+    def test_parse_failure(self):
+        """A file libclang fails on, without a fallback, is marked failed and not retried"""
+        with patch('clang.cindex.Index.parse', side_effect=RuntimeError("libclang failed")):
+            self.parser.parse_lanes([[self.files[0]]])
+        self.assertEqual(self.db.get_interrupted_run()['pending'], [self.files[1]])
+        self.db.cursor.execute("SELECT status FROM run_journal WHERE path = ?", (self.files[0],))
+        self.assertEqual(self.db.cursor.fetchone()[0], 'failed')
+
+        # So is a file with compilation errors
+        with open(self.files[1], 'w') as f:
+            f.write("namespace b { class X { undeclared_type member; }; }\n")
+        self.parser.parse_lanes([[self.files[1]]])
+        self.assertEqual(self.db.get_interrupted_run()['pending'], [])
+
+
+if __name__ == '__main__':
+    unittest.main()
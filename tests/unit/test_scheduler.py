@@ -0,0 +1,101 @@
+#!/usr/bin/env python3
+
+import unittest
+import sys
+import os
+import shutil
+import tempfile
+from pathlib import Path
+sys.path.append(str(Path(__file__).parent.parent.parent / "src"))
+from foamcd.logs import setup_logging
+
+logger = setup_logging(verbose=True).getChild('test.scheduler')
+
+from foamcd.db import EntityDatabase
+from foamcd.parse import ClangParser, LIBCLANG_CONFIGURED
+from foamcd.scheduler import schedule_translation_units, estimate_durations
+
+
+def history_entry(duration, includes=()):
+    return {'duration': duration, 'includes': set(includes)}
+
+
+class TestScheduler(unittest.TestCase):
+    """Test cases for the cost-model translation unit scheduler"""
+
+    def test_longest_first_balance(self):
+        """Files go longest first to the least loaded lane"""
+        history = {f"/src/{name}.C": history_entry(duration)
+                   for name, duration in [('a', 5), ('b', 4), ('c', 3), ('d', 3), ('e', 2), ('f', 2), ('g', 1)]}
+        schedule = schedule_translation_units(sorted(history), history, lanes=2)
+        self.assertEqual(schedule.lanes, [
+            ['/src/a.C', '/src/d.C', '/src/f.C'],
+            ['/src/b.C', '/src/c.C', '/src/e.C', '/src/g.C']
+        ])
+        self.assertEqual(schedule.predicted_makespan, 10)
+        self.assertEqual(len(schedule), 7)
+
+    def test_include_affinity(self):
+        """Among equally loaded lanes, files join the lane which parsed their headers"""
+        history = {
+            '/src/a.C': history_entry(4, ['/src/fv.H']),
+            '/src/b.C': history_entry(4, ['/src/mesh.H']),
+            '/src/c.C': history_entry(2, ['/src/mesh.H', '/src/x.H']),
+            '/src/d.C': history_entry(2, ['/src/fv.H']),
+        }
+        schedule = schedule_translation_units(sorted(history), history, lanes=2)
+        self.assertEqual(schedule.lanes, [['/src/a.C', '/src/d.C'], ['/src/b.C', '/src/c.C']])
+        # Affinity never costs more than the slack
+        schedule = schedule_translation_units(sorted(history), history, lanes=2, affinity_slack=0)
+        self.assertEqual(schedule.predicted_makespan, 6)
+
+    def test_unknown_files(self):
+        """Files without history are expected to cost the median known duration"""
+        history = {'/src/a.C': history_entry(1), '/src/b.C': history_entry(3), '/src/c.C': history_entry(8)}
+        durations = estimate_durations(['/src/a.C', '/src/new.C'], history)
+        self.assertEqual(durations, {'/src/a.C': 1, '/src/new.C': 3})
+        self.assertEqual(estimate_durations(['/src/new.C'], {}), {'/src/new.C': 1.0})
+
+
+@unittest.skipIf(not LIBCLANG_CONFIGURED or not hasattr(os, 'fork'), "needs libclang and fork()")
+class TestParseLanes(unittest.TestCase):
+    """Test cases for parsing scheduled lanes in forked processes"""
+
+    def setUp(self):
+        self.temp_dir = tempfile.mkdtemp()
+        with open(os.path.join(self.temp_dir, "shared.H"), 'w') as f:
+            f.write("namespace shared { class S {}; }\n")
+        self.files = []
+        for name in ['a', 'b', 'c']:
+            path = os.path.join(self.temp_dir, f"{name}.C")
+            with open(path, 'w') as f:
+                f.write(f'#include "shared.H"\nnamespace {name} {{ class X {{}}; }}\n')
+            self.files.append(path)
+        self.db = EntityDatabase(os.path.join(self.temp_dir, "docs.db"))
+        self.parser = ClangParser(db=self.db, disable_plugins=True, use_tree_sitter_fallback=False)
+
+    def tearDown(self):
+        self.db.close()
+        shutil.rmtree(self.temp_dir)
+
+    def test_lanes_record_history(self):
+        """Lanes store their entities, parse durations and include sets"""
+        parsed, errors, durations = self.parser.parse_lanes([self.files[:2], [self.files[2]]])
+        self.assertEqual((parsed, errors), (3, 0))
+        self.assertTrue(all(duration is not None for duration in durations))
+        history = self.db.get_tu_history()
+        shared = os.path.realpath(os.path.join(self.temp_dir, "shared.H"))
+        for path in self.files:
+            record = history[os.path.realpath(path)]
+            self.assertEqual((record['status'], record['route']), ('ok', 'libclang'))
+            self.assertGreater(record['duration'], 0)
+            # Lanes parse in-process, and record the RSS each file's parse added
+            self.assertIsNotNone(record['peak_rss_kb'])
+            self.assertGreaterEqual(record['peak_rss_kb'], 0)
+            self.assertEqual(record['includes'], {shared})
+            names = {entity['name'] for entity in self.db.get_entities_by_file(os.path.realpath(path))}
+            self.assertIn(Path(path).stem, names)
+
+
+if __name__ == '__main__':
+    unittest.main()
@@ -0,0 +1,208 @@
+#!/usr/bin/env python3
+
+import unittest
+import sys
+import os
+import shutil
+import tempfile
+import hashlib
+from pathlib import Path
+sys.path.append(str(Path(__file__).parent.parent.parent / "src"))
+from foamcd.logs import setup_logging
+
+logger = setup_logging(verbose=True).getChild('test.shard')
+
+from foamcd.db import EntityDatabase
+from foamcd.parse import ClangParser, LIBCLANG_CONFIGURED, drop_reassigned_shard_files
+from foamcd.scheduler import parse_shard_spec, shard_database_path, select_shard
+from foamcd.merge import merge_shards
+
+
+class TestShardSelection(unittest.TestCase):
+    """Test cases for partitioning a run into shards"""
+
+    def setUp(self):
+        self.files = [f"/src/file{i}.C" for i in range(40)]
+
+    def test_partition(self):
+        """Shards cover every file exactly once, whatever the input order"""
+        shards = [select_shard(self.files, i, 4) for i in range(4)]
+        self.assertEqual(sorted(sum(shards, [])), sorted(self.files))
+        self.assertTrue(all(shards))
+        self.assertEqual(select_shard(list(reversed(self.files)), 2, 4), shards[2])
+
+    def test_cost_balanced(self):
+        """With a parse history, shards are balanced by recorded cost"""
+        history = {path: {'duration': float(i), 'includes': set()} for i, path in enumerate(self.files)}
+        shards = [select_shard(self.files, i, 3, history) for i in range(3)]
+        self.assertEqual(sorted(sum(shards, [])), sorted(self.files))
+        loads = [sum(history[path]['duration'] for path in shard) for shard in shards]
+        self.assertLessEqual(max(loads) - min(loads), 39)
+
+    def test_spec(self):
+        """Shard specifications are checked, and name the shard's database"""
+        self.assertEqual(parse_shard_spec("3/8"), (3, 8))
+        for spec in ["8/8", "-1/2", "1", "a/b", "0/0"]:
+            with self.assertRaises(ValueError):
+                parse_shard_spec(spec)
+        self.assertEqual(shard_database_path("/out/docs.db", 3, 8), "/out/docs.shard-3-of-8.db")
+
+
+class TestMergeDatabase(unittest.TestCase):
+    """Test cases for copying the rows of shard databases"""
+
+    def setUp(self):
+        self.temp_dir = tempfile.mkdtemp()
+
+    def tearDown(self):
+        shutil.rmtree(self.temp_dir)
+
+    def test_detector_run_stats_add_up(self):
+        """Detector statistics of shards started in the same second are added up"""
+        merged = EntityDatabase(os.path.join(self.temp_dir, "docs.db"))
+        for i, (calls, max_call_time, state) in enumerate([(10, 0.5, 'active'), (4, 2.0, 'disabled')]):
+            shard = EntityDatabase(os.path.join(self.temp_dir, f"shard{i}.db"))
+            shard.store_detector_run_stats('2026-01-01T00:00:00', {'openfoam': {
+                'calls': calls, 'skipped': i, 'timeouts': i, 'errors': 1, 'total_time': 1.0,
+                'max_call_time': max_call_time, 'state': state, 'reason': 'per call' if i else None}})
+            shard.close()
+            merged.merge_database(os.path.join(self.temp_dir, f"shard{i}.db"))
+        merged.cursor.execute("SELECT calls, skipped, timeouts, errors, total_time, max_call_time, state, reason "
+                              "FROM detector_run_stats")
+        self.assertEqual([tuple(row) for row in merged.cursor.fetchall()],
+                         [(14, 1, 1, 2, 2.0, 2.0, 'disabled', 'per call')])
+        merged.close()
+
+
+@unittest.skipIf(not LIBCLANG_CONFIGURED, "libclang is not configured")
+class TestMergeShards(unittest.TestCase):
+    """Test cases for merging shard databases"""
+
+    def setUp(self):
+        self.temp_dir = tempfile.mkdtemp()
+        with open(os.path.join(self.temp_dir, "base.H"), 'w') as f:
+            f.write("namespace ns { class Base { public: virtual ~Base(); }; }\n")
+        sources = {
+            'a.C': '#include "base.H"\nnamespace ns { class A : public Base { public: typedef int label; }; }\n',
+            'b.C': '#include "base.H"\nnamespace ns { class B : public Base {}; }\n',
+        }
+        self.files = []
+        for name, content in sources.items():
+            path = os.path.join(self.temp_dir, name)
+            with open(path, 'w') as f:
+                f.write(content)
+            self.files.append(path)
+
+    def tearDown(self):
+        shutil.rmtree(self.temp_dir)
+
+    def _parse(self, db_path, files, resolve):
+        db = EntityDatabase(db_path)
+        parser = ClangParser(db=db, disable_plugins=True, use_tree_sitter_fallback=False)
+        for path in files:
+            parser.parse_file(path)
+        if resolve:
+            parser.resolve_scoped_template_functions()
+            parser.resolve_inheritance_relationships()
+            parser.resolve_enclosing_relationships()
+        return db
+
+    def _rows(self, db, table, columns):
+        db.cursor.execute(f"SELECT {columns} FROM {table}")
+        return sorted(tuple(row) for row in db.cursor.fetchall())
+
+    def test_merge_matches_single_run(self):
+        """Merged shards hold the same entities and relationships as a single run"""
+        single = self._parse(os.path.join(self.temp_dir, "single.db"), self.files, resolve=True)
+        shard_paths = []
+        for i, path in enumerate(self.files):
+            shard_path = shard_database_path(os.path.join(self.temp_dir, "docs.db"), i, 2)
+            self._parse(shard_path, [path], resolve=False).close()
+            shard_paths.append(shard_path)
+        merged = merge_shards(os.path.join(self.temp_dir, "docs.db"), shard_paths)
+
+        for table, columns in [('entities', 'uuid, name, parent_uuid'),
+                               ('inheritance', 'class_uuid, base_uuid'),
+                               ('class_member_types', 'class_uuid, name, underlying_type'),
+                               ('files', 'path')]:
+            self.assertEqual(self._rows(merged, table, columns), self._rows(single, table, columns), table)
+        merged.cursor.execute("SELECT COUNT(*) FROM inheritance WHERE base_uuid IS NULL")
+        self.assertEqual(merged.cursor.fetchone()[0], 0)
+        # Base-child links are rebuilt from the merged inheritance
+        self.assertEqual(self._rows(merged, 'base_child_links', 'base_uuid, child_uuid'),
+                         self._rows(merged, 'inheritance', 'base_uuid, class_uuid'))
+        single.close()
+        merged.close()
+
+    def test_remerge_replaces_output(self):
+        """Merging the shards of a later run keeps nothing of the earlier merge"""
+        output = os.path.join(self.temp_dir, "docs.db")
+        shard_paths = [shard_database_path(output, i, 2) for i in range(2)]
+
+        def run_shards():
+            for shard_path, path in zip(shard_paths, self.files):
+                db = self._parse(shard_path, [path], resolve=False)
+                db.store_run_metrics('2026-01-01T00:00:00', 'parse', [
+                    {'phase': 'traverse', 'subject': path, 'pid': 1, 'seconds': 0.1, 'rss_kb': 100,
+                     'rss_delta_kb': 0, 'peak_rss_kb': 100, 'peak_rss_growth_kb': 0,
+                     'py_delta_kb': 0, 'py_peak_kb': 0}], [])
+                db.close()
+            return merge_shards(output, shard_paths)
+
+        run_shards().close()
+        # Class A is renamed, B removed, in the next run
+        with open(self.files[0], 'w') as f:
+            f.write('#include "base.H"\nnamespace ns { class Renamed : public Base {}; }\n')
+        with open(self.files[1], 'w') as f:
+            f.write('#include "base.H"\n')
+        merged = run_shards()
+        names = {row[0] for row in self._rows(merged, 'entities', 'name')}
+        self.assertIn('Renamed', names)
+        self.assertNotIn('A', names)
+        self.assertNotIn('B', names)
+        # File hashes and parse costs are those of the later run
+        for shard_path in shard_paths:
+            shard = EntityDatabase(shard_path)
+            for table in ('files', 'tu_stats'):
+                shard_rows = self._rows(shard, table, 'path, hash')
+                self.assertTrue(set(shard_rows) <= set(self._rows(merged, table, 'path, hash')), table)
+            shard.close()
+        self.assertEqual(len(merged.get_run_metrics()), 2)
+        self.assertFalse(os.path.exists(f"{output}.merging"))
+        merged.close()
+
+    def test_file_moving_between_shards(self):
+        """A file rebalanced onto another shard and edited is merged from its new shard only"""
+        output = os.path.join(self.temp_dir, "docs.db")
+        shard_paths = [shard_database_path(output, i, 2) for i in range(2)]
+        a, b = self.files
+
+        def run_shards(assignment):
+            for shard_path, files in zip(shard_paths, assignment):
+                db = EntityDatabase(shard_path)
+                drop_reassigned_shard_files(db, files)
+                db.close()
+                self._parse(shard_path, files, resolve=False).close()
+            return merge_shards(output, shard_paths)
+
+        run_shards([[a, b], []]).close()
+        with open(a, 'w') as f:
+            f.write('#include "base.H"\nnamespace ns { class Renamed : public Base {}; }\n')
+        merged = run_shards([[b], [a]])
+        names = {row[0] for row in self._rows(merged, 'entities', 'name')}
+        self.assertIn('Renamed', names)
+        self.assertNotIn('A', names)
+        self.assertIn('B', names)
+        with open(a, 'rb') as f:
+            new_hash = hashlib.md5(f.read()).hexdigest()
+        merged.cursor.execute("SELECT hash FROM files WHERE path = ?", (a,))
+        self.assertEqual([row[0] for row in merged.cursor.fetchall()], [new_hash])
+        merged.close()
+        shard = EntityDatabase(shard_paths[0])
+        self.assertEqual(shard.get_all_files(), [b])
+        self.assertEqual(set(shard.get_tu_history()), {os.path.realpath(b)})
+        shard.close()
+
+
+if __name__ == '__main__':
+    unittest.main()
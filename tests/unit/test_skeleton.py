@@ -0,0 +1,120 @@
+#!/usr/bin/env python3
+
+import unittest
+import sys
+import os
+import shutil
+import tempfile
+from pathlib import Path
+sys.path.append(str(Path(__file__).parent.parent.parent / "src"))
+from foamcd.logs import setup_logging
+
+logger = setup_logging(verbose=True).getChild('test.skeleton')
+
+from foamcd.db import EntityDatabase
+from foamcd.parse import ClangParser, LIBCLANG_CONFIGURED, with_sibling_headers
+from foamcd.tree_sitter_subparser import is_tree_sitter_available
+
+SOURCE = """namespace ns {
+struct B {};
+/** A class */
+class A : public B {
+public:
+    A();
+    virtual void f() const = 0;
+    int x = 3;
+    static int y;
+    template<class T> void g(T t) {}
+    struct Inner { int z; };
+};
+}
+"""
+
+
+def skeleton_entry(kind, name, line, column, end_line, end_column, children=(), **extra):
+    entry = {
+        "kind": kind, "name": name, "namespace": "ns", "access": "PUBLIC", "doc_comment": "",
+        "line": line, "column": column, "end_line": end_line, "end_column": end_column,
+        "children": list(children)
+    }
+    entry.update(extra)
+    return entry
+
+
+# What the tree-sitter skeleton pass extracts from SOURCE
+EXPECTED_SKELETON = [skeleton_entry("NAMESPACE", "ns", 1, 1, 13, 2, [
+    skeleton_entry("STRUCT_DECL", "B", 2, 1, 2, 12, access=None),
+    skeleton_entry("CLASS_DECL", "A", 4, 1, 12, 2, [
+        skeleton_entry("CONSTRUCTOR", "A", 6, 5, 6, 8),
+        skeleton_entry("CXX_METHOD", "f", 7, 5, 7, 31, is_virtual=True, is_pure_virtual=True),
+        skeleton_entry("FIELD_DECL", "x", 8, 5, 8, 14),
+        skeleton_entry("VAR_DECL", "y", 9, 5, 9, 17, is_static=True),
+        skeleton_entry("FUNCTION_TEMPLATE", "g", 10, 5, 10, 37),
+        skeleton_entry("STRUCT_DECL", "Inner", 11, 5, 11, 28, [
+            skeleton_entry("FIELD_DECL", "z", 11, 20, 11, 25)
+        ], enclosed=True),
+    ], access=None, doc_comment="/** A class */", is_abstract=True,
+       bases=[{"name": "B", "access": "PUBLIC", "virtual": False}]),
+], namespace=None, access=None)]
+
+
+def strip_skeleton(entries, keys):
+    return [{key: entry.get(key) for key in keys} | {"children": strip_skeleton(entry["children"], keys)}
+            for entry in entries]
+
+
+@unittest.skipIf(not LIBCLANG_CONFIGURED, "libclang is not configured")
+class TestSkeleton(unittest.TestCase):
+    """Test cases for the quick tree-sitter skeleton pass"""
+
+    def setUp(self):
+        self.temp_dir = tempfile.mkdtemp()
+        self.header = os.path.join(self.temp_dir, "a.H")
+        with open(self.header, 'w') as f:
+            f.write(SOURCE)
+        self.db = EntityDatabase(os.path.join(self.temp_dir, "docs.db"))
+        self.parser = ClangParser(db=self.db, disable_plugins=True)
+
+    def tearDown(self):
+        self.db.close()
+        shutil.rmtree(self.temp_dir)
+
+    def _entities(self):
+        self.db.cursor.execute("SELECT uuid, name, is_skeleton FROM entities")
+        return {row[0]: (row[1], row[2]) for row in self.db.cursor.fetchall()}
+
+    @unittest.skipIf(not is_tree_sitter_available(), "tree-sitter is not available")
+    def test_extract_skeleton(self):
+        """Skeleton entries carry libclang-compatible kinds and extents"""
+        keys = ["kind", "name", "line", "column", "end_line", "end_column", "access", "namespace"]
+        skeleton = self.parser.tree_sitter_subparser.extract_skeleton(self.header)
+        self.assertEqual(strip_skeleton(skeleton, keys), strip_skeleton(EXPECTED_SKELETON, keys))
+
+    def test_full_parse_replaces_skeleton(self):
+        """A libclang parse takes over skeleton rows in place and drops leftovers"""
+        leftover = skeleton_entry("CXX_METHOD", "removed", 5, 1, 5, 8)
+        skeleton = [dict(EXPECTED_SKELETON[0])]
+        skeleton[0]["children"] = EXPECTED_SKELETON[0]["children"] + [leftover]
+        self.parser._store_skeletons([(os.path.realpath(self.header), skeleton)])
+        skeleton_rows = self._entities()
+        self.assertEqual(len(skeleton_rows), 11)
+        self.assertTrue(all(is_skeleton for _, is_skeleton in skeleton_rows.values()))
+        self.assertTrue(self.db.get_entities_by_file(os.path.realpath(self.header)))
+        self.assertFalse(self.db.has_parsed_entities(os.path.realpath(self.header)))
+
+        self.parser.parse_file(self.header)
+        parsed_rows = self._entities()
+        self.assertFalse(any(is_skeleton for _, is_skeleton in parsed_rows.values()))
+        kept = sorted(name for uuid, (name, _) in skeleton_rows.items() if uuid in parsed_rows)
+        self.assertEqual(kept, ["A", "A", "A::Inner", "B", "f", "g", "ns", "x", "y", "z"])
+        self.assertTrue(self.db.has_parsed_entities(os.path.realpath(self.header)))
+
+    def test_sibling_headers(self):
+        """Quick mode indexes the headers next to the target files"""
+        source = os.path.join(self.temp_dir, "a.C")
+        Path(source).touch()
+        self.assertEqual(with_sibling_headers([source]), [source, self.header])
+
+
+if __name__ == '__main__':
+    unittest.main()
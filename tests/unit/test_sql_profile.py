@@ -0,0 +1,89 @@
+#!/usr/bin/env python3
+
+import unittest
+import sys
+import os
+import shutil
+import tempfile
+from pathlib import Path
+sys.path.append(str(Path(__file__).parent.parent.parent / "src"))
+from foamcd.logs import setup_logging
+
+logger = setup_logging(verbose=True).getChild('test.sql_profile')
+
+from foamcd.sql_profile import normalize_statement, profiler
+from foamcd.db import EntityDatabase
+
+
+class TestSqlProfiler(unittest.TestCase):
+    """Test cases for per call site SQL statement statistics"""
+
+    def setUp(self):
+        self.temp_dir = tempfile.mkdtemp()
+        profiler.enable(report_at_exit=False)
+        self.db = EntityDatabase(os.path.join(self.temp_dir, "docs.db"))
+        for i in range(5):
+            self.db.store_entity({'uuid': f"uuid{i}", 'name': f"Class{i}", 'kind': 'CLASS_DECL',
+                                  'location': {'file': '/src/a.H', 'line': i + 1, 'column': 1,
+                                               'end_line': i + 2, 'end_column': 1}})
+        profiler.drain()
+
+    def tearDown(self):
+        self.db.close()
+        profiler.disable()
+        shutil.rmtree(self.temp_dir)
+
+    def test_normalize(self):
+        """Literals, whitespace and parameter lists are collapsed"""
+        self.assertEqual(normalize_statement("SELECT *\n  FROM entities WHERE line = 12 AND name = 'it''s'"),
+                         "SELECT * FROM entities WHERE line = ? AND name = ?")
+        self.assertEqual(normalize_statement("SELECT * FROM t1 WHERE id IN (?, ?,?)"),
+                         "SELECT * FROM t1 WHERE id IN (?, ...)")
+
+    def test_call_sites(self):
+        """Executions are grouped per statement and call site, with rows and query plans"""
+        for i in range(5):
+            self.db.get_entity_by_uuid(f"uuid{i}")
+        self.db.cursor.execute("SELECT name FROM entities WHERE line > 0")
+        names = [row[0] for row in self.db.cursor]
+        self.assertEqual(len(names), 5)
+
+        ranked = profiler.ranked(top=100)
+        by_uuid = [entry for entry in ranked if 'WHERE uuid = ?' in entry['statement']
+                   and entry['statement'].startswith('SELECT * FROM entities')]
+        self.assertEqual(len(by_uuid), 1)
+        self.assertEqual(by_uuid[0]['calls'], 5)
+        self.assertEqual(by_uuid[0]['rows'], 5)
+        self.assertIn('db.py', by_uuid[0]['site'])
+        self.assertIn('test_sql_profile.py', by_uuid[0]['site'])
+        self.assertTrue(by_uuid[0]['uses_index'])
+
+        scan = next(entry for entry in ranked if entry['statement'] == "SELECT name FROM entities WHERE line > ?")
+        self.assertEqual((scan['calls'], scan['rows']), (1, 5))
+        self.assertEqual(scan['scans'], ['entities'])
+        self.assertIn('test_call_sites', scan['site'])
+        self.assertIn('SCAN entities', profiler.report())
+
+    def test_worker_reports(self):
+        """Statistics of workers are added to those of the same statement and call site"""
+        self.db.cursor.execute("SELECT COUNT(*) FROM entities")
+        self.db.cursor.fetchone()
+        report = profiler.drain()
+        self.assertEqual(profiler.stats, {})
+        profiler.extend(report)
+        profiler.extend(report)
+        entry = profiler.ranked()[0]
+        self.assertEqual((entry['calls'], entry['rows']), (2, 2))
+
+    def test_disabled(self):
+        """Databases opened without profiling keep their plain cursor"""
+        profiler.disable()
+        db = EntityDatabase(os.path.join(self.temp_dir, "plain.db"))
+        db.cursor.execute("SELECT COUNT(*) FROM entities")
+        self.assertEqual(profiler.stats, {})
+        self.assertEqual(type(db.cursor).__name__, 'Cursor')
+        db.close()
+
+
+if __name__ == '__main__':
+    unittest.main()
@@ -0,0 +1,112 @@
+#!/usr/bin/env python3
+
+import unittest
+import sys
+import os
+import json
+import shutil
+import tempfile
+from pathlib import Path
+sys.path.append(str(Path(__file__).parent.parent.parent / "src"))
+from foamcd.logs import setup_logging
+
+logger = setup_logging(verbose=True).getChild('test.tracing')
+
+from foamcd.tracing import Tracer, tracer
+from foamcd.db import EntityDatabase
+from foamcd.parse import ClangParser, LIBCLANG_CONFIGURED
+
+
+class TestTracer(unittest.TestCase):
+    """Test cases for recording and writing trace events"""
+
+    def setUp(self):
+        self.temp_dir = tempfile.mkdtemp()
+
+    def tearDown(self):
+        shutil.rmtree(self.temp_dir)
+
+    def test_disabled(self):
+        """A disabled tracer records nothing"""
+        trace = Tracer()
+        with trace.span('phase', file='a.C') as span:
+            span.set(entities=3)
+            with trace.timed('detection'):
+                pass
+        self.assertEqual(trace.events, [])
+        self.assertEqual(trace.take_totals(), {})
+
+    def test_spans(self):
+        """Spans nest, carry their arguments and accumulated totals, and are written as a Chrome trace"""
+        trace = Tracer()
+        trace.enable()
+        with trace.span('translation unit', 'tu', file='a.C'):
+            with trace.span('traverse') as traversal:
+                for _ in range(3):
+                    with trace.timed('detection'):
+                        pass
+                traversal.set(**trace.take_totals())
+        with self.assertRaises(ValueError):
+            with trace.span('failing'):
+                raise ValueError()
+
+        spans = {event['name']: event for event in trace.events if event['ph'] == 'X'}
+        self.assertEqual(set(spans), {'translation unit', 'traverse', 'failing'})
+        outer, inner = spans['translation unit'], spans['traverse']
+        self.assertEqual(outer['args'], {'file': 'a.C'})
+        self.assertIn('detection_ms', inner['args'])
+        self.assertLessEqual(outer['ts'], inner['ts'])
+        self.assertGreaterEqual(outer['ts'] + outer['dur'], inner['ts'] + inner['dur'])
+        self.assertEqual(spans['failing']['args'], {'error': 'ValueError'})
+
+        path = os.path.join(self.temp_dir, "trace.json")
+        self.assertTrue(trace.write(path, {'command': 'test'}))
+        with open(path) as f:
+            written = json.load(f)
+        self.assertEqual(len(written['traceEvents']), len(trace.events))
+        self.assertEqual(written['otherData'], {'command': 'test'})
+
+
+@unittest.skipIf(not LIBCLANG_CONFIGURED, "libclang is not configured")
+class TestParseTrace(unittest.TestCase):
+    """Test cases for traces of parse runs"""
+
+    def setUp(self):
+        self.temp_dir = tempfile.mkdtemp()
+        self.files = []
+        for name in ['a', 'b']:
+            path = os.path.join(self.temp_dir, f"{name}.C")
+            with open(path, 'w') as f:
+                f.write(f"class {name.upper()} {{ public: int f() const {{ return 0; }} }};\n")
+            self.files.append(path)
+        tracer.enable()
+
+    def tearDown(self):
+        tracer.enabled = False
+        tracer.drain()
+        shutil.rmtree(self.temp_dir)
+
+    def test_lanes(self):
+        """Each parse lane has its own row, with the phases of its translation units"""
+        db = EntityDatabase(os.path.join(self.temp_dir, "docs.db"))
+        parser = ClangParser(db=db, disable_plugins=True, use_tree_sitter_fallback=False)
+        parser.parse_lanes([[self.files[0]], [self.files[1]]])
+        parser.resolve_inheritance_relationships()
+        db.close()
+
+        events = tracer.drain()
+        units = [event for event in events if event['name'] == 'translation unit']
+        self.assertEqual(sorted(event['args']['file'] for event in units), sorted(self.files))
+        self.assertEqual(len({event['pid'] for event in units}), 2)
+        self.assertNotIn(os.getpid(), {event['pid'] for event in units})
+        lanes = {event['args']['name'] for event in events if event['name'] == 'process_name'}
+        self.assertTrue({'parse lane 0', 'parse lane 1'} <= lanes)
+        names = {event['name'] for event in events}
+        self.assertTrue({'compile args', 'libclang parse', 'traverse', 'db write',
+                         'resolve inheritance relationships'} <= names)
+        traversal = next(event for event in events if event['name'] == 'traverse')
+        self.assertIn('detection_ms', traversal['args'])
+
+
+if __name__ == '__main__':
+    unittest.main()
@@ -0,0 +1,95 @@
+#!/usr/bin/env python3
+
+import unittest
+import sys
+import os
+import shutil
+import tempfile
+from pathlib import Path
+sys.path.append(str(Path(__file__).parent.parent.parent / "src"))
+from foamcd.logs import setup_logging
+
+logger = setup_logging(verbose=True).getChild('test.tree_sitter')
+
+from foamcd.tree_sitter_subparser import (
+    DEFINITIONS_QUERY, TYPE_REFERENCES_QUERY, TreeSitterSubparser, _compile_query, is_tree_sitter_available
+)
+
+UNIT_TESTS_FIXTURE = str(Path(__file__).parent.parent / "fixtures_unit_tests" / "unit_tests_cpp_features.cpp")
+
+
+class TestTreeSitterQueries(unittest.TestCase):
+    """Test cases for the tree-sitter queries of the fallback parser and --quick
+
+    tree-sitter is a required dependency, so these tests fail rather than skip without it:
+    a query the grammar rejects disables both the fallback and quick parsing.
+    """
+
+    def setUp(self):
+        self.assertTrue(is_tree_sitter_available(), "tree-sitter and tree-sitter-cpp must be installed")
+        self.subparser = TreeSitterSubparser()
+        self.temp_dir = tempfile.mkdtemp()
+
+    def tearDown(self):
+        shutil.rmtree(self.temp_dir)
+
+    def write(self, name: str, text: str) -> str:
+        path = os.path.join(self.temp_dir, name)
+        with open(path, 'w') as f:
+            f.write(text)
+        return path
+
+    def test_patterns_compile(self):
+        """Every pattern is accepted by the C++ grammar on its own"""
+        for query in (DEFINITIONS_QUERY, TYPE_REFERENCES_QUERY):
+            patterns = [pattern for pattern in query.strip().split("\n(") if pattern.strip()]
+            self.assertGreater(len(patterns), 1)
+            for pattern in patterns:
+                pattern = pattern if pattern.startswith("(") else "(" + pattern
+                with self.subTest(pattern=pattern):
+                    _compile_query(pattern)
+
+    def test_definitions(self):
+        """Classes, structs, functions and namespaces are extracted with their names"""
+        result = self.subparser.parse_file(self.write("definitions.C", (
+            "namespace ns {\n"
+            "class Widget { public: int x; };\n"
+            "struct Point { int y; };\n"
+            "int area(int w) { return w; }\n"
+            "}\n"
+        )))
+        self.assertEqual(sorted((info["kind"], info["name"]) for info in result["classes"]),
+                         [("class", "Widget"), ("struct", "Point")])
+        self.assertEqual([info["name"] for info in result["functions"]], ["area"])
+        self.assertEqual([info["name"] for info in result["namespaces"]], ["ns"])
+        self.assertEqual(result["classes"][0]["start_line"], 1)
+
+    def test_test_cases(self):
+        """Catch2 test cases get their description, tags and referenced types"""
+        test_cases = self.subparser.find_test_cases(UNIT_TESTS_FIXTURE)
+        self.assertGreaterEqual(len(test_cases), 7)
+        first = test_cases[0]
+        self.assertEqual(first["name"], "BaseClass and DerivedClass implementation")
+        self.assertEqual(first["tags"], "[inheritance][polymorphism]")
+        for reference in ["BaseClass", "DerivedClass", "ExtendedDerivedClass"]:
+            self.assertIn(reference, first["references"])
+        self.assertNotIn("SECTION", first["references"])
+
+    def test_constructed_types(self):
+        """Types of new-expressions and constructor calls are referenced"""
+        test_cases = self.subparser.find_test_cases(self.write("alloc.C", (
+            'TEST_CASE("Allocations", "[memory]")\n'
+            "{\n"
+            "    auto* widget = new Widget(1);\n"
+            "    auto gadget = Gadget(2);\n"
+            "    CHECK(widget);\n"
+            "}\n"
+        )))
+        self.assertEqual(len(test_cases), 1)
+        self.assertIn("Widget", test_cases[0]["references"])
+        self.assertIn("Gadget", test_cases[0]["references"])
+        self.assertNotIn("CHECK", test_cases[0]["references"])
+
+
+if __name__ == '__main__':
+    unittest.main()
@@ -0,0 +1,92 @@
+#!/usr/bin/env python3
+
+import unittest
+import sys
+import os
+import time
+import shutil
+import tempfile
+from pathlib import Path
+from unittest.mock import patch
+sys.path.append(str(Path(__file__).parent.parent.parent / "src"))
+from foamcd.logs import setup_logging
+
+logger = setup_logging(verbose=True).getChild('test.tu_budget')
+
+from omegaconf import OmegaConf
+from foamcd.config import Config
+from foamcd.db import EntityDatabase
+from foamcd.parse import ClangParser, LIBCLANG_CONFIGURED
+
+
+@unittest.skipIf(not LIBCLANG_CONFIGURED or not hasattr(os, 'fork'), "needs libclang and fork()")
+class TestTUBudget(unittest.TestCase):
+    """Test cases for supervised per-file parses"""
+
+    def setUp(self):
+        self.temp_dir = tempfile.mkdtemp()
+        self.source = os.path.join(self.temp_dir, "a.H")
+        with open(self.source, 'w') as f:
+            f.write("namespace ns { class A { int x; }; }\n")
+        self.db = EntityDatabase(os.path.join(self.temp_dir, "docs.db"))
+        config = Config()
+        OmegaConf.update(config.config, "parser.tu_budget.timeout", 1)
+        OmegaConf.update(config.config, "parser.tu_budget.memory_limit_mb", 4096)
+        self.parser = ClangParser(db=self.db, config=config, disable_plugins=True,
+                                  use_tree_sitter_fallback=False)
+
+    def tearDown(self):
+        self.db.close()
+        shutil.rmtree(self.temp_dir)
+
+    def _stats(self):
+        return self.db.get_tu_stats(os.path.realpath(self.source))
+
+    def test_within_budget(self):
+        """Entities parsed by the worker are read back from the database"""
+        entities = self.parser.parse_file(self.source)
+        self.assertEqual([entity['name'] for entity in entities], ["ns"])
+        stats = self._stats()
+        self.assertEqual((stats['status'], stats['route']), ('ok', 'libclang'))
+        self.assertGreater(stats['peak_rss_kb'], 0)
+
+    def test_unchanged_file_is_not_forked(self):
+        """Files unchanged since their last parse are read back without a worker"""
+        self.parser.parse_file(self.source)
+        with patch('os.fork', side_effect=AssertionError("forked")):
+            entities = self.parser.parse_file(self.source)
+        self.assertEqual([entity['name'] for entity in entities], ["ns"])
+
+    def test_timeout_reroutes_until_changed(self):
+        """Slow parses are killed and the file skips libclang until it changes"""
+        original_parse = self.parser.index.parse
+
+        def slow_parse(*args, **kwargs):
+            time.sleep(30)
+            return original_parse(*args, **kwargs)
+
+        started = time.monotonic()
+        with patch.object(self.parser.index, 'parse', side_effect=slow_parse):
+            self.assertEqual(self.parser.parse_file(self.source), [])
+        self.assertLess(time.monotonic() - started, 10)
+        stats = self._stats()
+        self.assertEqual((stats['status'], stats['route']), ('timeout', 'skipped'))
+
+        # No new worker for the unchanged file
+        with patch('os.fork', side_effect=AssertionError("forked")):
+            self.parser.parse_file(self.source)
+
+        with open(self.source, 'a') as f:
+            f.write("int y;\n")
+        self.assertTrue(self.parser.parse_file(self.source))
+        self.assertEqual(self._stats()['status'], 'ok')
+
+    def test_out_of_memory(self):
+        """Workers running out of memory are reported as such"""
+        with patch.object(self.parser.index, 'parse', side_effect=MemoryError):
+            self.assertEqual(self.parser.parse_file(self.source), [])
+        self.assertEqual(self._stats()['status'], 'memory')
+
+
+if __name__ == '__main__':
+    unittest.main()
@@ -0,0 +1,88 @@
+#!/usr/bin/env python3
+
+import unittest
+import sys
+import os
+import shutil
+import tempfile
+from pathlib import Path
+from unittest.mock import MagicMock
+sys.path.append(str(Path(__file__).parent.parent.parent / "src"))
+from foamcd.logs import setup_logging
+
+logger = setup_logging(verbose=True).getChild('test.tu_options')
+
+from omegaconf import OmegaConf
+from clang.cindex import TranslationUnit
+from foamcd.config import Config
+from foamcd.db import EntityDatabase
+from foamcd.parse import ClangParser, LIBCLANG_CONFIGURED
+
+
+@unittest.skipIf(not LIBCLANG_CONFIGURED, "libclang is not configured")
+class TestTUOptions(unittest.TestCase):
+    """Test cases for the per-file choice of parse options"""
+
+    def setUp(self):
+        self.temp_dir = tempfile.mkdtemp()
+        include_dir = os.path.join(self.temp_dir, "lnInclude")
+        os.mkdir(include_dir)
+        self._write(os.path.join(include_dir, "model.H"), '#include "base.H"\n')
+        self._write(os.path.join(include_dir, "base.H"), 'class base { TypeName("base"); };\n')
+        self._write(os.path.join(include_dir, "plain.H"), 'class plain {};\n')
+        self.args = [f"-I{include_dir}"]
+        self.db = EntityDatabase(os.path.join(self.temp_dir, "docs.db"))
+        self.config = Config()
+
+    def tearDown(self):
+        self.db.close()
+        shutil.rmtree(self.temp_dir)
+
+    def _write(self, path, content):
+        with open(path, 'w') as f:
+            f.write(content)
+
+    def _parser(self):
+        parser = ClangParser(db=self.db, config=self.config, disable_plugins=True)
+        # Plugins wanting TypeName calls indexed
+        parser.disable_plugins = False
+        parser.plugin_manager = MagicMock()
+        parser.plugin_manager.macro_names.return_value = {"TypeName"}
+        return parser
+
+    def test_record_only_for_macro_users(self):
+        """The processing record is requested when included project headers call plugin macros"""
+        user = os.path.join(self.temp_dir, "user.C")
+        self._write(user, '#include "model.H"\n')
+        other = os.path.join(self.temp_dir, "other.C")
+        self._write(other, '#include <plain.H>\n#include <vector>\n')
+        parser = self._parser()
+        record = TranslationUnit.PARSE_DETAILED_PROCESSING_RECORD
+        self.assertTrue(parser.select_tu_options(user, self.args) & record)
+        self.assertFalse(parser.select_tu_options(other, self.args) & record)
+        self.assertFalse(parser.select_tu_options(user, []) & record)
+
+        # Headers under prefixes_to_skip are not scanned
+        OmegaConf.update(self.config.config, "parser.prefixes_to_skip", [self.args[0][2:]])
+        self.assertFalse(parser.select_tu_options(user, self.args) & record)
+
+        OmegaConf.update(self.config.config, "parser.tu_options.adaptive", False)
+        self.assertEqual(self._parser().select_tu_options(other, self.args), parser.tu_options)
+
+    def test_skip_function_bodies(self):
+        """Function bodies are skipped on request and the options are recorded per file"""
+        OmegaConf.update(self.config.config, "parser.tu_options.function_bodies", False)
+        source = os.path.join(self.temp_dir, "a.C")
+        self._write(source, "void f() { auto g = [](auto x) { return x; }; }\n")
+        parser = ClangParser(db=self.db, config=self.config, disable_plugins=True,
+                             use_tree_sitter_fallback=False)
+        entities = parser.parse_file(source)
+        self.assertEqual([entity.name for entity in entities], ["f"])
+        self.assertNotIn('lambda_expressions', entities[0].cpp_features)
+        options = self.db.get_file_tu_options(source)
+        self.assertTrue(options & TranslationUnit.PARSE_SKIP_FUNCTION_BODIES)
+        self.assertFalse(options & TranslationUnit.PARSE_DETAILED_PROCESSING_RECORD)
+
+
+if __name__ == '__main__':
+    unittest.main()
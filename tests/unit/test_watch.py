@@ -0,0 +1,142 @@
+#!/usr/bin/env python3
+
+import unittest
+import sys
+import os
+import shutil
+import tempfile
+from pathlib import Path
+sys.path.append(str(Path(__file__).parent.parent.parent / "src"))
+from foamcd.logs import setup_logging
+
+logger = setup_logging(verbose=True).getChild('test.watch')
+
+from omegaconf import OmegaConf
+from foamcd.config import Config
+from foamcd.db import EntityDatabase
+from foamcd.parse import ClangParser, LIBCLANG_CONFIGURED
+from foamcd.markdown import MarkdownGenerator
+from foamcd.watch import PollingWatcher, WatchSession, wait_for_changes
+
+test_config_path = str(Path(__file__).parent.parent / "test_config.yaml")
+
+
+class TestPollingWatcher(unittest.TestCase):
+    """Test cases for picking up changed sources without inotify"""
+
+    def setUp(self):
+        self.temp_dir = tempfile.mkdtemp()
+
+    def tearDown(self):
+        shutil.rmtree(self.temp_dir)
+
+    def test_changes(self):
+        """Written and removed sources are reported once, other files not at all"""
+        header = os.path.join(self.temp_dir, "a.H")
+        with open(header, 'w') as f:
+            f.write("class A {};\n")
+        watcher = PollingWatcher(interval=0.01)
+        watcher.add(self.temp_dir)
+        self.assertEqual(watcher.read(0), set())
+
+        with open(header, 'a') as f:
+            f.write("class B {};\n")
+        with open(os.path.join(self.temp_dir, "a.H.swp"), 'w') as f:
+            f.write("swap")
+        self.assertEqual(wait_for_changes(watcher, 0.01), {os.path.realpath(header)})
+        os.remove(header)
+        self.assertEqual(watcher.read(0), {header})
+
+
+@unittest.skipIf(not LIBCLANG_CONFIGURED, "libclang is not configured")
+class TestWatchSession(unittest.TestCase):
+    """Test cases for incremental reparse and targeted page regeneration"""
+
+    def setUp(self):
+        # Looking up the git remote of the pages' sources may leave the process in their directory
+        self.cwd = os.getcwd()
+        self.temp_dir = os.path.realpath(tempfile.mkdtemp())
+        self.sources = {
+            'base.H': "namespace Foam {\n/** Base class */\nclass base\n{\npublic:\n    int value() const;\n};\n}\n",
+            'derived.H': '#include "base.H"\nnamespace Foam {\n/** Derived class */\nclass derived\n'
+                         ': public base\n{\n};\n}\n',
+            'other.H': "namespace Foam {\n/** Unrelated class */\nclass other\n{\n};\n}\n",
+            'base.C': '#include "base.H"\n',
+            'derived.C': '#include "derived.H"\n',
+            'other.C': '#include "other.H"\n',
+        }
+        for name, text in self.sources.items():
+            with open(self.path(name), 'w') as f:
+                f.write(text)
+        self.config = Config(test_config_path)
+        OmegaConf.update(self.config.config, "parser.target_files",
+                         [self.path(name) for name in ['base.C', 'derived.C', 'other.C']])
+        OmegaConf.update(self.config.config, "parser.plugins.enabled", False)
+        self.db_path = self.path("docs.db")
+        self.output_path = self.path("docs")
+
+        db = EntityDatabase(self.db_path)
+        parser = ClangParser(db=db, config=self.config, disable_plugins=True, use_tree_sitter_fallback=False)
+        for filepath in self.config.get('parser.target_files'):
+            parser.parse_file(filepath)
+        parser.resolve_inheritance_relationships()
+        db.close()
+        MarkdownGenerator(self.db_path, self.output_path, self.temp_dir, config_object=self.config).generate_all()
+
+    def tearDown(self):
+        os.chdir(self.cwd)
+        shutil.rmtree(self.temp_dir)
+
+    def path(self, name: str) -> str:
+        return os.path.join(self.temp_dir, name)
+
+    def page_times(self):
+        return {name: os.stat(os.path.join(self.output_path, name)).st_mtime_ns
+                for name in os.listdir(self.output_path) if name.startswith('Foam_')}
+
+    def test_affected_translation_units(self):
+        """Changed files and the translation units including them are reparsed"""
+        session = WatchSession(self.config, self.db_path, self.output_path, self.temp_dir)
+        try:
+            self.assertEqual(session.affected_translation_units({self.path('base.H')}),
+                             [self.path('base.C'), self.path('derived.C')])
+            self.assertEqual(session.affected_translation_units({self.path('other.C')}), [self.path('other.C')])
+            self.assertEqual(session.affected_translation_units({self.path('unknown.H')}), [])
+            self.assertIn(self.temp_dir, session.watched_directories())
+        finally:
+            session.close()
+
+    def test_targeted_regeneration(self):
+        """Pages of changed classes and of classes deriving from them are regenerated, no others"""
+        pages = self.page_times()
+        self.assertEqual(sorted(pages), ['Foam_base.md', 'Foam_derived.md', 'Foam_other.md'])
+        with open(self.path('base.H'), 'w') as f:
+            f.write(self.sources['base.H'].replace("int value() const;", "int value() const;\n    int added() const;"))
+
+        session = WatchSession(self.config, self.db_path, self.output_path, self.temp_dir)
+        try:
+            result = session.update({self.path('base.H')})
+            self.assertEqual(result['translation_units'], 2)
+            self.assertEqual(result['changed_classes'], 1)
+            self.assertEqual(result['pages'], 2)
+            after = self.page_times()
+            self.assertNotEqual(after['Foam_base.md'], pages['Foam_base.md'])
+            self.assertNotEqual(after['Foam_derived.md'], pages['Foam_derived.md'])
+            self.assertEqual(after['Foam_other.md'], pages['Foam_other.md'])
+
+            # Saving a file without changing what is documented regenerates nothing
+            with open(self.path('other.C'), 'a') as f:
+                f.write("// comment\n")
+            self.assertEqual(session.update({self.path('other.C')})['pages'], 0)
+
+            # Removed classes lose their page
+            with open(self.path('other.H'), 'w') as f:
+                f.write("namespace Foam {}\n")
+            session.update({self.path('other.H')})
+            self.assertNotIn('Foam_other.md', self.page_times())
+        finally:
+            session.close()
+
+
+if __name__ == '__main__':
+    unittest.main()